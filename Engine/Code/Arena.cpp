@@ -0,0 +1,225 @@
+#include "Arena.h"
+
+#include <mutex>
+#include <algorithm>
+
+static std::mutex threadArenasMutex;
+static std::vector<Arena*> threadArenas;
+
+//Deletes the arena when its thread ends
+struct ThreadArena
+{
+	~ThreadArena();
+
+	Arena* arena = nullptr;
+};
+
+static thread_local ThreadArena threadArena;
+
+
+Arena::Arena(u32 blockSize) : blockSize(blockSize)
+{
+	reservedBytes = 0;
+	highWaterMark = 0;
+	overflowCount = 0;
+
+	current = CreateBlock(blockSize, nullptr);
+}
+
+
+Arena::~Arena()
+{
+	while (current != nullptr)
+	{
+		ArenaBlock* previous = current->previous;
+		FreeBlock(current);
+		current = previous;
+	}
+}
+
+
+void* Arena::Push(u32 size, u32 alignment)
+{
+	ASSERT(alignment != 0 && (alignment & (alignment - 1)) == 0, "The alignment must be a power of 2");
+
+	u32 alignedHead = Align(current->head, alignment);
+
+	if (alignedHead + size > current->size)
+	{
+		//Big allocations get a block of their own size
+		current = CreateBlock(glm::max(blockSize, size + alignment), current);
+		alignedHead = Align(current->head, alignment);
+
+		overflowCount++;
+	}
+
+	void* ptr = current->memory + alignedHead;
+	current->head = alignedHead + size;
+
+	u64 usedBytes = GetUsedBytes();
+	if (usedBytes > highWaterMark)
+		highWaterMark = usedBytes;
+
+	return ptr;
+}
+
+
+void* Arena::PushCopy(const void* data, u32 size)
+{
+	void* ptr = Push(size);
+	memcpy(ptr, data, size);
+
+	return ptr;
+}
+
+
+ArenaMarker Arena::GetMarker() const
+{
+	return { current, current->head };
+}
+
+
+void Arena::Rewind(ArenaMarker marker)
+{
+	while (current != marker.block)
+	{
+		ASSERT(current->previous != nullptr, "The marker doesn't belong to this arena or was already rewound");
+
+		ArenaBlock* previous = current->previous;
+		FreeBlock(current);
+		current = previous;
+	}
+
+	current->head = marker.head;
+}
+
+
+void Arena::Reset()
+{
+	ArenaBlock* first = current;
+	while (first->previous != nullptr)
+		first = first->previous;
+
+	Rewind({ first, 0 });
+
+	//Grow to the peak so the next frames fit in a single block
+	u64 peak = highWaterMark;
+	if (peak > current->size)
+	{
+		blockSize = (u32)glm::min(peak + peak / 4, (u64)UINT32_MAX);
+
+		FreeBlock(current);
+		current = CreateBlock(blockSize, nullptr);
+	}
+}
+
+
+u64 Arena::GetUsedBytes() const
+{
+	return current->baseOffset + current->head;
+}
+
+
+u64 Arena::GetReservedBytes() const
+{
+	return reservedBytes;
+}
+
+
+u64 Arena::GetHighWaterMark() const
+{
+	return highWaterMark;
+}
+
+
+u32 Arena::GetOverflowCount() const
+{
+	return overflowCount;
+}
+
+
+ArenaBlock* Arena::CreateBlock(u32 size, ArenaBlock* previous)
+{
+	ArenaBlock* block = new ArenaBlock;
+	block->memory = (u8*)malloc(size);
+	block->size = size;
+	block->head = 0;
+	block->baseOffset = previous != nullptr ? previous->baseOffset + previous->head : 0;
+	block->previous = previous;
+
+	reservedBytes += size;
+
+	return block;
+}
+
+
+void Arena::FreeBlock(ArenaBlock* block)
+{
+	reservedBytes -= block->size;
+
+	free(block->memory);
+	delete block;
+}
+
+
+ArenaScope::ArenaScope(Arena& arena) : arena(arena), marker(arena.GetMarker())
+{
+}
+
+
+ArenaScope::~ArenaScope()
+{
+	arena.Rewind(marker);
+}
+
+
+ThreadArena::~ThreadArena()
+{
+	if (arena == nullptr)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(threadArenasMutex);
+		threadArenas.erase(std::find(threadArenas.begin(), threadArenas.end(), arena));
+	}
+
+	delete arena;
+}
+
+
+void InitThreadArena(u32 blockSize)
+{
+	ASSERT(threadArena.arena == nullptr, "The arena of this thread is already in use");
+
+	threadArena.arena = new Arena(blockSize);
+
+	std::unique_lock<std::mutex> lock(threadArenasMutex);
+	threadArenas.push_back(threadArena.arena);
+}
+
+
+Arena& GetThreadArena()
+{
+	if (threadArena.arena == nullptr)
+		InitThreadArena(ARENA_DEFAULT_BLOCK_SIZE);
+
+	return *threadArena.arena;
+}
+
+
+ArenaStats GetArenaStats()
+{
+	ArenaStats stats = {};
+
+	std::unique_lock<std::mutex> lock(threadArenasMutex);
+
+	for (int i = 0; i < threadArenas.size(); ++i)
+	{
+		stats.arenaCount++;
+		stats.reservedBytes += threadArenas[i]->GetReservedBytes();
+		stats.highWaterMark = glm::max(stats.highWaterMark, threadArenas[i]->GetHighWaterMark());
+		stats.overflowCount += threadArenas[i]->GetOverflowCount();
+	}
+
+	return stats;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "platform.h"
+
+#include <atomic>
+
+#define ARENA_DEFAULT_BLOCK_SIZE MB(1)
+#define GLOBAL_FRAME_ARENA_SIZE MB(16)		//Block size of the main thread arena
+
+//Chunk of an arena, new ones are chained when the current one is full
+struct ArenaBlock
+{
+	u8* memory;
+	u32 size;
+	u32 head;
+
+	u64 baseOffset;			//Bytes used in the previous blocks when this one was chained
+	ArenaBlock* previous;
+};
+
+
+//Position of an arena to rewind to, everything pushed after it is released at once
+struct ArenaMarker
+{
+	ArenaBlock* block;
+	u32 head;
+};
+
+
+//Bump allocator. It is not thread safe, every thread gets its own with GetThreadArena().
+//Pushing more than a block holds chains a new block instead of failing. Reset() merges them back into
+//one block as big as the peak usage, so a frame only chains the first time it needs more memory.
+class Arena
+{
+public:
+	Arena(u32 blockSize = ARENA_DEFAULT_BLOCK_SIZE);
+	~Arena();
+
+	void* Push(u32 size, u32 alignment = 1);
+	void* PushCopy(const void* data, u32 size);
+
+	template<typename T>
+	T* PushArray(u32 count)
+	{
+		return (T*)Push(sizeof(T) * count, alignof(T));
+	}
+
+	ArenaMarker GetMarker() const;
+	void Rewind(ArenaMarker marker);
+
+	//Releases everything, only when nothing pushed is in use anymore (end of the frame)
+	void Reset();
+
+	u64 GetUsedBytes() const;
+
+	//Safe to call from other threads
+	u64 GetReservedBytes() const;
+	u64 GetHighWaterMark() const;
+	u32 GetOverflowCount() const;
+
+private:
+	ArenaBlock* CreateBlock(u32 size, ArenaBlock* previous);
+	void FreeBlock(ArenaBlock* block);
+
+private:
+	ArenaBlock* current = nullptr;
+	u32 blockSize;
+
+	//Read by the gui from the main thread
+	std::atomic<u64> reservedBytes;
+	std::atomic<u64> highWaterMark;
+	std::atomic<u32> overflowCount;		//Blocks chained since the arena was created
+};
+
+
+//Rewinds the arena to where it was when the scope started
+class ArenaScope
+{
+public:
+	ArenaScope(Arena& arena);
+	~ArenaScope();
+
+private:
+	Arena& arena;
+	ArenaMarker marker;
+};
+
+
+struct ArenaStats
+{
+	u32 arenaCount;
+	u64 reservedBytes;
+	u64 highWaterMark;		//Highest of all the threads
+	u32 overflowCount;
+};
+
+
+//Frame arena of the calling thread, created the first time it is used
+Arena& GetThreadArena();
+
+//Creates the arena of the calling thread with a different block size, must be called before its first use
+void InitThreadArena(u32 blockSize);
+
+ArenaStats GetArenaStats();
@@ -0,0 +1,181 @@
+#include "AutoExposure.h"
+
+#include "engine.h"
+#include "GpuProfiler.h"
+#include "GpuMemory.h"
+
+AutoExposure::AutoExposure(App* app)
+{
+	histogramProgramIdx = CreateComputeProgram(app, "LuminanceHistogram.glsl", "LUMINANCE_HISTOGRAM");
+	averageProgramIdx = CreateComputeProgram(app, "LuminanceHistogram.glsl", "EXPOSURE_AVERAGE");
+
+	InitBuffers();
+}
+
+
+AutoExposure::~AutoExposure()
+{
+	GetGpuMemory().ReleaseBuffer(histogramBuffer);
+	GetGpuMemory().ReleaseBuffer(exposureBuffer);
+
+	for (int i = 0; i < EXPOSURE_READBACK_RING_SIZE; ++i)
+		GetGpuMemory().ReleaseBuffer(readbackBuffers[i]);
+
+	glDeleteBuffers(1, &histogramBuffer);
+	glDeleteBuffers(1, &exposureBuffer);
+	glDeleteBuffers(EXPOSURE_READBACK_RING_SIZE, readbackBuffers);
+
+	for (int i = 0; i < EXPOSURE_READBACK_RING_SIZE; ++i)
+	{
+		if (readbackFences[i] != 0)
+			glDeleteSync(readbackFences[i]);
+	}
+}
+
+
+void AutoExposure::Compute(App* app)
+{
+	if (enabled == false)
+		return;
+
+	GPU_PROFILE_SCOPE(app, "AutoExposure");
+
+	ReadExposure();
+
+	BuildHistogram(app);
+	AverageHistogram(app);
+
+	RequestExposure();
+}
+
+
+void AutoExposure::BindExposure(const Program& program)
+{
+	float exposureScale = enabled ? exp2(exposureCompensation) : manualExposure;
+
+	glUniform1f(glGetUniformLocation(program.handle, "uExposure"), exposureScale);
+	glUniform1f(glGetUniformLocation(program.handle, "uWhitePoint"), whitePoint);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(1), exposureBuffer);
+}
+
+
+void AutoExposure::InitBuffers()
+{
+	//The histogram is cleared by the average pass, so it only needs to start at zero
+	u32 zeroBins[EXPOSURE_HISTOGRAM_BINS] = {};
+
+	glGenBuffers(1, &histogramBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, histogramBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zeroBins), zeroBins, GL_DYNAMIC_COPY);
+	GetGpuMemory().TrackBuffer(histogramBuffer, GPU_MEMORY_CATEGORY::STORAGE, "Exposure histogram", sizeof(zeroBins));
+
+	ExposureData initialData = { keyValue, 1.f };
+
+	glGenBuffers(1, &exposureBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, exposureBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ExposureData), &initialData, GL_DYNAMIC_COPY);
+	GetGpuMemory().TrackBuffer(exposureBuffer, GPU_MEMORY_CATEGORY::STORAGE, "Exposure", sizeof(ExposureData));
+
+	glGenBuffers(EXPOSURE_READBACK_RING_SIZE, readbackBuffers);
+	for (int i = 0; i < EXPOSURE_READBACK_RING_SIZE; ++i)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffers[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(ExposureData), NULL, GL_STREAM_READ);
+		GetGpuMemory().TrackBuffer(readbackBuffers[i], GPU_MEMORY_CATEGORY::READBACK, "Exposure readback", sizeof(ExposureData));
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+void AutoExposure::BuildHistogram(App* app)
+{
+	Program& program = app->programs[histogramProgramIdx];
+	glUseProgram(program.handle);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[3].handle);
+	glUniform1i(glGetUniformLocation(program.handle, "colorMap"), 0);
+
+	glUniform2i(glGetUniformLocation(program.handle, "uSourceSize"), app->renderSize.x, app->renderSize.y);
+	glUniform1f(glGetUniformLocation(program.handle, "uMinLogLuminance"), minLogLuminance);
+	glUniform1f(glGetUniformLocation(program.handle, "uInverseLogLuminanceRange"), 1.f / glm::max(maxLogLuminance - minLogLuminance, 0.001f));
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(0), histogramBuffer);
+
+	glDispatchCompute((app->renderSize.x + EXPOSURE_GROUP_SIZE - 1) / EXPOSURE_GROUP_SIZE, (app->renderSize.y + EXPOSURE_GROUP_SIZE - 1) / EXPOSURE_GROUP_SIZE, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(0), 0);
+}
+
+
+void AutoExposure::AverageHistogram(App* app)
+{
+	Program& program = app->programs[averageProgramIdx];
+	glUseProgram(program.handle);
+
+	glUniform1ui(glGetUniformLocation(program.handle, "uPixelCount"), app->renderSize.x * app->renderSize.y);
+	glUniform1f(glGetUniformLocation(program.handle, "uMinLogLuminance"), minLogLuminance);
+	glUniform1f(glGetUniformLocation(program.handle, "uLogLuminanceRange"), glm::max(maxLogLuminance - minLogLuminance, 0.001f));
+	glUniform1f(glGetUniformLocation(program.handle, "uAdaptation"), 1.f - exp(-app->deltaTime * adaptationSpeed));
+	glUniform1f(glGetUniformLocation(program.handle, "uKeyValue"), keyValue);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(0), histogramBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(1), exposureBuffer);
+
+	glDispatchCompute(1, 1, 1);
+
+	//Read by the composition and copied for the readback
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(0), 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(1), 0);
+}
+
+
+void AutoExposure::RequestExposure()
+{
+	//Drop the oldest request if the gpu is that far behind
+	if (readbackFences[readbackWriteIdx] != 0)
+		glDeleteSync(readbackFences[readbackWriteIdx]);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, exposureBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuffers[readbackWriteIdx]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(ExposureData));
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	readbackFences[readbackWriteIdx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readbackWriteIdx = (readbackWriteIdx + 1) % EXPOSURE_READBACK_RING_SIZE;
+}
+
+
+void AutoExposure::ReadExposure()
+{
+	//Oldest request first, so the newest finished one ends up in the values
+	for (int i = 0; i < EXPOSURE_READBACK_RING_SIZE; ++i)
+	{
+		u32 idx = (readbackWriteIdx + i) % EXPOSURE_READBACK_RING_SIZE;
+
+		if (readbackFences[idx] == 0)
+			continue;
+
+		GLenum status = glClientWaitSync(readbackFences[idx], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue;
+
+		ExposureData data;
+		glBindBuffer(GL_COPY_READ_BUFFER, readbackBuffers[idx]);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(data), &data);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		averageLuminance = data.averageLuminance;
+		exposure = data.exposure;
+
+		glDeleteSync(readbackFences[idx]);
+		readbackFences[idx] = 0;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ModelStructures.h"
+#include "ShaderLayout.h"
+#include "glad/glad.h"
+
+#define EXPOSURE_HISTOGRAM_BINS 256
+#define EXPOSURE_READBACK_RING_SIZE 3
+#define EXPOSURE_GROUP_SIZE 16
+
+struct App;
+
+enum class TONEMAP_OPERATOR : int
+{
+	NONE = 0,
+	REINHARD,
+	ACES,
+	UNCHARTED2,
+	MAX
+};
+
+
+//Gpu side exposure state, must match LuminanceHistogram.glsl and Composite.glsl
+struct ExposureData
+{
+	float averageLuminance;
+	float exposure;
+};
+
+SHADER_ASSERT_OFFSET(ExposureData, exposure, 4);
+SHADER_ASSERT_SIZE(ExposureData, 8);
+
+
+//Histogram based auto exposure:
+// - A compute pass builds a log luminance histogram of the lit scene with shared memory atomics.
+// - A second pass reduces it to the average luminance and adapts it over time.
+//The exposure never leaves the gpu to be applied, the value shown on the gui is read back some frames later.
+struct AutoExposure
+{
+public:
+	AutoExposure(App* app);
+	~AutoExposure();
+
+	//Needs the light pass done
+	void Compute(App* app);
+
+	//Sets the exposure of the final composition, the tonemap operator is compiled into it
+	void BindExposure(const Program& program);
+
+private:
+	void InitBuffers();
+
+	void BuildHistogram(App* app);
+	void AverageHistogram(App* app);
+
+	void RequestExposure();
+	void ReadExposure();
+
+public:
+	bool enabled = false;
+
+	float minLogLuminance = -10.f;
+	float maxLogLuminance = 2.f;
+	float adaptationSpeed = 1.5f;
+	float keyValue = 0.18f;
+	float exposureCompensation = 0.f;	//EV
+
+	float manualExposure = 1.f;			//Used while auto exposure is disabled
+
+	TONEMAP_OPERATOR tonemapOperator = TONEMAP_OPERATOR::NONE;
+	float whitePoint = 11.2f;
+
+	//Last values received from the gpu, they are some frames old
+	float averageLuminance = 0.f;
+	float exposure = 1.f;
+
+private:
+	u32 histogramProgramIdx;
+	u32 averageProgramIdx;
+
+	u32 histogramBuffer = 0;
+	u32 exposureBuffer = 0;
+
+	u32 readbackBuffers[EXPOSURE_READBACK_RING_SIZE] = {};
+	GLsync readbackFences[EXPOSURE_READBACK_RING_SIZE] = {};
+	u32 readbackWriteIdx = 0;
+};
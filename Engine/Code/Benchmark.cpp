@@ -0,0 +1,615 @@
+#include "Benchmark.h"
+
+#include "engine.h"
+#include "Arena.h"
+#include "OcclusionCulling.h"
+#include "TemporalAA.h"
+#include "AutoExposure.h"
+#include "DynamicResolution.h"
+#include "ProgramCache.h"
+#include "GpuMemory.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "StressScene.h"
+#include "JobSystem.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <sstream>
+
+//Samples of one gpu pass over the measured frames
+struct BenchmarkPass
+{
+	const char* name;
+	u32 depth;
+	u64 lastTotalSamples;
+	std::vector<float> samples;
+};
+
+
+//Measures of the frames rendered with one value of the sweep, or of the whole benchmark without one
+struct BenchmarkRun
+{
+	u32 sweepValue = 0;
+	u32 entityCount = 0;
+	u32 lightCount = 0;
+
+	std::vector<float> frameTimes;		//Milliseconds, waiting for the gpu
+	std::vector<float> cpuTimes;		//Until the frame is submitted
+	std::vector<BenchmarkPass> passes;
+
+	double visibleSum = 0.0;
+	double occludedSum = 0.0;
+	double frustumCulledSum = 0.0;
+	double softwareCulledSum = 0.0;
+
+	u64 gpuMemoryBytes = 0;
+	u64 gpuMemoryPeak = 0;
+};
+
+
+static bool ParseBool(std::istringstream& stream, bool& value)
+{
+	int number = 0;
+	stream >> number;
+	value = number != 0;
+
+	return stream.fail() == false;
+}
+
+
+static bool ParseCount(std::istringstream& stream, u32& value)
+{
+	stream >> value;
+	return stream.fail() == false;
+}
+
+
+//Stress scene setting a sweep changes, null if there isn't one with that name
+static u32* GetSweepValue(StressSceneSettings& settings, const std::string& parameter)
+{
+	if (parameter == "entities")
+		return &settings.entityCount;
+	else if (parameter == "models")
+		return &settings.modelCount;
+	else if (parameter == "materials")
+		return &settings.materialCount;
+	else if (parameter == "lights")
+		return &settings.lightCount;
+
+	return nullptr;
+}
+
+
+bool LoadBenchmarkSettings(const char* path, BenchmarkSettings& settings)
+{
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed reading benchmark settings %s", path);
+		return false;
+	}
+
+	fclose(file);
+
+	String text = ReadTextFile(path);
+	std::istringstream stream(std::string(text.str, text.len));
+
+	std::string line;
+	u32 lineNumber = 0;
+	bool valid = true;
+
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		std::istringstream lineStream(line);
+		std::string name;
+		lineStream >> name;
+
+		bool parsed = true;
+
+		if (name == "resolution")
+		{
+			lineStream >> settings.resolution.x >> settings.resolution.y;
+			parsed = lineStream.fail() == false && settings.resolution.x > 0 && settings.resolution.y > 0;
+		}
+
+		else if (name == "frames")
+		{
+			lineStream >> settings.frameCount;
+			parsed = lineStream.fail() == false && settings.frameCount > 0;
+		}
+
+		else if (name == "warmup")
+		{
+			lineStream >> settings.warmupFrames;
+			parsed = lineStream.fail() == false;
+		}
+
+		else if (name == "mode")
+		{
+			std::string mode;
+			lineStream >> mode;
+
+			parsed = mode == "deferred" || mode == "forward";
+			settings.forwardRendering = mode == "forward";
+		}
+
+		else if (name == "context")
+		{
+			std::string context;
+			lineStream >> context;
+
+			if (context == "native")
+				settings.context = BENCHMARK_CONTEXT::NATIVE;
+			else if (context == "egl")
+				settings.context = BENCHMARK_CONTEXT::EGL;
+			else if (context == "osmesa")
+				settings.context = BENCHMARK_CONTEXT::OSMESA;
+			else
+				parsed = false;
+		}
+
+		else if (name == "output")
+		{
+			lineStream >> settings.outputPath;
+			parsed = lineStream.fail() == false;
+		}
+
+		else if (name == "bloom")
+			parsed = ParseBool(lineStream, settings.bloom);
+
+		else if (name == "temporalAA")
+			parsed = ParseBool(lineStream, settings.temporalAA);
+
+		else if (name == "autoExposure")
+			parsed = ParseBool(lineStream, settings.autoExposure);
+
+		else if (name == "occlusionCulling")
+			parsed = ParseBool(lineStream, settings.occlusionCulling);
+
+		else if (name == "softwareOcclusion")
+			parsed = ParseBool(lineStream, settings.softwareOcclusion);
+
+		else if (name == "cameraPath")
+		{
+			lineStream >> settings.cameraPathFile;
+			parsed = lineStream.fail() == false;
+		}
+
+		else if (name == "scene")
+		{
+			std::string scene;
+			lineStream >> scene;
+
+			parsed = scene == "default" || scene == "stress";
+			settings.stressScene = scene == "stress";
+		}
+
+		else if (name == "entities")
+			parsed = ParseCount(lineStream, settings.stress.entityCount);
+
+		else if (name == "models")
+			parsed = ParseCount(lineStream, settings.stress.modelCount);
+
+		else if (name == "materials")
+			parsed = ParseCount(lineStream, settings.stress.materialCount);
+
+		else if (name == "lights")
+			parsed = ParseCount(lineStream, settings.stress.lightCount) && settings.stress.lightCount <= GLOBAL_PARAMS_MAX_LIGHTS;
+
+		else if (name == "seed")
+			parsed = ParseCount(lineStream, settings.stress.seed);
+
+		else if (name == "clusters")
+			parsed = ParseCount(lineStream, settings.stress.clusterCount);
+
+		else if (name == "spacing")
+		{
+			lineStream >> settings.stress.spacing;
+			parsed = lineStream.fail() == false && settings.stress.spacing > 0.f;
+		}
+
+		else if (name == "layout")
+		{
+			std::string layout;
+			lineStream >> layout;
+
+			if (layout == "grid")
+				settings.stress.layout = STRESS_LAYOUT::GRID;
+			else if (layout == "random")
+				settings.stress.layout = STRESS_LAYOUT::RANDOM;
+			else if (layout == "clustered")
+				settings.stress.layout = STRESS_LAYOUT::CLUSTERED;
+			else
+				parsed = false;
+		}
+
+		else if (name == "sweep")
+		{
+			lineStream >> settings.sweepParameter;
+			parsed = GetSweepValue(settings.stress, settings.sweepParameter) != nullptr;
+
+			settings.sweepValues.clear();
+
+			//Only the first GLOBAL_PARAMS_MAX_LIGHTS are shaded, more would measure the same frame
+			u32 maxValue = settings.sweepParameter == "lights" ? GLOBAL_PARAMS_MAX_LIGHTS : UINT32_MAX;
+
+			u32 value;
+			while (lineStream >> value)
+			{
+				settings.sweepValues.push_back(value);
+				parsed = parsed && value <= maxValue;
+			}
+
+			parsed = parsed && settings.sweepValues.empty() == false && lineStream.eof() == true;
+		}
+
+		else if (name == "keyframe")
+		{
+			std::string keyframe;
+			std::getline(lineStream, keyframe);
+			parsed = settings.cameraPath.ParseKeyframe(keyframe);
+		}
+
+		else
+		{
+			ELOG("Unknown benchmark setting %s in line %u of %s", name.c_str(), lineNumber, path);
+			valid = false;
+			continue;
+		}
+
+		if (parsed == false)
+		{
+			ELOG("Invalid value for %s in line %u of %s", name.c_str(), lineNumber, path);
+			valid = false;
+		}
+	}
+
+	if (settings.sweepValues.empty() == false && settings.stressScene == false)
+	{
+		ELOG("The sweep of %s needs the stress scene", path);
+		valid = false;
+	}
+
+	//A recorded path replaces the keyframes of the settings
+	if (settings.cameraPathFile.empty() == false && settings.cameraPath.Load(settings.cameraPathFile.c_str()) == false)
+		valid = false;
+
+	return valid;
+}
+
+
+//p between 0 and 1, the values must be sorted
+static float GetSortedPercentile(const std::vector<float>& values, float p)
+{
+	if (values.empty() == true)
+		return 0.f;
+
+	u32 idx = (u32)glm::round(p * (values.size() - 1));
+	return values[idx];
+}
+
+
+static float GetAverage(const std::vector<float>& values)
+{
+	if (values.empty() == true)
+		return 0.f;
+
+	double sum = 0.0;
+	for (float value : values)
+		sum += value;
+
+	return sum / values.size();
+}
+
+
+static void WriteTimes(FILE* file, std::vector<float>& values)
+{
+	std::sort(values.begin(), values.end());
+
+	fprintf(file, "{ \"average\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+		GetAverage(values), values.empty() ? 0.f : values.front(), GetSortedPercentile(values, 0.5f), GetSortedPercentile(values, 0.95f),
+		GetSortedPercentile(values, 0.99f), values.empty() ? 0.f : values.back());
+}
+
+
+static const char* GetContextName(BENCHMARK_CONTEXT context)
+{
+	switch (context)
+	{
+	case BENCHMARK_CONTEXT::NATIVE: return "native";
+	case BENCHMARK_CONTEXT::EGL: return "egl";
+	case BENCHMARK_CONTEXT::OSMESA: return "osmesa";
+	case BENCHMARK_CONTEXT::MAX: break;
+	}
+
+	return "unknown";
+}
+
+
+static void RunBenchmarkFrames(App& app, const BenchmarkSettings& settings, BenchmarkRun& run)
+{
+	u32 measuredFrames = settings.frameCount - glm::min(settings.warmupFrames, settings.frameCount);
+	run.frameTimes.reserve(measuredFrames);
+	run.cpuTimes.reserve(measuredFrames);
+
+	//Only the samples read from now on belong to this run
+	for (const GpuPassStats& stats : app.gpuProfiler->GetPassStats())
+		run.passes.push_back({ stats.name, stats.depth, stats.totalSamples, {} });
+
+	//The gpu results of a frame are read GPU_PROFILER_FRAME_COUNT frames later, the last ones with empty frames
+	u32 totalFrames = settings.frameCount + GPU_PROFILER_FRAME_COUNT;
+
+	for (u32 frame = 0; frame < totalFrames; ++frame)
+	{
+		bool rendered = frame < settings.frameCount;
+		u64 frameStart = GetProfilerTime();
+
+		app.gpuProfiler->BeginFrame();
+
+		//BeginFrame read the results of this frame
+		i64 readFrame = (i64)frame - GPU_PROFILER_FRAME_COUNT;
+		for (const GpuPassStats& stats : app.gpuProfiler->GetPassStats())
+		{
+			BenchmarkPass* pass = nullptr;
+			for (BenchmarkPass& candidate : run.passes)
+			{
+				if (strcmp(candidate.name, stats.name) == 0)
+				{
+					pass = &candidate;
+					break;
+				}
+			}
+
+			if (pass == nullptr)
+			{
+				run.passes.push_back({ stats.name, stats.depth, 0, {} });
+				pass = &run.passes.back();
+			}
+
+			if (stats.totalSamples != pass->lastTotalSamples && readFrame >= (i64)settings.warmupFrames && readFrame < (i64)settings.frameCount)
+				pass->samples.push_back(stats.last);
+
+			pass->lastTotalSamples = stats.totalSamples;
+		}
+
+		if (rendered == true)
+		{
+			//Time from the frame index instead of the clock, so every run sees the same views
+			glm::vec3 position = app.camera.GetPositionV3();
+			glm::vec3 target = app.camera.GetTargetV3();
+			settings.cameraPath.Evaluate(frame * BENCHMARK_DELTA_TIME, position, target);
+
+			app.camera.SetPosition(position);
+			app.camera.SetTarget(target);
+
+			Update(&app);
+			Render(&app);
+		}
+
+		app.gpuProfiler->EndFrame();
+
+		u64 submitEnd = GetProfilerTime();
+
+		//Nothing overlaps between frames, the wall time is the time of this frame alone
+		glFinish();
+
+		if (rendered == true && frame >= settings.warmupFrames)
+		{
+			run.frameTimes.push_back((GetProfilerTime() - frameStart) / 1000000.0);
+			run.cpuTimes.push_back((submitEnd - frameStart) / 1000000.0);
+
+			run.visibleSum += app.occlusionCulling->visibleCount;
+			run.occludedSum += app.occlusionCulling->occludedCount;
+			run.frustumCulledSum += app.occlusionCulling->frustumCulledCount;
+			run.softwareCulledSum += app.softwareCulledCount;
+		}
+
+		GetThreadArena().Reset();
+	}
+
+	run.entityCount = app.entities.size();
+	run.lightCount = app.lights.size();
+	run.gpuMemoryBytes = GetGpuMemory().totalBytes;
+	run.gpuMemoryPeak = GetGpuMemory().totalPeak;
+}
+
+
+static void WriteBenchmarkRun(FILE* file, const BenchmarkSettings& settings, BenchmarkRun& run)
+{
+	u32 measuredFrames = settings.frameCount - glm::min(settings.warmupFrames, settings.frameCount);
+	double frameDivisor = glm::max(measuredFrames, 1u);
+
+	fprintf(file, "\t\t{\n");
+
+	if (settings.sweepValues.empty() == false)
+		fprintf(file, "\t\t\t\"%s\": %u,\n", settings.sweepParameter.c_str(), run.sweepValue);
+
+	fprintf(file, "\t\t\t\"entities\": %u,\n", run.entityCount);
+	fprintf(file, "\t\t\t\"lights\": %u,\n", run.lightCount);
+
+	fprintf(file, "\t\t\t\"frameTimeMs\": ");
+	WriteTimes(file, run.frameTimes);
+	fprintf(file, ",\n");
+
+	fprintf(file, "\t\t\t\"cpuTimeMs\": ");
+	WriteTimes(file, run.cpuTimes);
+	fprintf(file, ",\n");
+
+	fprintf(file, "\t\t\t\"gpuPasses\": [");
+	for (u32 i = 0; i < run.passes.size(); ++i)
+	{
+		fprintf(file, "%s\n\t\t\t\t{ \"name\": \"%s\", \"depth\": %u, \"samples\": %u, \"timeMs\": ", i == 0 ? "" : ",",
+			run.passes[i].name, run.passes[i].depth, (u32)run.passes[i].samples.size());
+		WriteTimes(file, run.passes[i].samples);
+		fprintf(file, " }");
+	}
+	fprintf(file, "\n\t\t\t],\n");
+
+	fprintf(file, "\t\t\t\"counters\": { \"visibleObjects\": %.1f, \"occludedObjects\": %.1f, \"frustumCulledObjects\": %.1f, \"softwareCulledObjects\": %.1f, ",
+		run.visibleSum / frameDivisor, run.occludedSum / frameDivisor, run.frustumCulledSum / frameDivisor, run.softwareCulledSum / frameDivisor);
+	fprintf(file, "\"gpuMemoryBytes\": %llu, \"gpuMemoryPeakBytes\": %llu }\n",
+		(unsigned long long)run.gpuMemoryBytes, (unsigned long long)run.gpuMemoryPeak);
+
+	fprintf(file, "\t\t}");
+}
+
+
+int RunBenchmark(const char* settingsPath)
+{
+	BenchmarkSettings settings;
+
+	if (LoadBenchmarkSettings(settingsPath, settings) == false)
+		return -1;
+
+	if (!glfwInit())
+	{
+		ELOG("glfwInit() failed\n");
+		return -1;
+	}
+
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	//Nothing is shown, the frames are rendered to the framebuffer of a hidden window
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	switch (settings.context)
+	{
+	case BENCHMARK_CONTEXT::NATIVE: glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API); break;
+	case BENCHMARK_CONTEXT::EGL: glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API); break;
+	case BENCHMARK_CONTEXT::OSMESA: glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API); break;
+	case BENCHMARK_CONTEXT::MAX: ASSERT(false, "Invalid benchmark context"); break;
+	}
+
+	GLFWwindow* window = glfwCreateWindow(settings.resolution.x, settings.resolution.y, "Benchmark", NULL, NULL);
+	if (!window)
+	{
+		ELOG("glfwCreateWindow() failed with the %s context\n", GetContextName(settings.context));
+		glfwTerminate();
+		return -1;
+	}
+
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		ELOG("Failed to initialize OpenGL context\n");
+		glfwTerminate();
+		return -1;
+	}
+
+	InitThreadArena(GLOBAL_FRAME_ARENA_SIZE);
+	InitJobSystem();
+
+	App app = {};
+	app.deltaTime = BENCHMARK_DELTA_TIME;
+	app.displaySize = settings.resolution;
+	app.isRunning = true;
+
+	Init(&app);
+
+	//Same work every run, the dynamic resolution would change it depending on the previous frames
+	app.dynamicResolution->enabled = false;
+	app.mode = settings.forwardRendering ? Mode_Forward : Mode_Deferred;
+	app.applyBloom = settings.bloom;
+	app.temporalAA->enabled = settings.temporalAA;
+	app.autoExposure->enabled = settings.autoExposure;
+	app.occlusionCulling->enabled = settings.occlusionCulling;
+	app.applySoftwareOcclusion = settings.softwareOcclusion;
+
+	std::vector<BenchmarkRun> runs(glm::max((u32)settings.sweepValues.size(), 1u));
+
+	for (u32 i = 0; i < runs.size(); ++i)
+	{
+		if (settings.stressScene == true)
+		{
+			app.stressScene->settings = settings.stress;
+
+			if (settings.sweepValues.empty() == false)
+			{
+				runs[i].sweepValue = settings.sweepValues[i];
+				*GetSweepValue(app.stressScene->settings, settings.sweepParameter) = runs[i].sweepValue;
+			}
+
+			app.stressScene->Generate(&app);
+
+			//Without a path the whole scene is seen from above one side
+			if (settings.cameraPath.GetKeyframeCount() == 0)
+			{
+				float extent = app.stressScene->GetExtent();
+				app.camera.SetPosition(glm::vec3(0.f, extent * 0.75f, extent * 1.5f));
+				app.camera.SetTarget(glm::vec3(0.f));
+			}
+		}
+
+		ILOG("Benchmark: %u frames at %dx%d, %u of warmup, %u entities and %u lights", settings.frameCount, settings.resolution.x,
+			settings.resolution.y, settings.warmupFrames, (u32)app.entities.size(), (u32)app.lights.size());
+
+		RunBenchmarkFrames(app, settings, runs[i]);
+	}
+
+	ArenaStats arenaStats = GetArenaStats();
+
+	FILE* file = fopen(settings.outputPath.c_str(), "w");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing the benchmark result %s", settings.outputPath.c_str());
+	}
+	else
+	{
+		fprintf(file, "{\n");
+		fprintf(file, "\t\"renderer\": \"%s\",\n", app.info.render.c_str());
+		fprintf(file, "\t\"version\": \"%s\",\n", app.info.version.c_str());
+
+		fprintf(file, "\t\"settings\": { \"resolution\": [%d, %d], \"frames\": %u, \"warmup\": %u, \"mode\": \"%s\", \"context\": \"%s\", ",
+			settings.resolution.x, settings.resolution.y, settings.frameCount, settings.warmupFrames,
+			settings.forwardRendering ? "forward" : "deferred", GetContextName(settings.context));
+		fprintf(file, "\"bloom\": %s, \"temporalAA\": %s, \"autoExposure\": %s, \"occlusionCulling\": %s, \"softwareOcclusion\": %s, \"keyframes\": %u },\n",
+			settings.bloom ? "true" : "false", settings.temporalAA ? "true" : "false", settings.autoExposure ? "true" : "false",
+			settings.occlusionCulling ? "true" : "false", settings.softwareOcclusion ? "true" : "false", settings.cameraPath.GetKeyframeCount());
+
+		if (settings.stressScene == true)
+		{
+			const StressSceneSettings& stress = settings.stress;
+			fprintf(file, "\t\"stressScene\": { \"entities\": %u, \"models\": %u, \"materials\": %u, \"lights\": %u, \"layout\": \"%s\", \"seed\": %u, \"spacing\": %.3f, \"clusters\": %u },\n",
+				stress.entityCount, stress.modelCount, stress.materialCount, stress.lightCount, GetStressLayoutName(stress.layout),
+				stress.seed, stress.spacing, stress.clusterCount);
+		}
+
+		if (settings.sweepValues.empty() == false)
+			fprintf(file, "\t\"sweep\": \"%s\",\n", settings.sweepParameter.c_str());
+
+		fprintf(file, "\t\"runs\": [\n");
+		for (u32 i = 0; i < runs.size(); ++i)
+		{
+			WriteBenchmarkRun(file, settings, runs[i]);
+			fprintf(file, "%s\n", i + 1 < runs.size() ? "," : "");
+		}
+		fprintf(file, "\t],\n");
+
+		fprintf(file, "\t\"counters\": { \"programCacheHits\": %u, \"programCacheMisses\": %u, \"arenaHighWaterMark\": %llu, \"gpuDroppedFrames\": %u }\n",
+			app.programCache->hitCount, app.programCache->missCount, (unsigned long long)arenaStats.highWaterMark, app.gpuProfiler->droppedFrames);
+		fprintf(file, "}\n");
+
+		fclose(file);
+		ILOG("Benchmark result written to %s", settings.outputPath.c_str());
+	}
+
+	ShutdownJobSystem();
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+
+	return file != NULL ? 0 : -1;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "platform.h"
+#include "CameraPath.h"
+#include "StressScene.h"
+
+#define BENCHMARK_SETTINGS_FILE "Benchmark.txt"
+#define BENCHMARK_DELTA_TIME (1.f / 60.f)		//Fixed step, every run simulates the same frames
+
+enum class BENCHMARK_CONTEXT : int
+{
+	NATIVE = 0,		//Hidden window with the default context of the platform
+	EGL,
+	OSMESA,			//Mesa software rendering without a display
+	MAX
+};
+
+
+//Read from a text file with one setting per line, "name values", # starts a comment:
+// resolution 1280 720
+// frames 600
+// warmup 60
+// mode deferred | forward
+// context native | egl | osmesa
+// output BenchmarkResult.json
+// bloom, temporalAA, autoExposure, occlusionCulling, softwareOcclusion followed by 0 or 1
+// cameraPath CameraPath.txt		Recorded from the camera menu
+// keyframe time px py pz tx ty tz	Spline path written in the settings, used if there is no camera path file
+// scene default | stress
+// entities, models, materials, lights, seed, clusters followed by a count and spacing by a distance, for the stress scene
+// layout grid | random | clustered
+// sweep entities | models | materials | lights followed by the values, one run per value with the stress scene
+struct BenchmarkSettings
+{
+	glm::ivec2 resolution = glm::ivec2(1280, 720);
+	u32 frameCount = 600;
+	u32 warmupFrames = 60;
+	bool forwardRendering = false;
+	BENCHMARK_CONTEXT context = BENCHMARK_CONTEXT::NATIVE;
+	std::string outputPath = "BenchmarkResult.json";
+
+	bool bloom = true;
+	bool temporalAA = false;
+	bool autoExposure = false;
+	bool occlusionCulling = true;
+	bool softwareOcclusion = false;
+
+	std::string cameraPathFile;
+	CameraPath cameraPath;
+
+	bool stressScene = false;
+	StressSceneSettings stress;
+
+	std::string sweepParameter;
+	std::vector<u32> sweepValues;
+};
+
+
+bool LoadBenchmarkSettings(const char* path, BenchmarkSettings& settings);
+
+//Renders the scene without showing a window and writes the results as json. Returns the exit code of the process
+int RunBenchmark(const char* settingsPath);
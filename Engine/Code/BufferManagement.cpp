@@ -1,4 +1,5 @@
 #include "BufferManagement.h"
+#include "GpuMemory.h"
 #include <glad/glad.h>
 
 bool IsPowerOf2(u32 value)
@@ -7,18 +8,33 @@ bool IsPowerOf2(u32 value)
 }
 
 
-Buffer CreateBuffer(int size, int alignement, GLenum type, GLenum usage)
+static GPU_MEMORY_CATEGORY GetBufferCategory(GLenum type)
+{
+    if (type == GL_UNIFORM_BUFFER)
+        return GPU_MEMORY_CATEGORY::UNIFORM;
+    else if (type == GL_ARRAY_BUFFER || type == GL_ELEMENT_ARRAY_BUFFER)
+        return GPU_MEMORY_CATEGORY::MESH;
+
+    return GPU_MEMORY_CATEGORY::STORAGE;
+}
+
+
+Buffer CreateBuffer(int size, int alignement, GLenum type, GLenum usage, const char* owner)
 {
     Buffer buffer = {};
     buffer.size = size;
     buffer.type = type;
     buffer.alignement = alignement;
+    buffer.usage = usage;
+    buffer.owner = owner;
 
     glGenBuffers(1, &buffer.handle);
     glBindBuffer(type, buffer.handle);
     glBufferData(type, buffer.size, NULL, usage);
     glBindBuffer(type, 0);
 
+    GetGpuMemory().TrackBuffer(buffer.handle, GetBufferCategory(type), owner, buffer.size);
+
     return buffer;
 }
 
@@ -41,6 +57,27 @@ void UnmapBuffer(Buffer& buffer)
     glBindBuffer(buffer.type, 0);
 }
 
+void ReserveBuffer(Buffer& buffer, u32 size)
+{
+    if (size <= buffer.size)
+        return;
+
+    //Grows by half again so a scene that keeps growing doesn't reallocate every frame
+    buffer.size = glm::max(size, buffer.size + buffer.size / 2);
+
+    glBindBuffer(buffer.type, buffer.handle);
+    glBufferData(buffer.type, buffer.size, NULL, buffer.usage);
+    glBindBuffer(buffer.type, 0);
+
+    GetGpuMemory().ReleaseBuffer(buffer.handle);
+    GetGpuMemory().TrackBuffer(buffer.handle, GetBufferCategory(buffer.type), buffer.owner, buffer.size);
+}
+
+u32 GetBlockArraySize(const Buffer& buffer, u32 blockSize, u32 count)
+{
+    return count * Align(blockSize, buffer.alignement);
+}
+
 void AlignHead(Buffer& buffer, u32 alignment)
 {
     ASSERT(IsPowerOf2(alignment), "The alignment must be a power of 2");
@@ -50,8 +87,23 @@ void AlignHead(Buffer& buffer, u32 alignment)
 void PushAlignedData(Buffer& buffer, const void* data, u32 size, u32 alignment)
 {
     ASSERT(buffer.data != NULL, "The buffer must be mapped first");
+    ASSERT(Align(buffer.head, alignment) + size <= buffer.size, "The buffer is full, reserve more space before mapping it");
     AlignHead(buffer, alignment);
     memcpy((u8*)buffer.data + buffer.head, data, size);
     buffer.head += size;
 }
 
+u32 PushBlockArray(Buffer& buffer, u32 blockSize, u32 count)
+{
+    ASSERT(buffer.data != NULL, "The buffer must be mapped first");
+    AlignHead(buffer, buffer.alignement);
+
+    u32 offset = buffer.head;
+    ASSERT(offset + GetBlockArraySize(buffer, blockSize, count) <= buffer.size, "The buffer is full, reserve more space before mapping it");
+
+    //Where PushBlock would leave it after the last one
+    if (count > 0)
+        buffer.head += (count - 1) * Align(blockSize, buffer.alignement) + blockSize;
+
+    return offset;
+}
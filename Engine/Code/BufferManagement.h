@@ -10,12 +10,16 @@ struct Buffer
 	u32 alignement;
 	u32 head;
 	void* data;
+
+	GLenum usage;
+	const char* owner;
 };
 
 
 bool IsPowerOf2(u32 value);
 
-Buffer CreateBuffer(int size, int alignement, GLenum type, GLenum usage);
+//The owner names the buffer in the gpu memory tracker
+Buffer CreateBuffer(int size, int alignement, GLenum type, GLenum usage, const char* owner);
 
 void BindBuffer(const Buffer& buffer);
 
@@ -23,17 +27,33 @@ void MapBuffer(Buffer& buffer, GLenum access);
 
 void UnmapBuffer(Buffer& buffer);
 
+//Reallocates the buffer if it holds less than size bytes, the contents are lost. It must not be mapped
+void ReserveBuffer(Buffer& buffer, u32 size);
+
+//Bytes needed by count blocks pushed with PushBlock
+u32 GetBlockArraySize(const Buffer& buffer, u32 blockSize, u32 count);
+
 void AlignHead(Buffer& buffer, u32 alignment);
 
 void PushAlignedData(Buffer& buffer, const void* data, u32 size, u32 alignment);
 
 #define PushData(buffer, data, size) PushAlignedData(buffer, data, size, 1)
-#define PushUInt(buffer, value) { u32 v = value; PushAlignedData(buffer, &v, sizeof(v), 4); }
-#define PushFloat(buffer, value) { float v = value; PushAlignedData(buffer, &v, sizeof(v), 4); }
-#define PushVec3(buffer, value) PushAlignedData(buffer, glm::value_ptr(value), sizeof(value), sizeof(glm::vec4))
-#define PushVec4(buffer, value) PushAlignedData(buffer, glm::value_ptr(value), sizeof(value), sizeof(glm::vec4))
-#define PushMat3(buffer, value) PushAlignedData(buffer, glm::value_ptr(value), sizeof(value), sizeof(glm::vec4))
-#define PushMat4(buffer, value) PushAlignedData(buffer, glm::value_ptr(value), sizeof(value), sizeof(glm::vec4))
+
+//Copies a whole block (see UniformBlocks.h) at the next offset the buffer can be bound at, returns that offset
+template<typename Block>
+u32 PushBlock(Buffer& buffer, const Block& block)
+{
+	AlignHead(buffer, buffer.alignement);
+
+	u32 offset = buffer.head;
+	PushAlignedData(buffer, &block, sizeof(Block), alignof(Block));
+
+	return offset;
+}
+
+//Reserves count blocks in a row to be written in any order, from other threads too. Returns the offset of the first one,
+//block i starts at offset + i * Align(blockSize, buffer.alignement)
+u32 PushBlockArray(Buffer& buffer, u32 blockSize, u32 count);
 
 #define CreateConstantBuffer(size) CreateBuffer(size, GL_UNIFORM_BUFFER, GL_STREAM_DRAW)
 #define CreateStaticVertexBuffer(size) CreateBuffer(size, GL_ARRAY_BUFFER, GL_STATIC_DRAW)
@@ -6,7 +6,8 @@ Camera::Camera() :
 	FOV(DEFAULT_FOV),
 	zNear(DEFAULT_Z_NEAR),
 	zFar(DEFAULT_Z_FAR),
-	target(0.0f, 0.4f, 0.0f)
+	target(0.0f, 0.4f, 0.0f),
+	jitter(0.f, 0.f)
 {
 }
 
@@ -76,6 +77,12 @@ glm::vec3 Camera::GetPositionV3() const
 }
 
 
+void Camera::SetPosition(const glm::vec3& newPosition)
+{
+	position = newPosition;
+}
+
+
 void Camera::SetAspectRatio(float ratio)
 {
 	aspectRatio = ratio;
@@ -105,7 +112,40 @@ float* Camera::GetTarget()
 }
 
 
+glm::vec3 Camera::GetTargetV3() const
+{
+	return target;
+}
+
+
+void Camera::SetTarget(const glm::vec3& newTarget)
+{
+	target = newTarget;
+}
+
+
+void Camera::SetJitter(const glm::vec2& ndcOffset)
+{
+	jitter = ndcOffset;
+}
+
+
+glm::vec2 Camera::GetJitter() const
+{
+	return jitter;
+}
+
+
 glm::mat4 Camera::GetProjectionMatrix() const
+{
+	//Shifts the whole image after the perspective divide
+	glm::mat4 offset = glm::translate(glm::mat4(1.f), glm::vec3(jitter, 0.f));
+
+	return offset * GetUnjitteredProjectionMatrix();
+}
+
+
+glm::mat4 Camera::GetUnjitteredProjectionMatrix() const
 {
 	return glm::perspective(glm::radians(FOV), aspectRatio, zNear, zFar);
 }
@@ -17,6 +17,7 @@ public:
 
 	float* GetPosition();
 	glm::vec3 GetPositionV3() const;
+	void SetPosition(const glm::vec3& newPosition);
 
 	void SetAspectRatio(float ratio);
 
@@ -26,8 +27,15 @@ public:
 	float* GetZFar();
 
 	float* GetTarget();
+	glm::vec3 GetTargetV3() const;
+	void SetTarget(const glm::vec3& newTarget);
+
+	//Offset of the projection in ndc, used by temporal anti aliasing
+	void SetJitter(const glm::vec2& ndcOffset);
+	glm::vec2 GetJitter() const;
 
 	glm::mat4 GetProjectionMatrix() const;
+	glm::mat4 GetUnjitteredProjectionMatrix() const;
 	glm::mat4 GetViewMatrix() const;
 
 private:
@@ -42,5 +50,7 @@ private:
 	float zFar;
 
 	glm::vec3 target;
+
+	glm::vec2 jitter;
 };
 
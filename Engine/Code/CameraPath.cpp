@@ -0,0 +1,143 @@
+#include "CameraPath.h"
+
+#include <glm/gtx/spline.hpp>
+#include <sstream>
+
+bool CameraPath::Load(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed reading camera path %s", path);
+		return false;
+	}
+
+	fclose(file);
+
+	Clear();
+
+	String text = ReadTextFile(path);
+	std::istringstream stream(std::string(text.str, text.len));
+
+	std::string line;
+	u32 lineNumber = 0;
+
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		if (ParseKeyframe(line) == false)
+			ELOG("Invalid keyframe in line %u of %s", lineNumber, path);
+	}
+
+	return keyframes.empty() == false;
+}
+
+
+bool CameraPath::Save(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing camera path %s", path);
+		return false;
+	}
+
+	fprintf(file, "# time position target\n");
+
+	for (const CameraKeyframe& keyframe : keyframes)
+	{
+		fprintf(file, "%.3f %.4f %.4f %.4f %.4f %.4f %.4f\n", keyframe.time,
+			keyframe.position.x, keyframe.position.y, keyframe.position.z,
+			keyframe.target.x, keyframe.target.y, keyframe.target.z);
+	}
+
+	fclose(file);
+	return true;
+}
+
+
+bool CameraPath::ParseKeyframe(const std::string& line)
+{
+	std::istringstream stream(line);
+
+	CameraKeyframe keyframe;
+	stream >> keyframe.time;
+	stream >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z;
+	stream >> keyframe.target.x >> keyframe.target.y >> keyframe.target.z;
+
+	if (stream.fail() == true)
+		return false;
+
+	if (keyframes.empty() == false && keyframe.time < keyframes.back().time)
+		return false;
+
+	keyframes.push_back(keyframe);
+	return true;
+}
+
+
+void CameraPath::AddKeyframe(float time, const glm::vec3& position, const glm::vec3& target)
+{
+	keyframes.push_back({ time, position, target });
+}
+
+
+void CameraPath::Clear()
+{
+	keyframes.clear();
+}
+
+
+void CameraPath::Evaluate(float time, glm::vec3& position, glm::vec3& target) const
+{
+	if (keyframes.empty() == true)
+		return;
+
+	float duration = GetDuration();
+	if (keyframes.size() == 1 || duration <= 0.f)
+	{
+		position = keyframes[0].position;
+		target = keyframes[0].target;
+		return;
+	}
+
+	time = keyframes[0].time + fmod(glm::max(time, 0.f), duration);
+
+	u32 segment = 0;
+	while (segment + 2 < keyframes.size() && keyframes[segment + 1].time <= time)
+		segment++;
+
+	//The ends are repeated so the first and last segments have four points
+	const CameraKeyframe& k0 = keyframes[segment > 0 ? segment - 1 : 0];
+	const CameraKeyframe& k1 = keyframes[segment];
+	const CameraKeyframe& k2 = keyframes[segment + 1];
+	const CameraKeyframe& k3 = keyframes[glm::min(segment + 2, (u32)keyframes.size() - 1)];
+
+	float length = k2.time - k1.time;
+	float t = length > 0.f ? glm::clamp((time - k1.time) / length, 0.f, 1.f) : 0.f;
+
+	position = glm::catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	target = glm::catmullRom(k0.target, k1.target, k2.target, k3.target, t);
+}
+
+
+float CameraPath::GetDuration() const
+{
+	if (keyframes.empty() == true)
+		return 0.f;
+
+	return keyframes.back().time - keyframes.front().time;
+}
+
+
+u32 CameraPath::GetKeyframeCount() const
+{
+	return keyframes.size();
+}
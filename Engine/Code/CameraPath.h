@@ -0,0 +1,39 @@
+#pragma once
+
+#include "platform.h"
+
+#define CAMERA_PATH_FILE "CameraPath.txt"
+#define CAMERA_PATH_RECORD_INTERVAL 0.25f	//Seconds between recorded keyframes
+
+struct CameraKeyframe
+{
+	float time;		//Seconds
+	glm::vec3 position;
+	glm::vec3 target;
+};
+
+
+//Camera positions and targets over time, interpolated with a Catmull-Rom spline so a few keyframes give a
+//smooth path. The file has one keyframe per line: "time px py pz tx ty tz", # starts a comment.
+class CameraPath
+{
+public:
+	bool Load(const char* path);
+	bool Save(const char* path) const;
+
+	//Parses one line of the file format, false if it isn't a keyframe
+	bool ParseKeyframe(const std::string& line);
+
+	//Keyframes must be added in time order
+	void AddKeyframe(float time, const glm::vec3& position, const glm::vec3& target);
+	void Clear();
+
+	//Times past the end loop back to the start
+	void Evaluate(float time, glm::vec3& position, glm::vec3& target) const;
+
+	float GetDuration() const;
+	u32 GetKeyframeCount() const;
+
+private:
+	std::vector<CameraKeyframe> keyframes;
+};
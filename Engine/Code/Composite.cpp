@@ -0,0 +1,145 @@
+#include "Composite.h"
+
+#include "engine.h"
+#include "GpuProfiler.h"
+#include "AutoExposure.h"
+#include "TemporalAA.h"
+#include "ShaderPermutations.h"
+
+Composite::Composite(App* app)
+{
+	glGenVertexArrays(1, &emptyVao);
+
+	permutationIdx = app->shaderPermutations->Register("Composite.glsl", "COMPOSITE");
+	app->shaderPermutations->AddFeature(permutationIdx, "BLOOM", 0);
+	app->shaderPermutations->AddFeature(permutationIdx, "AUTO_EXPOSURE", 1);
+	app->shaderPermutations->AddFeature(permutationIdx, "TONEMAP_OPERATOR", COMPOSITE_TONEMAP_OFFSET, 8);
+	app->shaderPermutations->AddFeature(permutationIdx, "DRAW_MODE", COMPOSITE_DRAW_MODE_OFFSET, 8);
+
+	//The default view is almost always the first one shown
+	app->shaderPermutations->GetVariant(app, permutationIdx, BuildKey(app));
+}
+
+
+Composite::~Composite()
+{
+	glDeleteVertexArrays(1, &emptyVao);
+}
+
+
+void Composite::Render(App* app)
+{
+	GPU_PROFILE_SCOPE(app, "Composite");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glClearColor(0.1, 0.1, 0.1, 1.0);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glDisable(GL_DEPTH_TEST);
+
+	// - set the viewport
+	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
+
+	// - bind program
+	u32 key = BuildKey(app);
+	Program& program = app->programs[app->shaderPermutations->GetVariant(app, permutationIdx, key)];
+	glUseProgram(program.handle);
+	glBindVertexArray(emptyVao);
+
+	GLuint uniformLocation = glGetUniformLocation(program.handle, "uRenderScale");
+	glUniform2fv(uniformLocation, 1, glm::value_ptr(app->renderScale));
+
+	if (app->drawMode == DRAW_MODE::DEFAULT)
+	{
+		//The temporal resolve already outputs at window resolution
+		bool temporalOutput = app->temporalAA->IsActive(app);
+		glm::vec2 sceneScale = temporalOutput ? glm::vec2(1.f) : app->renderScale;
+
+		glUniform1i(glGetUniformLocation(program.handle, "sceneMap"), 0);
+		glActiveTexture(GL_TEXTURE0);
+
+		if (temporalOutput == true)
+			glBindTexture(GL_TEXTURE_2D, app->temporalAA->GetOutputTexture());
+		else
+		{
+			glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[3].handle);
+
+			//Upscale the internal resolution to the window
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+
+		uniformLocation = glGetUniformLocation(program.handle, "uSceneScale");
+		glUniform2fv(uniformLocation, 1, glm::value_ptr(sceneScale));
+
+		if ((key & (u32)COMPOSITE_FEATURE::BLOOM) != 0)
+		{
+			glUniform1i(glGetUniformLocation(program.handle, "bloomMap"), 1);
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, app->rtBloomUp);
+
+			glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(3), app->bloomUniformBuffer.handle, app->bloomParamsOffset, app->bloomParamsSize);
+		}
+
+		app->autoExposure->BindExposure(program);
+	}
+
+	else
+	{
+		glUniform1i(glGetUniformLocation(program.handle, "debugMap"), 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, GetDebugTexture(app));
+	}
+
+	// - draw
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	// - clean
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+
+u32 Composite::BuildKey(App* app) const
+{
+	u32 features = 0;
+	u32 tonemapOperator = 0;
+
+	//Debug views show the raw target
+	if (app->drawMode == DRAW_MODE::DEFAULT)
+	{
+		if (app->applyBloom == true)
+			features |= (u32)COMPOSITE_FEATURE::BLOOM;
+
+		if (app->autoExposure->enabled == true)
+			features |= (u32)COMPOSITE_FEATURE::AUTO_EXPOSURE;
+
+		tonemapOperator = (u32)app->autoExposure->tonemapOperator;
+	}
+
+	return features | (tonemapOperator << COMPOSITE_TONEMAP_OFFSET) | ((u32)app->drawMode << COMPOSITE_DRAW_MODE_OFFSET);
+}
+
+
+u32 Composite::GetDebugTexture(App* app) const
+{
+	switch (app->drawMode)
+	{
+	case DRAW_MODE::ALBEDO:			return app->framebuffer.textures[0].handle;
+	case DRAW_MODE::NORMALS:		return app->framebuffer.textures[1].handle;
+	case DRAW_MODE::WORLD_POS:		return app->framebuffer.textures[2].handle;
+	case DRAW_MODE::BLOOM:			return app->rtBloomUp;
+	case DRAW_MODE::REFLECTIVITY:	return app->framebuffer.textures[4].handle;
+	case DRAW_MODE::DEPTH:			return app->framebuffer.textures[5].handle;
+
+	default:
+		return app->framebuffer.textures[3].handle;
+	}
+}
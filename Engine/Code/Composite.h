@@ -0,0 +1,39 @@
+#pragma once
+
+#include "platform.h"
+
+struct App;
+
+#define COMPOSITE_TONEMAP_OFFSET 8
+#define COMPOSITE_DRAW_MODE_OFFSET 16
+
+enum class COMPOSITE_FEATURE : u32
+{
+	BLOOM = 1 << 0,
+	AUTO_EXPOSURE = 1 << 1
+};
+
+
+//Final pass to the window. Adds the bloom, applies the exposure and the tonemapping, or shows a debug view
+//of the G-buffer, in a single full screen triangle. Every combination of the enabled features is compiled
+//as its own program with defines, so the shader never branches on them or samples unused targets.
+struct Composite
+{
+public:
+	Composite(App* app);
+	~Composite();
+
+	void Render(App* app);
+
+private:
+	//Features, tonemap operator and draw mode packed
+	u32 BuildKey(App* app) const;
+
+	u32 GetDebugTexture(App* app) const;
+
+private:
+	u32 permutationIdx;
+
+	//The triangle is generated from the vertex id, but core profile still needs a vao bound
+	u32 emptyVao = 0;
+};
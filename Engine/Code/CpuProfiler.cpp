@@ -0,0 +1,166 @@
+#include "CpuProfiler.h"
+
+#include "GpuProfiler.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#define CPU_TRACE_GPU_THREAD_ID 1000
+
+static const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+
+//Every buffer ever created, they outlive their threads so the trace still has their events
+static std::mutex traceRegistryMutex;
+static std::vector<std::unique_ptr<CpuTraceBuffer>> traceRegistry;
+
+static thread_local CpuTraceBuffer* threadTraceBuffer = nullptr;
+
+
+static CpuTraceBuffer* GetThreadTraceBuffer()
+{
+	if (threadTraceBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(traceRegistryMutex);
+
+		CpuTraceBuffer* buffer = new CpuTraceBuffer();
+		buffer->writeCount = 0;
+		buffer->threadId = traceRegistry.size() + 1;
+		buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+
+		traceRegistry.push_back(std::unique_ptr<CpuTraceBuffer>(buffer));
+		threadTraceBuffer = buffer;
+	}
+
+	return threadTraceBuffer;
+}
+
+
+CpuProfileScope::CpuProfileScope(const char* name) :
+	name(name),
+	start(GetProfilerTime())
+{
+}
+
+
+CpuProfileScope::~CpuProfileScope()
+{
+	RecordCpuEvent(name, start, GetProfilerTime());
+}
+
+
+u64 GetProfilerTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+
+void SetProfilerThreadName(const char* name)
+{
+	CpuTraceBuffer* buffer = GetThreadTraceBuffer();
+
+	std::lock_guard<std::mutex> lock(traceRegistryMutex);
+	buffer->threadName = name;
+}
+
+
+void RecordCpuEvent(const char* name, u64 start, u64 end)
+{
+	CpuTraceBuffer* buffer = GetThreadTraceBuffer();
+
+	u64 writeCount = buffer->writeCount.load(std::memory_order_relaxed);
+
+	CpuTraceEvent& event = buffer->events[writeCount % CPU_TRACE_RING_SIZE];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+
+	//Publishes the event to the thread writing the trace
+	buffer->writeCount.store(writeCount + 1, std::memory_order_release);
+}
+
+
+static void WriteTraceEvent(FILE* file, bool& first, const char* name, u32 threadId, u64 start, u64 end)
+{
+	fprintf(file, "%s\n\t\t{ \"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f }",
+		first ? "" : ",", name, threadId, start / 1000.0, (end - start) / 1000.0);
+
+	first = false;
+}
+
+
+static void WriteThreadName(FILE* file, bool& first, const char* name, u32 threadId)
+{
+	fprintf(file, "%s\n\t\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": { \"name\": \"%s\" } }",
+		first ? "" : ",", threadId, name);
+
+	first = false;
+}
+
+
+bool WriteChromeTrace(const char* path, const GpuProfiler* gpuProfiler)
+{
+	CPU_PROFILE_FUNCTION();
+
+	FILE* file = fopen(path, "w");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing the trace %s", path);
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"displayTimeUnit\": \"ms\",\n\t\"traceEvents\": [");
+
+	bool first = true;
+	u32 eventCount = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(traceRegistryMutex);
+
+		for (const std::unique_ptr<CpuTraceBuffer>& buffer : traceRegistry)
+		{
+			WriteThreadName(file, first, buffer->threadName.c_str(), buffer->threadId);
+
+			//Events written while this runs can overwrite the oldest ones, it only happens if the ring wraps meanwhile
+			u64 writeCount = buffer->writeCount.load(std::memory_order_acquire);
+			u64 count = glm::min(writeCount, (u64)CPU_TRACE_RING_SIZE);
+
+			for (u64 i = writeCount - count; i < writeCount; ++i)
+			{
+				const CpuTraceEvent& event = buffer->events[i % CPU_TRACE_RING_SIZE];
+				WriteTraceEvent(file, first, event.name, buffer->threadId, event.start, event.end);
+				eventCount++;
+			}
+		}
+	}
+
+	if (gpuProfiler != nullptr)
+	{
+		//Both clocks are read now, the difference moves the gpu timestamps to the cpu clock
+		i64 gpuToCpu = (i64)GetProfilerTime() - (i64)gpuProfiler->GetGpuTime();
+
+		std::vector<GpuTraceEvent> gpuEvents;
+		gpuProfiler->GetTraceEvents(gpuEvents);
+
+		WriteThreadName(file, first, "Gpu", CPU_TRACE_GPU_THREAD_ID);
+
+		for (const GpuTraceEvent& event : gpuEvents)
+		{
+			i64 start = (i64)event.start + gpuToCpu;
+			i64 end = (i64)event.end + gpuToCpu;
+
+			if (start < 0 || end < start)
+				continue;
+
+			WriteTraceEvent(file, first, event.name, CPU_TRACE_GPU_THREAD_ID, start, end);
+			eventCount++;
+		}
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+	fclose(file);
+
+	ILOG("Trace written to %s, %u events", path, eventCount);
+	return true;
+}
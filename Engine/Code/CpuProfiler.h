@@ -0,0 +1,64 @@
+#pragma once
+
+#include "platform.h"
+
+#include <atomic>
+
+#define CPU_TRACE_RING_SIZE 16384		//Events kept per thread, the oldest are overwritten
+#define CPU_TRACE_FILE "Trace.json"
+#define CPU_TRACE_STARTUP_FRAMES 10		//Frames recorded with -trace before the file is written
+
+//Define CPU_PROFILER_DISABLED to compile the scopes out
+#ifndef CPU_PROFILER_DISABLED
+#define CPU_PROFILE_SCOPE(name) CpuProfileScope CONCAT(cpuProfileScope, __LINE__)(name)
+#define CPU_PROFILE_FUNCTION() CPU_PROFILE_SCOPE(__FUNCTION__)
+#else
+#define CPU_PROFILE_SCOPE(name)
+#define CPU_PROFILE_FUNCTION()
+#endif
+
+class GpuProfiler;
+
+//Scope that ended, times in nanoseconds since startup. The name must outlive the trace (string literals)
+struct CpuTraceEvent
+{
+	const char* name;
+	u64 start;
+	u64 end;
+};
+
+
+//Events of one thread. Only that thread writes, the count is atomic so the trace can be read from another one
+struct CpuTraceBuffer
+{
+	CpuTraceEvent events[CPU_TRACE_RING_SIZE];
+	std::atomic<u64> writeCount;
+
+	u32 threadId;
+	std::string threadName;
+};
+
+
+class CpuProfileScope
+{
+public:
+	CpuProfileScope(const char* name);
+	~CpuProfileScope();
+
+private:
+	const char* name;
+	u64 start;
+};
+
+
+//Nanoseconds since startup
+u64 GetProfilerTime();
+
+//Name of the calling thread in the trace
+void SetProfilerThreadName(const char* name);
+
+void RecordCpuEvent(const char* name, u64 start, u64 end);
+
+//Writes the events of every thread in the Chrome trace format, which Perfetto reads too. The gpu scopes are
+//added as their own track, moved to the cpu clock
+bool WriteChromeTrace(const char* path, const GpuProfiler* gpuProfiler);
@@ -0,0 +1,85 @@
+#include "DynamicResolution.h"
+#include "glad/glad.h"
+
+DynamicResolution::DynamicResolution()
+{
+	glGenQueries(DYNAMIC_RESOLUTION_QUERY_COUNT, queries);
+
+	for (int i = 0; i < DYNAMIC_RESOLUTION_QUERY_COUNT; ++i)
+		queryIssued[i] = false;
+}
+
+
+DynamicResolution::~DynamicResolution()
+{
+	glDeleteQueries(DYNAMIC_RESOLUTION_QUERY_COUNT, queries);
+}
+
+
+void DynamicResolution::BeginFrame()
+{
+	//The query of this slot was issued DYNAMIC_RESOLUTION_QUERY_COUNT frames ago
+	if (queryIssued[currentQuery] == true)
+		ReadQuery(currentQuery);
+
+	glBeginQuery(GL_TIME_ELAPSED, queries[currentQuery]);
+}
+
+
+void DynamicResolution::EndFrame()
+{
+	glEndQuery(GL_TIME_ELAPSED);
+
+	queryIssued[currentQuery] = true;
+	currentQuery = (currentQuery + 1) % DYNAMIC_RESOLUTION_QUERY_COUNT;
+}
+
+
+glm::ivec2 DynamicResolution::GetRenderSize(const glm::ivec2& displaySize) const
+{
+	if (enabled == false)
+		return displaySize;
+
+	return glm::max(glm::ivec2(1), glm::ivec2(glm::vec2(displaySize) * renderScale + 0.5f));
+}
+
+
+void DynamicResolution::ReadQuery(u32 queryIdx)
+{
+	GLint available = 0;
+	glGetQueryObjectiv(queries[queryIdx], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	//Still in flight, drop the sample instead of stalling
+	if (available == 0)
+		return;
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(queries[queryIdx], GL_QUERY_RESULT, &elapsed);
+
+	float frameTime = elapsed / 1000000.f;
+
+	if (gpuFrameTime == 0.f)
+		gpuFrameTime = frameTime;
+	else
+		gpuFrameTime = glm::mix(gpuFrameTime, frameTime, 0.1f);
+
+	UpdateScale();
+}
+
+
+void DynamicResolution::UpdateScale()
+{
+	if (enabled == false || gpuFrameTime <= 0.f)
+		return;
+
+	//Small band around the target so the resolution doesn't oscillate
+	float ratio = targetFrameTime / gpuFrameTime;
+	if (ratio > 0.95f && ratio < 1.05f)
+		return;
+
+	//The cost scales with the pixel count, the square of the scale
+	float desiredScale = renderScale * sqrt(ratio);
+	renderScale = glm::mix(renderScale, desiredScale, 0.1f);
+
+	renderScale = glm::clamp(renderScale, minScale, glm::min(maxScale, 1.f));
+}
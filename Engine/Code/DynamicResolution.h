@@ -0,0 +1,39 @@
+#pragma once
+
+#include "platform.h"
+
+#define DYNAMIC_RESOLUTION_QUERY_COUNT 4
+
+//Measures the gpu time of every frame with timer queries and scales the internal render resolution
+//to stay inside the frame budget. The render targets keep their size, only the viewports change.
+//Results are read some frames later so the cpu never waits for the gpu.
+class DynamicResolution
+{
+public:
+	DynamicResolution();
+	~DynamicResolution();
+
+	void BeginFrame();
+	void EndFrame();
+
+	glm::ivec2 GetRenderSize(const glm::ivec2& displaySize) const;
+
+private:
+	void ReadQuery(u32 queryIdx);
+	void UpdateScale();
+
+public:
+	bool enabled = false;
+
+	float targetFrameTime = 16.6f;	//Milliseconds
+	float minScale = 0.5f;
+	float maxScale = 1.f;			//Targets are allocated at display size, so it can't go over 1
+
+	float renderScale = 1.f;
+	float gpuFrameTime = 0.f;		//Milliseconds, smoothed
+
+private:
+	u32 queries[DYNAMIC_RESOLUTION_QUERY_COUNT];
+	bool queryIssued[DYNAMIC_RESOLUTION_QUERY_COUNT];
+	u32 currentQuery = 0;
+};
@@ -1,12 +1,18 @@
 #include "Environment.h"
 
 #include "engine.h"
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include "GpuMemory.h"
+#include "RenderTargetPool.h"
 
 #include <stb_image.h>
 #include <stb_image_write.h>
 
 Environment::Environment(App* app, const char* cubeMapPath)
 {
+	CPU_PROFILE_SCOPE("Environment");
+
 	InitCubeVAO();
 	InitHdrTexture(cubeMapPath);
 	InitCubemapBuffers();
@@ -62,6 +68,13 @@ Environment::Environment(App* app, const char* cubeMapPath)
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	glUseProgram(0);
+
+	//Only needed to generate the cubemaps
+	glDeleteFramebuffers(1, &captureFBO);
+	captureFBO = 0;
+
+	GetRenderTargetPool().Release(captureDepth);
+	captureDepth = 0;
 }
 
 
@@ -71,21 +84,9 @@ Environment::~Environment()
 }
 
 
-void Environment::RenderSkybox(App* app, bool forwardRender)
+void Environment::RenderSkybox(App* app)
 {
-	if (forwardRender == false)
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, app->framebuffer.handle);
-
-		u32 drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
-		glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
-	}
-
-	else
-	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
-	
+	GPU_PROFILE_SCOPE(app, "RenderSkybox");
 
 	glEnable(GL_DEPTH_TEST);
 	glDepthMask(GL_FALSE);
@@ -93,7 +94,7 @@ void Environment::RenderSkybox(App* app, bool forwardRender)
 	glDepthFunc(GL_LEQUAL);
 
 	// - set the viewport
-	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
+	glViewport(0, 0, app->renderSize.x, app->renderSize.y);
 
 	// - bind program
 	glUseProgram(skyBoxProgram.handle);
@@ -114,7 +115,6 @@ void Environment::RenderSkybox(App* app, bool forwardRender)
 
 	glBindVertexArray(0);
 	glUseProgram(0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	glDepthFunc(GL_LESS);
 	glDepthMask(GL_TRUE);
@@ -128,6 +128,7 @@ void Environment::InitCubeVAO()
 
 	glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
+	GetGpuMemory().TrackBuffer(cubeVBO, GPU_MEMORY_CATEGORY::MESH, "Skybox cube", sizeof(cubeVertices));
 
 	glBindVertexArray(cubeVAO);
 	glEnableVertexAttribArray(0);
@@ -151,13 +152,7 @@ void Environment::RenderCube()
 
 void Environment::InitHdrTexture(const char* cubeMapPath)
 {
-	Image img = {};
-	stbi_set_flip_vertically_on_load(true);
-	img.pixels = stbi_loadf(cubeMapPath, &img.size.x, &img.size.y, &img.nchannels, 0);
-	if (img.pixels)
-	{
-		img.stride = img.size.x * img.nchannels;
-	}
+	Image img = LoadImageHdr(cubeMapPath);
 
 	hdrTexSizeX = img.size.x;
 	hdrTexSizeY = img.size.y;
@@ -167,27 +162,27 @@ void Environment::InitHdrTexture(const char* cubeMapPath)
 	glBindTexture(GL_TEXTURE_2D, hdrTexture.handle);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, img.size.x, img.size.y, 0, GL_RGB, GL_FLOAT, img.pixels);
+	GetGpuMemory().TrackTexture(hdrTexture.handle, GPU_MEMORY_CATEGORY::ENVIRONMENT, cubeMapPath, GL_RGB16F, img.size.x, img.size.y);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	stbi_image_free(img.pixels);
+	FreeImage(img);
 }
 
 
 void Environment::InitCubemapBuffers()
 {
-	//Capture FBO & RBO
+	//Capture FBO, the depth comes from the render target pool and goes back once the cubemaps are generated
 	glGenFramebuffers(1, &captureFBO);
-	glGenRenderbuffers(1, &captureRBO);
+
+	RenderTargetDesc depthDesc = { 512, 512, GL_DEPTH_COMPONENT24 };
+	captureDepth = GetRenderTargetPool().Acquire(depthDesc, "Environment capture depth");
 
 	glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, captureDepth, 0);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
@@ -203,6 +198,8 @@ void Environment::InitCubemap()
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
 	}
 
+	GetGpuMemory().TrackTexture(cubeMap.handle, GPU_MEMORY_CATEGORY::ENVIRONMENT, "Skybox", GL_RGB16F, 512, 512, 6);
+
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -213,6 +210,7 @@ void Environment::InitCubemap()
 
 void Environment::InitIrradianceBuffers()
 {
+	irradianceFBO.owner = "Environment blur";
 	irradianceFBO.PushTexture(hdrTexSizeX, hdrTexSizeY, GL_RGBA16F, GL_RGBA, GL_FLOAT);
 	irradianceFBO.AttachTextures();
 }
@@ -236,6 +234,8 @@ void Environment::InitIrradianceMap()
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
 	}
 
+	GetGpuMemory().TrackTexture(irradianceMap.handle, GPU_MEMORY_CATEGORY::ENVIRONMENT, "Irradiance", GL_RGB16F, 128, 128, 6);
+
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
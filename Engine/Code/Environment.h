@@ -12,7 +12,8 @@ public:
 	Environment(App* app, const char* cubeMapPath);
 	~Environment();
 
-    void RenderSkybox(App* app, bool forwardRender = false);
+    //Into the albedo target or the window, whatever the render graph bound
+    void RenderSkybox(App* app);
 
 private:
 	void InitCubeVAO();
@@ -44,8 +45,8 @@ public:
 
     FrameBuffer irradianceFBO;
 
-	u32 captureFBO;
-	u32 captureRBO;
+	u32 captureFBO = 0;
+	u32 captureDepth = 0;
 };
 
 static float cubeVertices[] = {
@@ -0,0 +1,203 @@
+#include "FileWatcher.h"
+#include "CpuProfiler.h"
+
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher()
+{
+	quit = false;
+
+#ifdef __linux__
+	inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (inotifyDescriptor < 0)
+		ELOG("inotify_init1() failed, falling back to polling the watched files");
+#endif
+
+	if (inotifyDescriptor >= 0)
+		thread = std::thread(&FileWatcher::WatchLoop, this);
+	else
+		thread = std::thread(&FileWatcher::PollLoop, this);
+}
+
+
+FileWatcher::~FileWatcher()
+{
+	quit = true;
+	thread.join();
+
+#ifdef __linux__
+	if (inotifyDescriptor >= 0)
+		close(inotifyDescriptor);
+#endif
+}
+
+
+void FileWatcher::Watch(const char* path)
+{
+	std::string pathString = path;
+
+	WatchedFile file = {};
+	file.path = pathString;
+
+	size_t separator = pathString.find_last_of("/\\");
+	if (separator == std::string::npos)
+	{
+		file.directory = ".";
+		file.fileName = pathString;
+	}
+	else
+	{
+		file.directory = pathString.substr(0, separator);
+		file.fileName = pathString.substr(separator + 1);
+	}
+
+	file.lastWriteTimestamp = GetFileLastWriteTimestamp(path);
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (int i = 0; i < files.size(); ++i)
+	{
+		if (files[i].path == pathString)
+			return;
+	}
+
+	files.push_back(file);
+
+	if (inotifyDescriptor >= 0)
+		WatchDirectory(file.directory);
+}
+
+
+void FileWatcher::Drain(std::vector<std::string>& changedPaths)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	changedPaths.insert(changedPaths.end(), changes.begin(), changes.end());
+	changes.clear();
+}
+
+
+bool FileWatcher::IsEventDriven() const
+{
+	return inotifyDescriptor >= 0;
+}
+
+
+u32 FileWatcher::GetWatchedCount()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return files.size();
+}
+
+
+void FileWatcher::WatchLoop()
+{
+	SetProfilerThreadName("File watcher");
+
+#ifdef __linux__
+	//Aligned as the events it holds
+	alignas(struct inotify_event) char eventBuffer[4096];
+
+	while (quit == false)
+	{
+		pollfd descriptor = { inotifyDescriptor, POLLIN, 0 };
+
+		if (poll(&descriptor, 1, FILE_WATCH_WAIT_TIMEOUT_MS) <= 0)
+			continue;
+
+		ssize_t length = read(inotifyDescriptor, eventBuffer, sizeof(eventBuffer));
+
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = (const inotify_event*)(eventBuffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+
+			if (event->len == 0)
+				continue;
+
+			std::unique_lock<std::mutex> lock(mutex);
+
+			for (int i = 0; i < directories.size(); ++i)
+			{
+				if (directories[i].descriptor == event->wd)
+				{
+					PushChange(directories[i].path, event->name);
+					break;
+				}
+			}
+		}
+	}
+#endif
+}
+
+
+void FileWatcher::PollLoop()
+{
+	SetProfilerThreadName("File watcher");
+
+	while (quit == false)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(FILE_WATCH_POLL_INTERVAL_MS));
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for (int i = 0; i < files.size(); ++i)
+		{
+			u64 currentTimestamp = GetFileLastWriteTimestamp(files[i].path.c_str());
+
+			if (files[i].lastWriteTimestamp < currentTimestamp)
+			{
+				files[i].lastWriteTimestamp = currentTimestamp;
+				PushChange(files[i].directory, files[i].fileName.c_str());
+			}
+		}
+	}
+}
+
+
+//Needs the mutex locked
+void FileWatcher::WatchDirectory(const std::string& directory)
+{
+#ifdef __linux__
+	for (int i = 0; i < directories.size(); ++i)
+	{
+		if (directories[i].path == directory)
+			return;
+	}
+
+	//Editors usually save to a temporary file and rename it, so moves count as writes
+	int descriptor = inotify_add_watch(inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (descriptor < 0)
+	{
+		ELOG("inotify_add_watch() failed with directory %s, its files won't be reloaded", directory.c_str());
+		return;
+	}
+
+	directories.push_back({ directory, descriptor });
+#endif
+}
+
+
+//Needs the mutex locked
+void FileWatcher::PushChange(const std::string& directory, const char* fileName)
+{
+	for (int i = 0; i < files.size(); ++i)
+	{
+		if (files[i].directory != directory || files[i].fileName != fileName)
+			continue;
+
+		bool queued = false;
+		for (int j = 0; j < changes.size() && queued == false; ++j)
+			queued = changes[j] == files[i].path;
+
+		if (queued == false)
+			changes.push_back(files[i].path);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "platform.h"
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#define FILE_WATCH_POLL_INTERVAL_MS 250
+#define FILE_WATCH_WAIT_TIMEOUT_MS 100	//How long the inotify thread waits before checking if it has to quit
+
+struct WatchedFile
+{
+	std::string path;		//As given to Watch(), it is what Drain() returns
+	std::string directory;
+	std::string fileName;
+
+	u64 lastWriteTimestamp;	//Only used by the polling fallback
+};
+
+
+struct WatchedDirectory
+{
+	std::string path;
+	int descriptor;
+};
+
+
+//Watches files on a background thread and queues the ones that change, so the main loop doesn't have to stat them every frame.
+//On Linux it uses inotify on the directories of the watched files, everywhere else (or if inotify fails) it polls the timestamps.
+//Every write is queued, Drain() returns each changed path once no matter how many times it was saved.
+class FileWatcher
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	//Does nothing if the path is already watched
+	void Watch(const char* path);
+
+	//Moves the paths that changed since the last call to changedPaths
+	void Drain(std::vector<std::string>& changedPaths);
+
+	bool IsEventDriven() const;
+	u32 GetWatchedCount();
+
+private:
+	void WatchLoop();
+	void PollLoop();
+
+	void WatchDirectory(const std::string& directory);
+	void PushChange(const std::string& directory, const char* fileName);
+
+private:
+	std::vector<WatchedFile> files;
+	std::vector<WatchedDirectory> directories;
+	std::vector<std::string> changes;
+
+	int inotifyDescriptor = -1;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::atomic<bool> quit;
+};
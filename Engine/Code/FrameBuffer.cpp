@@ -1,4 +1,5 @@
 #include "FrameBuffer.h"
+#include "RenderTargetPool.h"
 #include "glad/glad.h"
 
 TexObj::TexObj(u32 handle, float sizeX, float sizeY, int internalFormat, int format, int type) :
@@ -12,7 +13,8 @@ TexObj::TexObj(u32 handle, float sizeX, float sizeY, int internalFormat, int for
 }
 
 FrameBuffer::FrameBuffer() : 
-	handle(0u)
+	handle(0u),
+	owner("FrameBuffer")
 {
 }
 
@@ -24,36 +26,40 @@ FrameBuffer::~FrameBuffer()
 	int textureCount = textures.size();
 	for (int i = 0; i < textureCount; ++i)
 	{
-		glDeleteTextures(1, &textures[0].handle);
+		GetRenderTargetPool().Release(textures[i].handle);
 	}
 }
 
 
 void FrameBuffer::Regenerate(float displaySizeX, float displaySizeY)
 {
-	glDeleteFramebuffers(1, &handle);
+	//All released first, so a size already in the pool (resizing back) takes its targets instead of new ones
+	std::vector<TexObj> previous;
+	previous.swap(textures);
 
-	int textureCount = textures.size();
+	int textureCount = previous.size();
 	for (int i = 0; i < textureCount; ++i)
 	{
-		PushTexture(displaySizeX, displaySizeY, textures[0].internalFormat, textures[0].format, textures[0].type);
+		GetRenderTargetPool().Release(previous[i].handle);
+	}
 
-		glDeleteTextures(1, &textures[0].handle);
-		textures.erase(textures.begin());
+	for (int i = 0; i < textureCount; ++i)
+	{
+		PushTexture(displaySizeX, displaySizeY, previous[i].internalFormat, previous[i].format, previous[i].type);
 	}
 
+	//Same framebuffer, only the attachments change
 	AttachTextures();
-
-	CheckStatus();
 }
 
 
 void FrameBuffer::PushTexture(float sizeX, float sizeY, int internalFormat, int format, int type)
 {
-	u32 texHandle;
-	glGenTextures(1, &texHandle);
+	//Immutable storage can't be empty, a minimized window is 0x0
+	RenderTargetDesc desc = { glm::max((int)sizeX, 1), glm::max((int)sizeY, 1), (u32)internalFormat };
+	u32 texHandle = GetRenderTargetPool().Acquire(desc, owner);
+
 	glBindTexture(GL_TEXTURE_2D, texHandle);
-	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, sizeX, sizeY, 0, format, type, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);	
@@ -67,9 +73,9 @@ void FrameBuffer::PushTexture(float sizeX, float sizeY, int internalFormat, int
 
 void FrameBuffer::AttachTextures()
 {
-	glDeleteFramebuffers(1, &handle);
+	if (handle == 0)
+		glGenFramebuffers(1, &handle);
 
-	glGenFramebuffers(1, &handle);
 	glBindFramebuffer(GL_FRAMEBUFFER, handle);
 	
 	int textureCount = textures.size();
@@ -118,6 +124,7 @@ void FrameBuffer::Unbind()
 void FrameBuffer::ClearColorAttachments()
 {
 	glDeleteFramebuffers(1, &handle);
+	handle = 0;
 }
 
 
@@ -38,4 +38,7 @@ public:
 	u32 handle;
 	
 	std::vector<TexObj> textures;
+
+	//Shown by the gpu memory tracker for the textures pushed
+	const char* owner;
 };
\ No newline at end of file
@@ -0,0 +1,497 @@
+#include "FrameCapture.h"
+
+#include "engine.h"
+#include "GpuMemory.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+
+#include <stb_image_write.h>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <signal.h>
+#endif
+
+FrameCapture::FrameCapture()
+{
+	thread = std::thread(&FrameCapture::WorkerLoop, this);
+}
+
+
+FrameCapture::~FrameCapture()
+{
+	//Finishes what is in flight, the last frames of a video would be lost otherwise
+	StopVideo();
+	Poll(true);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wakeCondition.notify_one();
+
+	thread.join();
+
+	for (u32 i = 0; i < CAPTURE_RING_SIZE; ++i)
+	{
+		if (readbacks[i].buffer != 0)
+		{
+			GetGpuMemory().ReleaseBuffer(readbacks[i].buffer);
+			glDeleteBuffers(1, &readbacks[i].buffer);
+		}
+	}
+}
+
+
+void FrameCapture::RequestScreenshot(CAPTURE_SOURCE source, CAPTURE_FORMAT format)
+{
+	requests.push_back({ source, format });
+}
+
+
+bool FrameCapture::StartVideo(int sizeX, int sizeY)
+{
+	if (recording == true)
+		return true;
+
+	if (closeVideoPending == true)
+	{
+		ELOG("Capture: the previous video is still being written");
+		return false;
+	}
+
+	//The rows come bottom up from gl
+	char command[512];
+	snprintf(command, sizeof(command), "ffmpeg -y -loglevel error -f rawvideo -pix_fmt rgba -s %ix%i -r %i -i - -vf vflip "
+		"-c:v libx264 -pix_fmt yuv420p -crf 18 %s", sizeX, sizeY, CAPTURE_VIDEO_FRAME_RATE, CAPTURE_VIDEO_FILE);
+
+#ifndef _WIN32
+	//A closed pipe is reported by fwrite instead of killing the process
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+#ifdef _WIN32
+	videoPipe = popen(command, "wb");
+#else
+	videoPipe = popen(command, "w");
+#endif
+
+	if (videoPipe == nullptr)
+	{
+		ELOG("Capture: can't start ffmpeg");
+		return false;
+	}
+
+	videoSizeX = sizeX;
+	videoSizeY = sizeY;
+	videoFrameCount = 0;
+	recording = true;
+
+	ILOG("Capture: recording %ix%i to %s", sizeX, sizeY, CAPTURE_VIDEO_FILE);
+
+	return true;
+}
+
+
+void FrameCapture::StopVideo()
+{
+	if (recording == false)
+		return;
+
+	//The pipe is closed once the frames still in the readbacks are written
+	recording = false;
+	closeVideoPending = true;
+}
+
+
+bool FrameCapture::IsRecording() const
+{
+	return recording;
+}
+
+
+void FrameCapture::Capture(App* app)
+{
+	CPU_PROFILE_FUNCTION();
+
+	if (recording == true)
+	{
+		if (app->displaySize.x != videoSizeX || app->displaySize.y != videoSizeY)
+		{
+			ELOG("Capture: the window was resized, the recording stops");
+			StopVideo();
+		}
+		else
+			IssueReadback(app, CAPTURE_SOURCE::FINAL, CAPTURE_FORMAT::PNG, true);
+	}
+
+	for (u32 i = 0; i < requests.size(); ++i)
+	{
+		IssueReadback(app, requests[i].source, requests[i].format, false);
+	}
+
+	requests.clear();
+}
+
+
+u32 FrameCapture::GetPendingSources() const
+{
+	u32 sources = recording ? 1u << (u32)CAPTURE_SOURCE::FINAL : 0u;
+
+	for (u32 i = 0; i < requests.size(); ++i)
+	{
+		sources |= 1u << (u32)requests[i].source;
+	}
+
+	return sources;
+}
+
+
+void FrameCapture::Poll(bool waitForGpu)
+{
+	CPU_PROFILE_FUNCTION();
+
+	//In the order they were issued, so the video frames stay in order
+	while (pendingCount > 0)
+	{
+		CaptureReadback& readback = readbacks[(nextReadback + CAPTURE_RING_SIZE - pendingCount) % CAPTURE_RING_SIZE];
+
+		GLenum result = waitForGpu ? glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_MAX) : glClientWaitSync(readback.fence, 0, 0);
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+			break;
+
+		TakeReadback(readback);
+		pendingCount--;
+	}
+
+	if (closeVideoPending == true)
+	{
+		bool videoPending = false;
+		for (u32 i = 0; i < pendingCount; ++i)
+		{
+			if (readbacks[(nextReadback + CAPTURE_RING_SIZE - 1 - i) % CAPTURE_RING_SIZE].video == true)
+				videoPending = true;
+		}
+
+		if (videoPending == false)
+		{
+			CaptureJob job;
+			job.videoPipe = videoPipe;
+			job.closeVideo = true;
+			PushJob(job, false);
+
+			ILOG("Capture: %u frames sent to %s", videoFrameCount, CAPTURE_VIDEO_FILE);
+
+			videoPipe = nullptr;
+			closeVideoPending = false;
+		}
+	}
+}
+
+
+const char* FrameCapture::GetSourceName(CAPTURE_SOURCE source)
+{
+	switch (source)
+	{
+	case CAPTURE_SOURCE::FINAL: return "Final";
+	case CAPTURE_SOURCE::ALBEDO: return "Albedo";
+	case CAPTURE_SOURCE::NORMALS: return "Normals";
+	case CAPTURE_SOURCE::WORLD_POS: return "WorldPos";
+	case CAPTURE_SOURCE::COLOR: return "Color";
+	case CAPTURE_SOURCE::REFLECTIVITY: return "Reflectivity";
+	case CAPTURE_SOURCE::DEPTH: return "Depth";
+	case CAPTURE_SOURCE::VELOCITY: return "Velocity";
+	case CAPTURE_SOURCE::MAX: break;
+	}
+
+	return "Unknown";
+}
+
+
+void FrameCapture::IssueReadback(App* app, CAPTURE_SOURCE source, CAPTURE_FORMAT format, bool video)
+{
+	//The gpu is still behind on every readback, waiting here is the stall this avoids
+	if (pendingCount == CAPTURE_RING_SIZE)
+	{
+		droppedCount++;
+		return;
+	}
+
+	//Forward rendering doesn't fill the g-buffer
+	if (source != CAPTURE_SOURCE::FINAL && app->mode != Mode_Deferred)
+	{
+		ILOG("Capture: the %s target is only rendered in deferred mode, capturing the final image", GetSourceName(source));
+		source = CAPTURE_SOURCE::FINAL;
+	}
+
+	GPU_PROFILE_SCOPE(app, "Capture");
+
+	CaptureReadback& readback = readbacks[nextReadback];
+	readback.source = source;
+	readback.format = format;
+	readback.video = video;
+
+	GLenum readFormat;
+	GLenum readType;
+
+	if (source == CAPTURE_SOURCE::FINAL)
+	{
+		readback.sizeX = app->displaySize.x;
+		readback.sizeY = app->displaySize.y;
+		readback.channels = 4;
+		readback.isFloat = false;
+
+		readFormat = GL_RGBA;
+		readType = GL_UNSIGNED_BYTE;
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glReadBuffer(GL_BACK);
+	}
+	else
+	{
+		//Only the render size is drawn to when the resolution is scaled
+		readback.sizeX = app->renderSize.x;
+		readback.sizeY = app->renderSize.y;
+		readback.isFloat = true;
+		readType = GL_FLOAT;
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, app->framebuffer.handle);
+
+		switch (source)
+		{
+		case CAPTURE_SOURCE::DEPTH:
+			readback.channels = 1;
+			readFormat = GL_DEPTH_COMPONENT;
+			break;
+
+		case CAPTURE_SOURCE::REFLECTIVITY:
+			readback.channels = 1;
+			readFormat = GL_RED;
+			glReadBuffer(GL_COLOR_ATTACHMENT4);
+			break;
+
+		case CAPTURE_SOURCE::VELOCITY:
+			//Two channel images are grey and alpha, blue stays empty instead
+			readback.channels = 3;
+			readFormat = GL_RGB;
+			glReadBuffer(GL_COLOR_ATTACHMENT6);
+			break;
+
+		default:
+			readback.channels = 3;
+			readFormat = GL_RGB;
+			glReadBuffer(GL_COLOR_ATTACHMENT0 + ((int)source - (int)CAPTURE_SOURCE::ALBEDO));
+			break;
+		}
+	}
+
+	u32 size = readback.sizeX * readback.sizeY * readback.channels * (readback.isFloat ? sizeof(float) : sizeof(u8));
+
+	if (readback.buffer == 0)
+		glGenBuffers(1, &readback.buffer);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+
+	if (readback.capacity < size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		GetGpuMemory().TrackBuffer(readback.buffer, GPU_MEMORY_CATEGORY::CAPTURE, "Frame capture", size);
+
+		readback.capacity = size;
+	}
+
+	//Every row is a multiple of 4 bytes, the default pack alignment is fine
+	glReadPixels(0, 0, readback.sizeX, readback.sizeY, readFormat, readType, NULL);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (source != CAPTURE_SOURCE::FINAL)
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	nextReadback = (nextReadback + 1) % CAPTURE_RING_SIZE;
+	pendingCount++;
+}
+
+
+void FrameCapture::TakeReadback(CaptureReadback& readback)
+{
+	CPU_PROFILE_FUNCTION();
+
+	glDeleteSync(readback.fence);
+	readback.fence = nullptr;
+
+	u32 size = readback.sizeX * readback.sizeY * readback.channels * (readback.isFloat ? sizeof(float) : sizeof(u8));
+
+	//A video frame isn't worth copying if the worker can't take it
+	if (readback.video == true && videoPipe == nullptr)
+		return;
+
+	CaptureJob job;
+	job.pixels.resize(size);
+	job.sizeX = readback.sizeX;
+	job.sizeY = readback.sizeY;
+	job.channels = readback.channels;
+	job.isFloat = readback.isFloat;
+	job.format = readback.format;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+
+	void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	if (data != nullptr)
+	{
+		memcpy(job.pixels.data(), data, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (data == nullptr)
+	{
+		ELOG("Capture: can't map the readback buffer");
+		return;
+	}
+
+	if (readback.video == true)
+	{
+		job.videoPipe = videoPipe;
+		videoFrameCount++;
+
+		//Dropped rather than queued without limit if the encoder is slower than the frame rate
+		PushJob(job, true);
+	}
+	else
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "Capture_%05u_%s.%s", screenshotCount++, GetSourceName(readback.source),
+			readback.format == CAPTURE_FORMAT::HDR ? "hdr" : "png");
+
+		job.path = path;
+		PushJob(job, false);
+	}
+
+	capturedCount++;
+}
+
+
+void FrameCapture::PushJob(CaptureJob& job, bool canDrop)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if (canDrop == true && jobs.size() >= CAPTURE_MAX_QUEUED_JOBS)
+		{
+			droppedCount++;
+			return;
+		}
+
+		jobs.push_back(std::move(job));
+	}
+
+	wakeCondition.notify_one();
+}
+
+
+void FrameCapture::WorkerLoop()
+{
+	SetProfilerThreadName("Capture worker");
+
+	while (true)
+	{
+		CaptureJob job;
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeCondition.wait(lock, [this]() { return quit == true || jobs.empty() == false; });
+
+			//The queue is emptied before quitting
+			if (jobs.empty() == true)
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		WriteJob(job);
+	}
+}
+
+
+void FrameCapture::WriteJob(CaptureJob& job)
+{
+	CPU_PROFILE_FUNCTION();
+
+	if (job.closeVideo == true)
+	{
+		if (pclose(job.videoPipe) != 0)
+		{
+			ELOG("Capture: ffmpeg failed writing %s, is it in the path?", CAPTURE_VIDEO_FILE);
+		}
+		else
+		{
+			ILOG("Capture: %s written", CAPTURE_VIDEO_FILE);
+		}
+
+		videoPipeBroken = false;
+		return;
+	}
+
+	if (job.videoPipe != nullptr)
+	{
+		if (videoPipeBroken == false && fwrite(job.pixels.data(), 1, job.pixels.size(), job.videoPipe) != job.pixels.size())
+		{
+			ELOG("Capture: ffmpeg stopped taking frames");
+			videoPipeBroken = true;
+		}
+
+		return;
+	}
+
+	u32 valueCount = job.sizeX * job.sizeY * job.channels;
+	int result = 0;
+
+	stbi_flip_vertically_on_write(1);
+
+	if (job.format == CAPTURE_FORMAT::HDR)
+	{
+		if (job.isFloat == true)
+			result = stbi_write_hdr(job.path.c_str(), job.sizeX, job.sizeY, job.channels, (const float*)job.pixels.data());
+		else
+		{
+			std::vector<float> values(valueCount);
+			for (u32 i = 0; i < valueCount; ++i)
+				values[i] = job.pixels[i] / 255.f;
+
+			result = stbi_write_hdr(job.path.c_str(), job.sizeX, job.sizeY, job.channels, values.data());
+		}
+	}
+	else
+	{
+		if (job.isFloat == true)
+		{
+			//Clamped, the hdr format keeps the values outside [0, 1]
+			const float* floats = (const float*)job.pixels.data();
+
+			std::vector<u8> values(valueCount);
+			for (u32 i = 0; i < valueCount; ++i)
+				values[i] = (u8)(glm::clamp(floats[i], 0.f, 1.f) * 255.f + 0.5f);
+
+			result = stbi_write_png(job.path.c_str(), job.sizeX, job.sizeY, job.channels, values.data(), job.sizeX * job.channels);
+		}
+		else
+			result = stbi_write_png(job.path.c_str(), job.sizeX, job.sizeY, job.channels, job.pixels.data(), job.sizeX * job.channels);
+	}
+
+	if (result == 0)
+	{
+		ELOG("Capture: can't write %s", job.path.c_str());
+	}
+	else
+	{
+		ILOG("Capture: %s written", job.path.c_str());
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "platform.h"
+
+#include <glad/glad.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+#define CAPTURE_RING_SIZE 3			//Readbacks in flight, with more the gpu is so far behind that the frame is dropped
+#define CAPTURE_MAX_QUEUED_JOBS 8	//Frames waiting for the worker, more are dropped instead of piling up memory
+#define CAPTURE_VIDEO_FRAME_RATE 60
+#define CAPTURE_VIDEO_FILE "Capture.mp4"
+
+struct App;
+
+enum class CAPTURE_SOURCE : int
+{
+	FINAL = 0,		//What the window shows, without the gui
+	ALBEDO,			//G-buffer attachments, in their order
+	NORMALS,
+	WORLD_POS,
+	COLOR,
+	REFLECTIVITY,
+	DEPTH,
+	VELOCITY,
+	MAX
+};
+
+
+enum class CAPTURE_FORMAT : int
+{
+	PNG = 0,
+	HDR,			//Radiance float image, keeps the values of the float attachments
+	MAX
+};
+
+
+struct CaptureRequest
+{
+	CAPTURE_SOURCE source;
+	CAPTURE_FORMAT format;
+};
+
+
+//Pixel pack buffer the pixels of a frame are copied to, mapped once its fence signals
+struct CaptureReadback
+{
+	u32 buffer = 0;
+	u32 capacity = 0;
+	GLsync fence = nullptr;
+
+	CAPTURE_SOURCE source;
+	CAPTURE_FORMAT format;
+	bool video;
+
+	int sizeX;
+	int sizeY;
+	u32 channels;
+	bool isFloat;
+};
+
+
+//Work for the encoding thread, a frame to write or the end of a video
+struct CaptureJob
+{
+	std::vector<u8> pixels;
+	int sizeX;
+	int sizeY;
+	u32 channels;
+	bool isFloat;
+
+	CAPTURE_FORMAT format;
+	std::string path;
+
+	FILE* videoPipe = nullptr;		//Frames are written to it, null for images
+	bool closeVideo = false;
+};
+
+
+//Copies frames to a ring of pixel pack buffers and reads them some frames later, after their fence signals,
+//so the render loop never waits for the gpu. The pixels are encoded on a worker thread: screenshots to png or
+//hdr files, videos as raw frames piped to ffmpeg, which has to be in the path.
+class FrameCapture
+{
+public:
+	FrameCapture();
+	~FrameCapture();
+
+	void RequestScreenshot(CAPTURE_SOURCE source, CAPTURE_FORMAT format);
+
+	//The final frame of every frame until it stops, the size can't change meanwhile
+	bool StartVideo(int sizeX, int sizeY);
+	void StopVideo();
+	bool IsRecording() const;
+
+	//Issues the readbacks of this frame, after it is rendered and before the gui
+	void Capture(App* app);
+
+	//Bit per CAPTURE_SOURCE read back by the next Capture(), so the render graph keeps the passes that draw them
+	u32 GetPendingSources() const;
+
+	//Takes the readbacks the gpu already finished, waiting for the rest only if asked
+	void Poll(bool waitForGpu = false);
+
+	static const char* GetSourceName(CAPTURE_SOURCE source);
+
+private:
+	void IssueReadback(App* app, CAPTURE_SOURCE source, CAPTURE_FORMAT format, bool video);
+	void TakeReadback(CaptureReadback& readback);
+	void PushJob(CaptureJob& job, bool canDrop);
+
+	void WorkerLoop();
+	void WriteJob(CaptureJob& job);
+
+public:
+	CAPTURE_SOURCE source = CAPTURE_SOURCE::FINAL;
+	CAPTURE_FORMAT format = CAPTURE_FORMAT::PNG;
+
+	u32 capturedCount = 0;
+	u32 droppedCount = 0;		//No free readback or too many jobs queued
+	u32 videoFrameCount = 0;
+
+private:
+	CaptureReadback readbacks[CAPTURE_RING_SIZE];
+	u32 nextReadback = 0;
+	u32 pendingCount = 0;
+
+	std::vector<CaptureRequest> requests;		//Screenshots of the next frame
+	u32 screenshotCount = 0;
+
+	FILE* videoPipe = nullptr;
+	int videoSizeX = 0;
+	int videoSizeY = 0;
+	bool recording = false;
+	bool closeVideoPending = false;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable wakeCondition;
+	std::deque<CaptureJob> jobs;
+	bool quit = false;
+
+	bool videoPipeBroken = false;		//Only touched by the worker
+};
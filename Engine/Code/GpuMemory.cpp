@@ -0,0 +1,332 @@
+#include "GpuMemory.h"
+
+#include "glad/glad.h"
+
+GpuMemoryTracker::GpuMemoryTracker()
+{
+	budgets[(int)GPU_MEMORY_CATEGORY::TEXTURE] = MB(512);
+	budgets[(int)GPU_MEMORY_CATEGORY::RENDER_TARGET] = MB(256);
+	budgets[(int)GPU_MEMORY_CATEGORY::MESH] = MB(256);
+	budgets[(int)GPU_MEMORY_CATEGORY::UNIFORM] = MB(16);
+	budgets[(int)GPU_MEMORY_CATEGORY::STORAGE] = MB(64);
+	budgets[(int)GPU_MEMORY_CATEGORY::READBACK] = MB(1);
+	budgets[(int)GPU_MEMORY_CATEGORY::CAPTURE] = MB(96);	//A ring of 3 float rgb readbacks at 1080p
+	budgets[(int)GPU_MEMORY_CATEGORY::ENVIRONMENT] = MB(64);
+}
+
+
+void GpuMemoryTracker::TrackTexture(u32 handle, GPU_MEMORY_CATEGORY category, const char* owner, u32 internalFormat, u32 sizeX, u32 sizeY, u32 layers, u32 mipCount)
+{
+	GpuAllocation allocation = {};
+	allocation.type = GPU_RESOURCE_TYPE::TEXTURE;
+	allocation.handle = handle;
+	allocation.category = category;
+	allocation.owner = owner;
+	allocation.internalFormat = internalFormat;
+	allocation.sizeX = sizeX;
+	allocation.sizeY = sizeY;
+	allocation.layers = layers;
+	allocation.mipCount = mipCount;
+	allocation.bytes = GetTextureSize(internalFormat, sizeX, sizeY, layers, mipCount);
+
+	Track(allocation);
+}
+
+
+void GpuMemoryTracker::TrackBuffer(u32 handle, GPU_MEMORY_CATEGORY category, const char* owner, u64 size)
+{
+	GpuAllocation allocation = {};
+	allocation.type = GPU_RESOURCE_TYPE::BUFFER;
+	allocation.handle = handle;
+	allocation.category = category;
+	allocation.owner = owner;
+	allocation.sizeX = size;
+	allocation.sizeY = 1;
+	allocation.layers = 1;
+	allocation.mipCount = 1;
+	allocation.bytes = size;
+
+	Track(allocation);
+}
+
+
+void GpuMemoryTracker::TrackRenderbuffer(u32 handle, GPU_MEMORY_CATEGORY category, const char* owner, u32 internalFormat, u32 sizeX, u32 sizeY)
+{
+	GpuAllocation allocation = {};
+	allocation.type = GPU_RESOURCE_TYPE::RENDERBUFFER;
+	allocation.handle = handle;
+	allocation.category = category;
+	allocation.owner = owner;
+	allocation.internalFormat = internalFormat;
+	allocation.sizeX = sizeX;
+	allocation.sizeY = sizeY;
+	allocation.layers = 1;
+	allocation.mipCount = 1;
+	allocation.bytes = GetTextureSize(internalFormat, sizeX, sizeY, 1, 1);
+
+	Track(allocation);
+}
+
+
+void GpuMemoryTracker::ReleaseTexture(u32 handle)
+{
+	Release(GPU_RESOURCE_TYPE::TEXTURE, handle);
+}
+
+
+void GpuMemoryTracker::ReleaseBuffer(u32 handle)
+{
+	Release(GPU_RESOURCE_TYPE::BUFFER, handle);
+}
+
+
+void GpuMemoryTracker::ReleaseRenderbuffer(u32 handle)
+{
+	Release(GPU_RESOURCE_TYPE::RENDERBUFFER, handle);
+}
+
+
+void GpuMemoryTracker::SetLeakMark()
+{
+	leakMark = nextSerial;
+}
+
+
+void GpuMemoryTracker::GetAllocationsSinceMark(std::vector<const GpuAllocation*>& result) const
+{
+	result.clear();
+
+	for (const std::pair<const u64, GpuAllocation>& entry : allocations)
+	{
+		if (entry.second.serial >= leakMark)
+			result.push_back(&entry.second);
+	}
+}
+
+
+u32 GpuMemoryTracker::RemoveStaleAllocations()
+{
+	std::vector<u64> staleKeys;
+
+	for (const std::pair<const u64, GpuAllocation>& entry : allocations)
+	{
+		const GpuAllocation& allocation = entry.second;
+		bool alive = true;
+
+		switch (allocation.type)
+		{
+		case GPU_RESOURCE_TYPE::TEXTURE:		alive = glIsTexture(allocation.handle) == GL_TRUE; break;
+		case GPU_RESOURCE_TYPE::BUFFER:			alive = glIsBuffer(allocation.handle) == GL_TRUE; break;
+		case GPU_RESOURCE_TYPE::RENDERBUFFER:	alive = glIsRenderbuffer(allocation.handle) == GL_TRUE; break;
+		case GPU_RESOURCE_TYPE::MAX:			ASSERT(false, "Invalid gpu resource type"); break;
+		}
+
+		if (alive == false)
+		{
+			ELOG("%s %u of %s was deleted without being released", GetGpuResourceTypeName(allocation.type), allocation.handle, allocation.owner.c_str());
+			staleKeys.push_back(entry.first);
+		}
+	}
+
+	for (u64 key : staleKeys)
+		Release(allocations[key].type, allocations[key].handle);
+
+	return staleKeys.size();
+}
+
+
+const std::unordered_map<u64, GpuAllocation>& GpuMemoryTracker::GetAllocations() const
+{
+	return allocations;
+}
+
+
+bool GpuMemoryTracker::WriteDump(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing the gpu memory dump %s", path);
+		return false;
+	}
+
+	fprintf(file, "type,handle,category,owner,internalFormat,sizeX,sizeY,layers,mips,bytes\n");
+
+	for (const std::pair<const u64, GpuAllocation>& entry : allocations)
+	{
+		const GpuAllocation& allocation = entry.second;
+
+		fprintf(file, "%s,%u,%s,\"%s\",0x%x,%u,%u,%u,%u,%llu\n",
+			GetGpuResourceTypeName(allocation.type),
+			allocation.handle,
+			GetGpuMemoryCategoryName(allocation.category),
+			allocation.owner.c_str(),
+			allocation.internalFormat,
+			allocation.sizeX,
+			allocation.sizeY,
+			allocation.layers,
+			allocation.mipCount,
+			(unsigned long long)allocation.bytes);
+	}
+
+	fclose(file);
+
+	ILOG("Gpu memory dump written to %s, %u allocations", path, (u32)allocations.size());
+	return true;
+}
+
+
+//Bytes of the formats the engine uses. Three channel formats are counted with four, drivers usually pad them
+u32 GpuMemoryTracker::GetBytesPerPixel(u32 internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R8:						return 1;
+	case GL_RG8:					return 2;
+	case GL_RGB8:					return 4;
+	case GL_RGBA8:					return 4;
+	case GL_SRGB8_ALPHA8:			return 4;
+	case GL_R16F:					return 2;
+	case GL_RG16F:					return 4;
+	case GL_RGB16F:					return 8;
+	case GL_RGBA16F:				return 8;
+	case GL_R32F:					return 4;
+	case GL_RG32F:					return 8;
+	case GL_RGB32F:					return 16;
+	case GL_RGBA32F:				return 16;
+	case GL_R11F_G11F_B10F:			return 4;
+	case GL_DEPTH_COMPONENT16:		return 2;
+	case GL_DEPTH_COMPONENT24:		return 4;
+	case GL_DEPTH_COMPONENT32F:		return 4;
+	case GL_DEPTH24_STENCIL8:		return 4;
+
+	default:
+		return 4;
+	}
+}
+
+
+u32 GpuMemoryTracker::GetMipCount(u32 sizeX, u32 sizeY)
+{
+	return 1 + (u32)floor(log2((float)glm::max(glm::max(sizeX, sizeY), 1u)));
+}
+
+
+u64 GpuMemoryTracker::GetTextureSize(u32 internalFormat, u32 sizeX, u32 sizeY, u32 layers, u32 mipCount)
+{
+	u64 bytesPerPixel = GetBytesPerPixel(internalFormat);
+	u64 size = 0;
+
+	for (u32 i = 0; i < mipCount; ++i)
+	{
+		size += glm::max(sizeX >> i, 1u) * glm::max(sizeY >> i, 1u) * bytesPerPixel;
+	}
+
+	return size * layers;
+}
+
+
+void GpuMemoryTracker::Track(const GpuAllocation& allocation)
+{
+	u64 key = MakeKey(allocation.type, allocation.handle);
+
+	//Storage specified again for the same object
+	if (allocations.find(key) != allocations.end())
+		Release(allocation.type, allocation.handle);
+
+	GpuAllocation& stored = allocations[key];
+	stored = allocation;
+	stored.serial = nextSerial++;
+
+	int category = (int)allocation.category;
+	categoryBytes[category] += allocation.bytes;
+	categoryCounts[category]++;
+	categoryPeaks[category] = glm::max(categoryPeaks[category], categoryBytes[category]);
+
+	totalBytes += allocation.bytes;
+	totalPeak = glm::max(totalPeak, totalBytes);
+
+	CheckBudget(allocation.category);
+}
+
+
+void GpuMemoryTracker::Release(GPU_RESOURCE_TYPE type, u32 handle)
+{
+	if (handle == 0)
+		return;
+
+	std::unordered_map<u64, GpuAllocation>::iterator it = allocations.find(MakeKey(type, handle));
+
+	if (it == allocations.end())
+		return;
+
+	int category = (int)it->second.category;
+	categoryBytes[category] -= it->second.bytes;
+	categoryCounts[category]--;
+	totalBytes -= it->second.bytes;
+
+	GPU_MEMORY_CATEGORY releasedCategory = it->second.category;
+	allocations.erase(it);
+
+	CheckBudget(releasedCategory);
+}
+
+
+//Logs once every time a category goes over its budget
+void GpuMemoryTracker::CheckBudget(GPU_MEMORY_CATEGORY category)
+{
+	int idx = (int)category;
+	bool over = categoryBytes[idx] > budgets[idx];
+
+	if (over == true && overBudget[idx] == false)
+		ELOG("Gpu memory of %s over budget: %.2f MB of %.2f MB", GetGpuMemoryCategoryName(category), categoryBytes[idx] / (1024.0 * 1024.0), budgets[idx] / (1024.0 * 1024.0));
+
+	overBudget[idx] = over;
+}
+
+
+u64 GpuMemoryTracker::MakeKey(GPU_RESOURCE_TYPE type, u32 handle)
+{
+	return ((u64)type << 32) | handle;
+}
+
+
+GpuMemoryTracker& GetGpuMemory()
+{
+	static GpuMemoryTracker tracker;
+	return tracker;
+}
+
+
+const char* GetGpuMemoryCategoryName(GPU_MEMORY_CATEGORY category)
+{
+	switch (category)
+	{
+	case GPU_MEMORY_CATEGORY::TEXTURE:			return "Textures";
+	case GPU_MEMORY_CATEGORY::RENDER_TARGET:	return "Render targets";
+	case GPU_MEMORY_CATEGORY::MESH:				return "Meshes";
+	case GPU_MEMORY_CATEGORY::UNIFORM:			return "Uniform buffers";
+	case GPU_MEMORY_CATEGORY::STORAGE:			return "Storage buffers";
+	case GPU_MEMORY_CATEGORY::READBACK:			return "Readback";
+	case GPU_MEMORY_CATEGORY::CAPTURE:			return "Frame capture";
+	case GPU_MEMORY_CATEGORY::ENVIRONMENT:		return "Environment";
+
+	default:
+		return "Unknown";
+	}
+}
+
+
+const char* GetGpuResourceTypeName(GPU_RESOURCE_TYPE type)
+{
+	switch (type)
+	{
+	case GPU_RESOURCE_TYPE::TEXTURE:		return "Texture";
+	case GPU_RESOURCE_TYPE::BUFFER:			return "Buffer";
+	case GPU_RESOURCE_TYPE::RENDERBUFFER:	return "Renderbuffer";
+
+	default:
+		return "Unknown";
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "platform.h"
+
+#include <unordered_map>
+
+#define GPU_MEMORY_DUMP_FILE "GpuMemory.csv"
+
+enum class GPU_MEMORY_CATEGORY : int
+{
+	TEXTURE = 0,		//Material textures
+	RENDER_TARGET,
+	MESH,
+	UNIFORM,
+	STORAGE,			//Shader storage and indirect buffers
+	READBACK,
+	CAPTURE,			//Pixel pack buffers of the frame capture ring
+	ENVIRONMENT,		//Skybox and irradiance cubemaps
+	MAX
+};
+
+
+enum class GPU_RESOURCE_TYPE : int
+{
+	TEXTURE = 0,
+	BUFFER,
+	RENDERBUFFER,
+	MAX
+};
+
+
+//One live gl object, the size is an estimate made from its format and dimensions
+struct GpuAllocation
+{
+	GPU_RESOURCE_TYPE type;
+	u32 handle;
+
+	GPU_MEMORY_CATEGORY category;
+	std::string owner;
+
+	u32 internalFormat;		//0 for buffers
+	u32 sizeX;
+	u32 sizeY;
+	u32 layers;
+	u32 mipCount;
+
+	u64 bytes;
+	u64 serial;				//Order of creation, to find what was allocated after a mark
+};
+
+
+//Keeps track of every texture, buffer and renderbuffer the engine allocates. The driver doesn't report how much
+//memory an object takes, so sizes are computed from the format and dimensions and don't include padding or
+//compression. Each allocation has to be tracked right after its storage is specified and released before it is
+//deleted. Tracking a handle again replaces its previous size, for buffers that are resized with glBufferData.
+//Only used from the thread that owns the gl context.
+class GpuMemoryTracker
+{
+public:
+	GpuMemoryTracker();
+
+	void TrackTexture(u32 handle, GPU_MEMORY_CATEGORY category, const char* owner, u32 internalFormat, u32 sizeX, u32 sizeY, u32 layers = 1, u32 mipCount = 1);
+	void TrackBuffer(u32 handle, GPU_MEMORY_CATEGORY category, const char* owner, u64 size);
+	void TrackRenderbuffer(u32 handle, GPU_MEMORY_CATEGORY category, const char* owner, u32 internalFormat, u32 sizeX, u32 sizeY);
+
+	void ReleaseTexture(u32 handle);
+	void ReleaseBuffer(u32 handle);
+	void ReleaseRenderbuffer(u32 handle);
+
+	//Allocations made after the mark that are still alive, what grows here across resizes or reloads is a leak
+	void SetLeakMark();
+	void GetAllocationsSinceMark(std::vector<const GpuAllocation*>& result) const;
+
+	//Drops tracked objects the driver doesn't know anymore, they were deleted without being released. Returns how many
+	u32 RemoveStaleAllocations();
+
+	const std::unordered_map<u64, GpuAllocation>& GetAllocations() const;
+
+	//One line per allocation, comma separated
+	bool WriteDump(const char* path) const;
+
+	static u32 GetBytesPerPixel(u32 internalFormat);
+	static u32 GetMipCount(u32 sizeX, u32 sizeY);
+	static u64 GetTextureSize(u32 internalFormat, u32 sizeX, u32 sizeY, u32 layers, u32 mipCount);
+
+private:
+	void Track(const GpuAllocation& allocation);
+	void Release(GPU_RESOURCE_TYPE type, u32 handle);
+	void CheckBudget(GPU_MEMORY_CATEGORY category);
+
+	static u64 MakeKey(GPU_RESOURCE_TYPE type, u32 handle);
+
+public:
+	u64 budgets[(int)GPU_MEMORY_CATEGORY::MAX];
+
+	u64 categoryBytes[(int)GPU_MEMORY_CATEGORY::MAX] = {};
+	u64 categoryPeaks[(int)GPU_MEMORY_CATEGORY::MAX] = {};
+	u32 categoryCounts[(int)GPU_MEMORY_CATEGORY::MAX] = {};
+
+	u64 totalBytes = 0;
+	u64 totalPeak = 0;
+
+private:
+	std::unordered_map<u64, GpuAllocation> allocations;
+
+	bool overBudget[(int)GPU_MEMORY_CATEGORY::MAX] = {};
+
+	u64 nextSerial = 0;
+	u64 leakMark = 0;
+};
+
+
+GpuMemoryTracker& GetGpuMemory();
+
+const char* GetGpuMemoryCategoryName(GPU_MEMORY_CATEGORY category);
+const char* GetGpuResourceTypeName(GPU_RESOURCE_TYPE type);
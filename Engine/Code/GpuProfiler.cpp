@@ -0,0 +1,354 @@
+#include "GpuProfiler.h"
+
+#include "glad/glad.h"
+
+#include <algorithm>
+
+float GpuPassStats::GetPercentile(float p) const
+{
+	if (sampleCount == 0)
+		return 0.f;
+
+	float sorted[GPU_PROFILER_HISTORY];
+	memcpy(sorted, samples, sizeof(float) * sampleCount);
+	std::sort(sorted, sorted + sampleCount);
+
+	u32 idx = (u32)(glm::clamp(p, 0.f, 1.f) * (sampleCount - 1) + 0.5f);
+	return sorted[idx];
+}
+
+
+float GpuPassStats::GetMax() const
+{
+	float result = 0.f;
+
+	for (u32 i = 0; i < sampleCount; ++i)
+		result = glm::max(result, samples[i]);
+
+	return result;
+}
+
+
+GpuProfiler::GpuProfiler()
+{
+	for (int i = 0; i < GPU_PROFILER_FRAME_COUNT; ++i)
+	{
+		glGenQueries(GPU_PROFILER_MAX_SCOPES * 2, frames[i].queries);
+		frames[i].scopeCount = 0;
+		frames[i].issued = false;
+	}
+}
+
+
+GpuProfiler::~GpuProfiler()
+{
+	for (int i = 0; i < GPU_PROFILER_FRAME_COUNT; ++i)
+		glDeleteQueries(GPU_PROFILER_MAX_SCOPES * 2, frames[i].queries);
+}
+
+
+void GpuProfiler::BeginFrame()
+{
+	if (enabled == false)
+		return;
+
+	GpuProfilerFrame& frame = frames[currentFrame];
+
+	//Issued GPU_PROFILER_FRAME_COUNT frames ago
+	if (frame.issued == true)
+		ReadFrame(frame);
+
+	frame.scopeCount = 0;
+	openScopeCount = 0;
+	skippedDepth = 0;
+	inFrame = true;
+
+	BeginScope("Frame");
+}
+
+
+void GpuProfiler::EndFrame()
+{
+	if (inFrame == false)
+		return;
+
+	//Scopes left open end with the frame
+	while (openScopeCount > 0)
+		EndScope();
+
+	GpuProfilerFrame& frame = frames[currentFrame];
+	frame.issued = frame.scopeCount > 0;
+
+	currentFrame = (currentFrame + 1) % GPU_PROFILER_FRAME_COUNT;
+	inFrame = false;
+}
+
+
+void GpuProfiler::BeginScope(const char* name)
+{
+	if (inFrame == false)
+		return;
+
+	GpuProfilerFrame& frame = frames[currentFrame];
+
+	//Once a scope is skipped everything inside it is too, so the ends still match
+	if (skippedDepth > 0 || frame.scopeCount == GPU_PROFILER_MAX_SCOPES || openScopeCount == GPU_PROFILER_MAX_DEPTH)
+	{
+		skippedDepth++;
+		overflowScopes++;
+		return;
+	}
+
+	u32 scopeIdx = frame.scopeCount++;
+	frame.scopes[scopeIdx].name = name;
+	frame.scopes[scopeIdx].depth = openScopeCount;
+
+	glQueryCounter(frame.queries[scopeIdx * 2], GL_TIMESTAMP);
+
+	openScopes[openScopeCount++] = scopeIdx;
+}
+
+
+void GpuProfiler::EndScope()
+{
+	if (inFrame == false)
+		return;
+
+	if (skippedDepth > 0)
+	{
+		skippedDepth--;
+		return;
+	}
+
+	if (openScopeCount == 0)
+		return;
+
+	u32 scopeIdx = openScopes[--openScopeCount];
+	glQueryCounter(frames[currentFrame].queries[scopeIdx * 2 + 1], GL_TIMESTAMP);
+}
+
+
+const std::vector<GpuPassStats>& GpuProfiler::GetPassStats() const
+{
+	return passStats;
+}
+
+
+const std::vector<GpuTimelineEntry>& GpuProfiler::GetTimeline() const
+{
+	return timeline;
+}
+
+
+float GpuProfiler::GetFrameTime() const
+{
+	return frameTime;
+}
+
+
+void GpuProfiler::GetTraceEvents(std::vector<GpuTraceEvent>& result) const
+{
+	result.clear();
+
+	u64 count = glm::min(traceWriteCount, (u64)GPU_PROFILER_TRACE_SIZE);
+	for (u64 i = traceWriteCount - count; i < traceWriteCount; ++i)
+		result.push_back(traceEvents[i % GPU_PROFILER_TRACE_SIZE]);
+}
+
+
+u64 GpuProfiler::GetGpuTime() const
+{
+	GLint64 time = 0;
+	glGetInteger64v(GL_TIMESTAMP, &time);
+
+	return time;
+}
+
+
+bool GpuProfiler::WriteCsv(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing the gpu profile %s", path);
+		return false;
+	}
+
+	fprintf(file, "pass,depth,samples,last_ms,average_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+
+	for (const GpuPassStats& stats : passStats)
+	{
+		fprintf(file, "%s,%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", stats.name, stats.depth, stats.sampleCount, stats.last, stats.average,
+			stats.GetPercentile(0.5f), stats.GetPercentile(0.95f), stats.GetPercentile(0.99f), stats.GetMax());
+	}
+
+	fclose(file);
+
+	ILOG("Gpu profile written to %s", path);
+	return true;
+}
+
+
+bool GpuProfiler::WriteJson(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing the gpu profile %s", path);
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"frameTimeMs\": %.4f,\n\t\"droppedFrames\": %u,\n\t\"passes\": [\n", frameTime, droppedFrames);
+
+	u32 passCount = passStats.size();
+	for (u32 i = 0; i < passCount; ++i)
+	{
+		const GpuPassStats& stats = passStats[i];
+
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"depth\": %u, \"samples\": %u, \"lastMs\": %.4f, \"averageMs\": %.4f, \"p50Ms\": %.4f, \"p95Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f }%s\n",
+			stats.name, stats.depth, stats.sampleCount, stats.last, stats.average,
+			stats.GetPercentile(0.5f), stats.GetPercentile(0.95f), stats.GetPercentile(0.99f), stats.GetMax(),
+			i + 1 < passCount ? "," : "");
+	}
+
+	fprintf(file, "\t],\n\t\"timeline\": [\n");
+
+	u32 entryCount = timeline.size();
+	for (u32 i = 0; i < entryCount; ++i)
+	{
+		const GpuTimelineEntry& entry = timeline[i];
+
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"depth\": %u, \"startMs\": %.4f, \"endMs\": %.4f }%s\n",
+			entry.name, entry.depth, entry.start, entry.end, i + 1 < entryCount ? "," : "");
+	}
+
+	fprintf(file, "\t]\n}\n");
+	fclose(file);
+
+	ILOG("Gpu profile written to %s", path);
+	return true;
+}
+
+
+void GpuProfiler::ReadFrame(GpuProfilerFrame& frame)
+{
+	frame.issued = false;
+
+	//The end of the frame scope is the last query issued, if it is done all of them are
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (available == 0)
+	{
+		droppedFrames++;
+		return;
+	}
+
+	GLuint64 frameStart = 0;
+	glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &frameStart);
+
+	timeline.clear();
+
+	for (u32 i = 0; i < frame.scopeCount; ++i)
+	{
+		GLuint64 start = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+		GpuTimelineEntry entry;
+		entry.name = frame.scopes[i].name;
+		entry.depth = frame.scopes[i].depth;
+		entry.start = (start - frameStart) / 1000000.f;
+		entry.end = (end - frameStart) / 1000000.f;
+
+		timeline.push_back(entry);
+
+		GpuTraceEvent& traceEvent = traceEvents[traceWriteCount % GPU_PROFILER_TRACE_SIZE];
+		traceEvent.name = frame.scopes[i].name;
+		traceEvent.start = start;
+		traceEvent.end = end;
+		traceWriteCount++;
+	}
+
+	frameTime = timeline[0].end - timeline[0].start;
+
+	//Scopes with the same name are added up, a pass can be split in several calls
+	for (u32 i = 0; i < timeline.size(); ++i)
+	{
+		bool counted = false;
+		for (u32 j = 0; j < i; ++j)
+		{
+			if (strcmp(timeline[j].name, timeline[i].name) == 0)
+			{
+				counted = true;
+				break;
+			}
+		}
+
+		if (counted == true)
+			continue;
+
+		float time = 0.f;
+		for (u32 j = i; j < timeline.size(); ++j)
+		{
+			if (strcmp(timeline[j].name, timeline[i].name) == 0)
+				time += timeline[j].end - timeline[j].start;
+		}
+
+		AddSample(timeline[i].name, timeline[i].depth, time);
+	}
+}
+
+
+void GpuProfiler::AddSample(const char* name, u32 depth, float time)
+{
+	GpuPassStats* stats = nullptr;
+
+	for (GpuPassStats& pass : passStats)
+	{
+		if (strcmp(pass.name, name) == 0)
+		{
+			stats = &pass;
+			break;
+		}
+	}
+
+	if (stats == nullptr)
+	{
+		passStats.push_back(GpuPassStats{});
+		stats = &passStats.back();
+		stats->name = name;
+	}
+
+	stats->depth = depth;
+	stats->last = time;
+
+	stats->samples[stats->nextSample] = time;
+	stats->nextSample = (stats->nextSample + 1) % GPU_PROFILER_HISTORY;
+	stats->sampleCount = glm::min(stats->sampleCount + 1, (u32)GPU_PROFILER_HISTORY);
+	stats->totalSamples++;
+
+	float sum = 0.f;
+	for (u32 i = 0; i < stats->sampleCount; ++i)
+		sum += stats->samples[i];
+
+	stats->average = sum / stats->sampleCount;
+}
+
+
+GpuProfileScope::GpuProfileScope(GpuProfiler* profiler, const char* name) :
+	profiler(profiler)
+{
+	if (profiler != nullptr)
+		profiler->BeginScope(name);
+}
+
+
+GpuProfileScope::~GpuProfileScope()
+{
+	if (profiler != nullptr)
+		profiler->EndScope();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "platform.h"
+
+#define GPU_PROFILER_FRAME_COUNT 4		//Frames in flight before a result is read
+#define GPU_PROFILER_MAX_SCOPES 64		//Per frame
+#define GPU_PROFILER_MAX_DEPTH 8
+#define GPU_PROFILER_HISTORY 256		//Samples kept per pass for the averages and percentiles
+#define GPU_PROFILER_TRACE_SIZE 4096	//Scopes kept for the trace export
+
+#define GPU_PROFILER_CSV_FILE "GpuProfile.csv"
+#define GPU_PROFILER_JSON_FILE "GpuProfile.json"
+
+//Times the rest of the enclosing block on the gpu
+#define GPU_PROFILE_SCOPE(app, name) GpuProfileScope CONCAT(gpuProfileScope, __LINE__)((app)->gpuProfiler, name)
+
+//Scope issued in a frame, the names must be string literals
+struct GpuProfilerScope
+{
+	const char* name;
+	u32 depth;
+};
+
+
+//Queries of one frame, two timestamps per scope
+struct GpuProfilerFrame
+{
+	u32 queries[GPU_PROFILER_MAX_SCOPES * 2];
+	GpuProfilerScope scopes[GPU_PROFILER_MAX_SCOPES];
+	u32 scopeCount;
+	bool issued;
+};
+
+
+//Scope of the last frame read, relative to the start of the frame
+struct GpuTimelineEntry
+{
+	const char* name;
+	u32 depth;
+	float start;	//Milliseconds
+	float end;
+};
+
+
+//Scope in gpu time (nanoseconds), for the trace export
+struct GpuTraceEvent
+{
+	const char* name;
+	u64 start;
+	u64 end;
+};
+
+
+//History of one pass, scopes with the same name in a frame are added up
+struct GpuPassStats
+{
+	const char* name;
+	u32 depth;
+
+	float samples[GPU_PROFILER_HISTORY];
+	u32 sampleCount;
+	u32 nextSample;
+	u64 totalSamples;		//Including the ones out of the history
+
+	float last;
+	float average;
+
+	//Percentile of the history, p between 0 and 1
+	float GetPercentile(float p) const;
+	float GetMax() const;
+};
+
+
+//Gpu timings of named passes with timestamp queries. Every frame writes its own set of queries and they are
+//read GPU_PROFILER_FRAME_COUNT frames later, so the cpu never waits for the results. If they are still not
+//available the frame is dropped. Timestamps don't interfere with the time elapsed query of the dynamic
+//resolution and can be nested.
+class GpuProfiler
+{
+public:
+	GpuProfiler();
+	~GpuProfiler();
+
+	void BeginFrame();
+	void EndFrame();
+
+	//Ignored outside of a frame
+	void BeginScope(const char* name);
+	void EndScope();
+
+	const std::vector<GpuPassStats>& GetPassStats() const;
+	const std::vector<GpuTimelineEntry>& GetTimeline() const;
+	float GetFrameTime() const;
+
+	//Oldest first
+	void GetTraceEvents(std::vector<GpuTraceEvent>& result) const;
+
+	//Current gpu time, to put the trace events on the cpu clock
+	u64 GetGpuTime() const;
+
+	bool WriteCsv(const char* path) const;
+	bool WriteJson(const char* path) const;
+
+private:
+	void ReadFrame(GpuProfilerFrame& frame);
+	void AddSample(const char* name, u32 depth, float time);
+
+public:
+	bool enabled = true;
+
+	u32 droppedFrames = 0;
+	u32 overflowScopes = 0;
+
+private:
+	GpuProfilerFrame frames[GPU_PROFILER_FRAME_COUNT];
+	u32 currentFrame = 0;
+	bool inFrame = false;
+
+	u32 openScopes[GPU_PROFILER_MAX_DEPTH];
+	u32 openScopeCount = 0;
+	u32 skippedDepth = 0;		//Scopes opened while full or too deep, closed without a query
+
+	std::vector<GpuPassStats> passStats;
+	std::vector<GpuTimelineEntry> timeline;
+	float frameTime = 0.f;
+
+	GpuTraceEvent traceEvents[GPU_PROFILER_TRACE_SIZE];
+	u64 traceWriteCount = 0;
+};
+
+
+class GpuProfileScope
+{
+public:
+	GpuProfileScope(GpuProfiler* profiler, const char* name);
+	~GpuProfileScope();
+
+private:
+	GpuProfiler* profiler;
+};
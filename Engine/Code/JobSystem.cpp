@@ -0,0 +1,357 @@
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+
+static JobSystem* jobSystem = nullptr;
+static thread_local u32 jobThreadIdx = UINT32_MAX;
+
+JobSystem::JobSystem(u32 count) : queuedCount(0), executedCount(0), stolenCount(0)
+{
+	workerCount = glm::min(count, (u32)JOB_SYSTEM_MAX_WORKERS);
+
+	for (u32 i = 0; i < workerCount; ++i)
+	{
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i + 1));
+	}
+}
+
+
+JobSystem::~JobSystem()
+{
+	{
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		quit = true;
+	}
+	wakeCondition.notify_all();
+
+	for (u32 i = 0; i < workerCount; ++i)
+	{
+		workers[i].join();
+	}
+}
+
+
+void JobSystem::Run(const char* name, std::function<void()> function, JobCounter* counter, JobCounter* dependency)
+{
+	Job job;
+	job.function = std::move(function);
+	job.name = name;
+	job.counter = counter;
+	job.mainThread = false;
+
+	Submit(job, dependency);
+}
+
+
+void JobSystem::RunOnMainThread(const char* name, std::function<void()> function, JobCounter* counter, JobCounter* dependency)
+{
+	Job job;
+	job.function = std::move(function);
+	job.name = name;
+	job.counter = counter;
+	job.mainThread = true;
+
+	Submit(job, dependency);
+}
+
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	CPU_PROFILE_FUNCTION();
+
+	u32 threadIdx = jobThreadIdx;
+	u32 spinCount = 0;
+
+	while (counter.pending.load() > 0)
+	{
+		//Other threads can only wait, the jobs expect the index of a job system thread
+		if (threadIdx != UINT32_MAX && RunNextJob(threadIdx) == true)
+		{
+			spinCount = 0;
+			continue;
+		}
+
+		if (++spinCount > JOB_SYSTEM_SPIN_COUNT)
+			std::this_thread::yield();
+	}
+
+	//The last job may still be releasing the counter
+	std::unique_lock<std::mutex> lock(counter.mutex);
+}
+
+
+void JobSystem::ParallelFor(const char* name, u32 itemCount, u32 itemsPerJob, const std::function<void(u32, u32)>& task)
+{
+	ASSERT(jobThreadIdx != UINT32_MAX, "ParallelFor must be called from a job system thread");
+
+	if (itemCount == 0)
+		return;
+
+	itemsPerJob = glm::max(itemsPerJob, 1u);
+	u32 jobCount = (itemCount + itemsPerJob - 1) / itemsPerJob;
+
+	//Not worth the queues
+	if (jobCount == 1 || workerCount == 0)
+	{
+		CPU_PROFILE_SCOPE(name);
+
+		for (u32 i = 0; i < itemCount; ++i)
+			task(i, jobThreadIdx);
+
+		return;
+	}
+
+	JobCounter counter;
+
+	for (u32 i = 0; i < jobCount; ++i)
+	{
+		u32 begin = i * itemsPerJob;
+		u32 end = glm::min(begin + itemsPerJob, itemCount);
+
+		Run(name, [&task, begin, end]()
+			{
+				u32 threadIdx = jobThreadIdx;
+				for (u32 item = begin; item < end; ++item)
+					task(item, threadIdx);
+			}, &counter);
+	}
+
+	Wait(counter);
+}
+
+
+void JobSystem::RunMainThreadJobs()
+{
+	CPU_PROFILE_FUNCTION();
+
+	ASSERT(jobThreadIdx == 0, "Only the main thread runs its jobs");
+
+	while (true)
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock(mainThreadQueue.mutex);
+			if (mainThreadQueue.jobs.empty() == true)
+				return;
+
+			job = std::move(mainThreadQueue.jobs.front());
+			mainThreadQueue.jobs.pop_front();
+		}
+
+		Execute(job);
+	}
+}
+
+
+u32 JobSystem::GetWorkerCount() const
+{
+	return workerCount;
+}
+
+
+u32 JobSystem::GetThreadCount() const
+{
+	return workerCount + 1;
+}
+
+
+JobSystemStats JobSystem::GetStats() const
+{
+	JobSystemStats stats;
+	stats.workerCount = workerCount;
+	stats.executedCount = executedCount.load();
+	stats.stolenCount = stolenCount.load();
+
+	return stats;
+}
+
+
+void JobSystem::Submit(Job& job, JobCounter* dependency)
+{
+	if (job.counter != nullptr)
+		job.counter->pending++;
+
+	if (dependency != nullptr)
+	{
+		std::unique_lock<std::mutex> lock(dependency->mutex);
+
+		//Scheduled by the last job of the dependency
+		if (dependency->pending.load() > 0)
+		{
+			dependency->dependents.push_back(std::move(job));
+			return;
+		}
+	}
+
+	Schedule(job);
+}
+
+
+void JobSystem::Schedule(Job& job)
+{
+	if (job.mainThread == true)
+	{
+		std::unique_lock<std::mutex> lock(mainThreadQueue.mutex);
+		mainThreadQueue.jobs.push_back(std::move(job));
+		return;
+	}
+
+	//Threads outside the job system queue on the main thread deque, it is stolen from like any other
+	u32 threadIdx = jobThreadIdx != UINT32_MAX ? jobThreadIdx : 0;
+
+	{
+		std::unique_lock<std::mutex> lock(queues[threadIdx].mutex);
+		queues[threadIdx].jobs.push_back(std::move(job));
+	}
+
+	//Under the lock, so a worker can't miss it between checking the count and going to sleep
+	{
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		queuedCount++;
+	}
+	wakeCondition.notify_one();
+}
+
+
+bool JobSystem::RunNextJob(u32 threadIdx)
+{
+	Job job;
+	bool found = false;
+
+	//Newest first from its own deque, it is the most likely to be in the cache
+	{
+		std::unique_lock<std::mutex> lock(queues[threadIdx].mutex);
+		if (queues[threadIdx].jobs.empty() == false)
+		{
+			job = std::move(queues[threadIdx].jobs.back());
+			queues[threadIdx].jobs.pop_back();
+			found = true;
+		}
+	}
+
+	if (found == false && threadIdx == 0)
+	{
+		std::unique_lock<std::mutex> lock(mainThreadQueue.mutex);
+		if (mainThreadQueue.jobs.empty() == false)
+		{
+			job = std::move(mainThreadQueue.jobs.front());
+			mainThreadQueue.jobs.pop_front();
+
+			lock.unlock();
+			Execute(job);
+
+			return true;
+		}
+	}
+
+	//Oldest first from the others, it tends to be the biggest piece of work left
+	u32 threadCount = GetThreadCount();
+	for (u32 i = 1; i < threadCount && found == false; ++i)
+	{
+		JobQueue& victim = queues[(threadIdx + i) % threadCount];
+
+		std::unique_lock<std::mutex> lock(victim.mutex);
+		if (victim.jobs.empty() == false)
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			found = true;
+
+			stolenCount++;
+		}
+	}
+
+	if (found == false)
+		return false;
+
+	queuedCount--;
+	Execute(job);
+
+	return true;
+}
+
+
+void JobSystem::Execute(Job& job)
+{
+	{
+		CpuProfileScope scope(job.name);
+		job.function();
+	}
+
+	executedCount++;
+
+	JobCounter* counter = job.counter;
+	if (counter == nullptr)
+		return;
+
+	std::vector<Job> ready;
+
+	{
+		std::unique_lock<std::mutex> lock(counter->mutex);
+
+		if (--counter->pending == 0)
+			ready.swap(counter->dependents);
+	}
+
+	for (u32 i = 0; i < ready.size(); ++i)
+	{
+		Schedule(ready[i]);
+	}
+}
+
+
+void JobSystem::WorkerLoop(u32 threadIdx)
+{
+	jobThreadIdx = threadIdx;
+
+	char threadName[32];
+	snprintf(threadName, sizeof(threadName), "Job worker %u", threadIdx);
+	SetProfilerThreadName(threadName);
+
+	while (true)
+	{
+		if (RunNextJob(threadIdx) == true)
+			continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeCondition.wait(lock, [this]() { return quit == true || queuedCount.load() > 0; });
+
+		if (quit == true)
+			return;
+	}
+}
+
+
+void InitJobSystem(u32 workerCount)
+{
+	ASSERT(jobSystem == nullptr, "The job system is already running");
+
+	if (workerCount == UINT32_MAX)
+	{
+		u32 hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+
+	jobThreadIdx = 0;
+	jobSystem = new JobSystem(workerCount);
+}
+
+
+void ShutdownJobSystem()
+{
+	delete jobSystem;
+	jobSystem = nullptr;
+}
+
+
+JobSystem& GetJobSystem()
+{
+	ASSERT(jobSystem != nullptr, "InitJobSystem() must be called first");
+	return *jobSystem;
+}
+
+
+u32 GetJobThreadIndex()
+{
+	return jobThreadIdx;
+}
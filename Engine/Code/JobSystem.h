@@ -0,0 +1,113 @@
+#pragma once
+
+#include "platform.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <deque>
+
+#define JOB_SYSTEM_MAX_WORKERS 15
+#define JOB_SYSTEM_SPIN_COUNT 64		//Failed steals before a waiting thread yields its time slice
+
+struct JobCounter;
+
+struct Job
+{
+	std::function<void()> function;
+	const char* name;				//Scope in the cpu trace, must outlive it (string literals)
+
+	JobCounter* counter;			//Decremented when the job finishes, can be null
+	bool mainThread;				//Only the main thread runs it, for jobs that touch OpenGL
+};
+
+
+//Jobs of a group that haven't finished. Jobs that depend on the group are held here until it reaches 0.
+//It must not be destroyed before Wait() on it returns
+struct JobCounter
+{
+	std::atomic<u32> pending;
+	std::mutex mutex;
+	std::vector<Job> dependents;
+
+	JobCounter() : pending(0) {}
+};
+
+
+struct JobSystemStats
+{
+	u32 workerCount;
+	u64 executedCount;
+	u64 stolenCount;		//Taken from the deque of another thread
+};
+
+
+//Thread pool with a deque per thread. A thread pushes and pops its own jobs at the back and, when it runs out, steals
+//from the front of the others, so the jobs spawned by a job mostly stay on its thread.
+//The thread that calls InitJobSystem() is the main thread, thread index 0, and the workers go from 1 to the worker count.
+//Waiting runs other jobs instead of blocking, so jobs can wait on the jobs they spawn.
+class JobSystem
+{
+public:
+	JobSystem(u32 count);
+	~JobSystem();
+
+	//Runs once dependency, if any, reaches 0. The counter is incremented right away
+	void Run(const char* name, std::function<void()> function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+	void RunOnMainThread(const char* name, std::function<void()> function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+	void Wait(JobCounter& counter);
+
+	//Runs task(itemIdx, threadIdx) for every item, itemsPerJob in each job, and waits for all of them.
+	//threadIdx is below GetThreadCount(), for scratch data per thread
+	void ParallelFor(const char* name, u32 itemCount, u32 itemsPerJob, const std::function<void(u32, u32)>& task);
+
+	//The main thread jobs are also run while the main thread waits
+	void RunMainThreadJobs();
+
+	u32 GetWorkerCount() const;
+	u32 GetThreadCount() const;
+	JobSystemStats GetStats() const;
+
+private:
+	void Submit(Job& job, JobCounter* dependency);
+	void Schedule(Job& job);
+	bool RunNextJob(u32 threadIdx);
+	void Execute(Job& job);
+
+	void WorkerLoop(u32 threadIdx);
+
+private:
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	JobQueue queues[JOB_SYSTEM_MAX_WORKERS + 1];		//[threadIdx]
+	JobQueue mainThreadQueue;
+
+	std::vector<std::thread> workers;
+	u32 workerCount;		//Set before the workers start, they read it while the vector is still growing
+
+	//Idle workers sleep until something is queued
+	std::mutex sleepMutex;
+	std::condition_variable wakeCondition;
+	std::atomic<u32> queuedCount;
+	bool quit = false;
+
+	std::atomic<u64> executedCount;
+	std::atomic<u64> stolenCount;
+};
+
+
+//Starts the workers, UINT32_MAX uses a worker per core besides the calling thread
+void InitJobSystem(u32 workerCount = UINT32_MAX);
+void ShutdownJobSystem();
+
+JobSystem& GetJobSystem();
+
+//Index of the calling thread in the job system, UINT32_MAX if it isn't one of its threads
+u32 GetJobThreadIndex();
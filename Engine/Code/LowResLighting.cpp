@@ -0,0 +1,188 @@
+#include "LowResLighting.h"
+
+#include "engine.h"
+#include "GpuProfiler.h"
+#include "Environment.h"
+
+LowResLighting::LowResLighting(App* app)
+{
+	programIdx = CreateProgram(app, "lightPass.glsl", "LOW_RES_LIGHT_PASS");
+
+	int sizeX = app->displaySize.x;
+	int sizeY = app->displaySize.y;
+
+	halfResFbo.owner = "Half res lighting";
+	quarterResFbo.owner = "Quarter res lighting";
+
+	InitFrameBuffer(halfResFbo, sizeX / GetDivisor(LIGHTING_RESOLUTION::HALF), sizeY / GetDivisor(LIGHTING_RESOLUTION::HALF));
+	InitFrameBuffer(quarterResFbo, sizeX / GetDivisor(LIGHTING_RESOLUTION::QUARTER), sizeY / GetDivisor(LIGHTING_RESOLUTION::QUARTER));
+}
+
+
+void LowResLighting::Resize(int sizeX, int sizeY)
+{
+	halfResFbo.Regenerate(glm::max(1, sizeX / GetDivisor(LIGHTING_RESOLUTION::HALF)), glm::max(1, sizeY / GetDivisor(LIGHTING_RESOLUTION::HALF)));
+	quarterResFbo.Regenerate(glm::max(1, sizeX / GetDivisor(LIGHTING_RESOLUTION::QUARTER)), glm::max(1, sizeY / GetDivisor(LIGHTING_RESOLUTION::QUARTER)));
+}
+
+
+bool LowResLighting::IsActive() const
+{
+	return diffuseResolution != LIGHTING_RESOLUTION::FULL || ambientResolution != LIGHTING_RESOLUTION::FULL || reflectionResolution != LIGHTING_RESOLUTION::FULL;
+}
+
+
+void LowResLighting::Render(App* app)
+{
+	GPU_PROFILE_SCOPE(app, "LowResLighting");
+
+	if (diffuseResolution == LIGHTING_RESOLUTION::HALF || ambientResolution == LIGHTING_RESOLUTION::HALF || reflectionResolution == LIGHTING_RESOLUTION::HALF)
+		RenderResolution(app, LIGHTING_RESOLUTION::HALF);
+
+	if (diffuseResolution == LIGHTING_RESOLUTION::QUARTER || ambientResolution == LIGHTING_RESOLUTION::QUARTER || reflectionResolution == LIGHTING_RESOLUTION::QUARTER)
+		RenderResolution(app, LIGHTING_RESOLUTION::QUARTER);
+}
+
+
+u32 LowResLighting::GetLightPassKey() const
+{
+	u32 key = 0;
+
+	if (diffuseResolution != LIGHTING_RESOLUTION::FULL)
+		key |= (u32)LIGHT_PASS_FEATURE::LOW_RES_DIFFUSE;
+
+	if (ambientResolution != LIGHTING_RESOLUTION::FULL)
+		key |= (u32)LIGHT_PASS_FEATURE::LOW_RES_AMBIENT;
+
+	if (reflectionResolution != LIGHTING_RESOLUTION::FULL)
+		key |= (u32)LIGHT_PASS_FEATURE::LOW_RES_REFLECTION;
+
+	return key;
+}
+
+
+void LowResLighting::BindTerms(const Program& program, int firstTextureUnit)
+{
+	const char* termNames[] = { "lowResDiffuse", "lowResAmbient", "lowResReflection" };
+	const char* guideNames[] = { "diffuseGuide", "ambientGuide", "reflectionGuide" };
+	LIGHTING_RESOLUTION resolutions[] = { diffuseResolution, ambientResolution, reflectionResolution };
+
+	for (int i = 0; i < ARRAY_COUNT(resolutions); ++i)
+	{
+		if (resolutions[i] == LIGHTING_RESOLUTION::FULL)
+			continue;
+
+		FrameBuffer& fbo = GetFrameBuffer(resolutions[i]);
+		int termUnit = firstTextureUnit + i * 2;
+
+		glUniform1i(glGetUniformLocation(program.handle, termNames[i]), termUnit);
+		glActiveTexture(GL_TEXTURE0 + termUnit);
+		glBindTexture(GL_TEXTURE_2D, fbo.textures[i].handle);
+
+		glUniform1i(glGetUniformLocation(program.handle, guideNames[i]), termUnit + 1);
+		glActiveTexture(GL_TEXTURE0 + termUnit + 1);
+		glBindTexture(GL_TEXTURE_2D, fbo.textures[3].handle);
+	}
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+
+void LowResLighting::InitFrameBuffer(FrameBuffer& fbo, int sizeX, int sizeY)
+{
+	sizeX = glm::max(1, sizeX);
+	sizeY = glm::max(1, sizeY);
+
+	//Diffuse
+	fbo.PushTexture(sizeX, sizeY, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+
+	//Ambient
+	fbo.PushTexture(sizeX, sizeY, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+
+	//Reflection
+	fbo.PushTexture(sizeX, sizeY, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+
+	//Guide: normal + distance to the camera
+	fbo.PushTexture(sizeX, sizeY, GL_RGBA16F, GL_RGBA, GL_FLOAT);
+
+	fbo.AttachTextures();
+}
+
+
+void LowResLighting::RenderResolution(App* app, LIGHTING_RESOLUTION resolution)
+{
+	FrameBuffer& fbo = GetFrameBuffer(resolution);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo.handle);
+
+	u32 drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+	glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
+
+	glDisable(GL_DEPTH_TEST);
+
+	//Same fraction of the target as the one used by the deferred targets
+	glViewport(0, 0, fbo.textures[0].sizeX * app->renderScale.x, fbo.textures[0].sizeY * app->renderScale.y);
+
+	Program& program = app->programs[programIdx];
+	glUseProgram(program.handle);
+	glBindVertexArray(app->vao);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->globalUniformBuffer.handle, app->globalParamsOffset, app->globalParamsSize);
+
+	glUniform1i(glGetUniformLocation(program.handle, "uComputeDiffuse"), diffuseResolution == resolution);
+	glUniform1i(glGetUniformLocation(program.handle, "uComputeAmbient"), ambientResolution == resolution);
+	glUniform1i(glGetUniformLocation(program.handle, "uComputeReflection"), reflectionResolution == resolution);
+	glUniform2fv(glGetUniformLocation(program.handle, "uRenderScale"), 1, glm::value_ptr(app->renderScale));
+
+	glUniform1i(glGetUniformLocation(program.handle, "normals"), 1);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[1].handle);
+
+	glUniform1i(glGetUniformLocation(program.handle, "worldPos"), 2);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[2].handle);
+
+	glUniform1i(glGetUniformLocation(program.handle, "skyBox"), 4);
+	glActiveTexture(GL_TEXTURE4);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, app->skybox->cubeMap.handle);
+
+	glUniform1i(glGetUniformLocation(program.handle, "irradianceMap"), 5);
+	glActiveTexture(GL_TEXTURE5);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, app->skybox->irradianceMap.handle);
+
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glActiveTexture(GL_TEXTURE0);
+
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+FrameBuffer& LowResLighting::GetFrameBuffer(LIGHTING_RESOLUTION resolution)
+{
+	if (resolution == LIGHTING_RESOLUTION::QUARTER)
+		return quarterResFbo;
+
+	return halfResFbo;
+}
+
+
+int LowResLighting::GetDivisor(LIGHTING_RESOLUTION resolution) const
+{
+	switch (resolution)
+	{
+	case LIGHTING_RESOLUTION::HALF:		return 2;
+	case LIGHTING_RESOLUTION::QUARTER:	return 4;
+
+	default:
+		return 1;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "FrameBuffer.h"
+
+struct App;
+struct Program;
+
+enum class LIGHTING_RESOLUTION : int
+{
+	FULL = 0,
+	HALF,
+	QUARTER,
+	MAX
+};
+
+
+//Terms the light pass upsamples instead of computing, bits of its variant key
+enum class LIGHT_PASS_FEATURE : u32
+{
+	LOW_RES_DIFFUSE = 1 << 0,
+	LOW_RES_AMBIENT = 1 << 1,
+	LOW_RES_REFLECTION = 1 << 2
+};
+
+
+//Evaluates the selected lighting terms (diffuse, ambient, reflection) at half or quarter resolution.
+//The light pass then recombines them with the full resolution albedo through a joint bilateral upsample
+//guided by the normal and the distance to the camera.
+struct LowResLighting
+{
+public:
+	LowResLighting(App* app);
+
+	void Resize(int sizeX, int sizeY);
+
+	//True if any term is not evaluated at full resolution
+	bool IsActive() const;
+
+	//Renders every low resolution target used this frame, needs the geometry pass done
+	void Render(App* app);
+
+	//Variant of the light pass that reads the terms that are not at full resolution
+	u32 GetLightPassKey() const;
+
+	//Binds the low resolution textures for the light pass
+	void BindTerms(const Program& program, int firstTextureUnit);
+
+private:
+	void InitFrameBuffer(FrameBuffer& fbo, int sizeX, int sizeY);
+	void RenderResolution(App* app, LIGHTING_RESOLUTION resolution);
+
+	FrameBuffer& GetFrameBuffer(LIGHTING_RESOLUTION resolution);
+	int GetDivisor(LIGHTING_RESOLUTION resolution) const;
+
+public:
+	LIGHTING_RESOLUTION diffuseResolution = LIGHTING_RESOLUTION::FULL;
+	LIGHTING_RESOLUTION ambientResolution = LIGHTING_RESOLUTION::FULL;
+	LIGHTING_RESOLUTION reflectionResolution = LIGHTING_RESOLUTION::FULL;
+
+private:
+	u32 programIdx = 0;
+
+	//Attachments: diffuse, ambient, reflection, guide
+	FrameBuffer halfResFbo;
+	FrameBuffer quarterResFbo;
+};
@@ -0,0 +1,508 @@
+#include "MicroBenchmark.h"
+
+#include "engine.h"
+#include "assimp_model_loading.h"
+#include "Arena.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+
+#include <assimp/mesh.h>
+#include <stb_image_write.h>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <sstream>
+
+#define MICRO_BENCHMARK_PNG "MicroBenchmark.png"
+#define MICRO_BENCHMARK_JPG "MicroBenchmark.jpg"
+#define MICRO_BENCHMARK_HDR "MicroBenchmark.hdr"
+#define MICRO_BENCHMARK_TEXT "MicroBenchmark.txt"
+
+//Results are added here so the compiler can't drop the work
+static volatile float benchmarkSink = 0.f;
+
+
+static void Measure(std::vector<MicroBenchmarkResult>& results, const char* name, u32 param, u32 items, const std::function<void()>& op)
+{
+	//Doubles the iterations until a batch is long enough to time, which also warms the caches
+	u64 iterations = 1;
+	while (true)
+	{
+		u64 start = GetProfilerTime();
+		for (u64 i = 0; i < iterations; ++i)
+			op();
+		u64 elapsed = GetProfilerTime() - start;
+
+		if (elapsed >= MICRO_BENCHMARK_SAMPLE_TIME / 4)
+		{
+			iterations = glm::max<u64>(1, iterations * MICRO_BENCHMARK_SAMPLE_TIME / glm::max<u64>(elapsed, 1));
+			break;
+		}
+
+		iterations *= 2;
+	}
+
+	double samples[MICRO_BENCHMARK_SAMPLES];
+	for (u32 i = 0; i < MICRO_BENCHMARK_SAMPLES; ++i)
+	{
+		u64 start = GetProfilerTime();
+		for (u64 j = 0; j < iterations; ++j)
+			op();
+
+		samples[i] = (double)(GetProfilerTime() - start) / iterations;
+	}
+
+	std::sort(samples, samples + MICRO_BENCHMARK_SAMPLES);
+
+	MicroBenchmarkResult result;
+	result.name = name;
+	result.param = param;
+	result.items = items;
+	result.iterations = iterations;
+	result.nsPerOp = samples[MICRO_BENCHMARK_SAMPLES / 2];
+	result.minNsPerOp = samples[0];
+
+	ILOG("%-28s %8u  %14.1f ns  %10.2f ns/item", name, param, result.nsPerOp, result.nsPerOp / glm::max(items, 1u));
+	results.push_back(result);
+}
+
+
+//Cpu memory in place of a mapped uniform buffer
+static Buffer CreateCpuBuffer(u32 size)
+{
+	Buffer buffer = {};
+	buffer.size = size;
+	buffer.alignement = 256;		//The usual GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	buffer.data = new u8[size];
+
+	return buffer;
+}
+
+
+static void FreeCpuBuffer(Buffer& buffer)
+{
+	delete[] (u8*)buffer.data;
+	buffer.data = nullptr;
+}
+
+
+static float Random01(std::mt19937& random)
+{
+	return (random() >> 8) / 16777216.f;
+}
+
+
+static void FillEntities(App* app, u32 count, std::mt19937& random)
+{
+	ClearEntities(app);
+	app->entities.reserve(count);
+	app->transforms.Reserve(count);
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		glm::vec3 position = glm::vec3(Random01(random), Random01(random), Random01(random)) * 100.f;
+		glm::vec3 rotation = glm::vec3(Random01(random), Random01(random), Random01(random)) * 6.28f;
+		glm::vec3 scale = glm::vec3(0.5f + Random01(random));
+
+		AddEntity(app, "Entity", 0, position, EulerToRotation(rotation), scale);
+	}
+}
+
+
+static void BenchmarkUniformBlocks(std::vector<MicroBenchmarkResult>& results, App* app, std::mt19937& random)
+{
+	app->camera.SetAspectRatio(16.f / 9.f);
+
+	glm::mat4 viewProjection = app->camera.GetProjectionMatrix() * app->camera.GetViewMatrix();
+
+	u32 blockSizes[] = { 16, 64, 256 };
+	for (u32 blockSize : blockSizes)
+	{
+		const u32 pushCount = 1024;
+		Buffer buffer = CreateCpuBuffer(pushCount * blockSize);
+
+		u8 block[256] = {};
+		Measure(results, "PushAlignedData", blockSize, pushCount, [&]()
+		{
+			buffer.head = 0;
+			for (u32 i = 0; i < pushCount; ++i)
+				PushAlignedData(buffer, block, blockSize, 16);
+		});
+
+		FreeCpuBuffer(buffer);
+	}
+
+	u32 entityCounts[] = { 10, 100, 1000, 10000, 100000 };
+	for (u32 entityCount : entityCounts)
+	{
+		FillEntities(app, entityCount, random);
+
+		Buffer buffer = CreateCpuBuffer(entityCount * Align(sizeof(LocalParams), 256));
+		Measure(results, "PushLocalParams", entityCount, entityCount, [&]()
+		{
+			buffer.head = 0;
+			PushLocalParams(app, buffer, viewProjection, viewProjection);
+		});
+
+		FreeCpuBuffer(buffer);
+	}
+
+	ClearEntities(app);
+
+	u32 lightCounts[] = { 4, 16, 256 };
+	for (u32 lightCount : lightCounts)
+	{
+		app->lights.clear();
+		for (u32 i = 0; i < lightCount; ++i)
+			app->lights.push_back(Light(LIGHT_TYPE::POINT, glm::vec3(1.f), glm::vec3(0.f, -1.f, 0.f), glm::vec3(Random01(random), 1.f, Random01(random)) * 20.f));
+
+		Buffer debugBuffer = CreateCpuBuffer(lightCount * Align(sizeof(LocalParams), 256));
+		Measure(results, "PushDebugLightParams", lightCount, lightCount, [&]()
+		{
+			debugBuffer.head = 0;
+			PushDebugLightParams(app, debugBuffer, viewProjection, viewProjection);
+		});
+
+		FreeCpuBuffer(debugBuffer);
+
+		Buffer globalBuffer = CreateCpuBuffer(Align(sizeof(GlobalParams), 256));
+		Measure(results, "PushGlobalParams", lightCount, 1, [&]()
+		{
+			globalBuffer.head = 0;
+			PushGlobalParams(app, globalBuffer);
+		});
+
+		FreeCpuBuffer(globalBuffer);
+	}
+
+	app->lights.clear();
+
+	u32 materialCounts[] = { 10, 100, 1000 };
+	for (u32 materialCount : materialCounts)
+	{
+		app->materials.assign(materialCount, Material{});
+
+		Buffer buffer = CreateCpuBuffer(materialCount * Align(sizeof(MaterialParams), 256));
+		Measure(results, "PushMaterialParams", materialCount, materialCount, [&]()
+		{
+			buffer.head = 0;
+			PushMaterialParams(app, buffer);
+		});
+
+		FreeCpuBuffer(buffer);
+	}
+
+	app->materials.clear();
+}
+
+
+static void BenchmarkTransforms(std::vector<MicroBenchmarkResult>& results, App* app, std::mt19937& random)
+{
+	const u32 entityCount = 1024;
+	FillEntities(app, entityCount, random);
+
+	//Worst case, every transform moved
+	Measure(results, "UpdateTransforms", 0, entityCount, [&]()
+	{
+		app->transforms.MarkAllDirty();
+		app->transforms.Update();
+
+		benchmarkSink = benchmarkSink + app->transforms.GetWorld(entityCount - 1)[3][0];
+	});
+
+	ClearEntities(app);
+
+	//Only the lookup of a vao that exists, creating one needs gl
+	u32 vaoCounts[] = { 1, 8, 32 };
+	for (u32 vaoCount : vaoCounts)
+	{
+		Mesh mesh;
+		mesh.submeshes.push_back(Submesh());
+
+		for (u32 i = 0; i < vaoCount; ++i)
+			mesh.submeshes[0].vaos.push_back(Vao(i + 1, i + 1));
+
+		Program program = {};
+		program.handle = vaoCount;		//The last one, the worst case
+
+		Measure(results, "FindVAO", vaoCount, 1, [&]()
+		{
+			benchmarkSink = benchmarkSink + FindVAO(mesh, 0, program);
+		});
+	}
+}
+
+
+static void BenchmarkMeshImport(std::vector<MicroBenchmarkResult>& results, std::mt19937& random)
+{
+	u32 vertexCounts[] = { 1024, 65536 };
+	for (u32 vertexCount : vertexCounts)
+	{
+		//A strip of quads with every attribute the engine reads
+		aiMesh mesh;
+		mesh.mNumVertices = vertexCount;
+		mesh.mVertices = new aiVector3D[vertexCount];
+		mesh.mNormals = new aiVector3D[vertexCount];
+		mesh.mTangents = new aiVector3D[vertexCount];
+		mesh.mBitangents = new aiVector3D[vertexCount];
+		mesh.mTextureCoords[0] = new aiVector3D[vertexCount];
+		mesh.mNumUVComponents[0] = 2;
+
+		for (u32 i = 0; i < vertexCount; ++i)
+		{
+			mesh.mVertices[i] = aiVector3D(Random01(random), Random01(random), Random01(random));
+			mesh.mNormals[i] = aiVector3D(0.f, 1.f, 0.f);
+			mesh.mTangents[i] = aiVector3D(1.f, 0.f, 0.f);
+			mesh.mBitangents[i] = aiVector3D(0.f, 0.f, 1.f);
+			mesh.mTextureCoords[0][i] = aiVector3D(Random01(random), Random01(random), 0.f);
+		}
+
+		u32 quadCount = vertexCount / 2 - 1;
+		mesh.mNumFaces = quadCount * 2;
+		mesh.mFaces = new aiFace[mesh.mNumFaces];
+
+		for (u32 i = 0; i < quadCount; ++i)
+		{
+			u32 v = i * 2;
+			u32 triangles[2][3] = { { v, v + 1, v + 2 }, { v + 1, v + 3, v + 2 } };
+
+			for (u32 j = 0; j < 2; ++j)
+			{
+				aiFace& face = mesh.mFaces[i * 2 + j];
+				face.mNumIndices = 3;
+				face.mIndices = new unsigned int[3];
+				memcpy(face.mIndices, triangles[j], sizeof(triangles[j]));
+			}
+		}
+
+		Mesh myMesh;
+		std::vector<u32> submeshMaterialIndices;
+
+		Measure(results, "ProcessAssimpMesh", vertexCount, vertexCount, [&]()
+		{
+			myMesh.submeshes.clear();
+			submeshMaterialIndices.clear();
+
+			ProcessAssimpMesh(nullptr, &mesh, &myMesh, 0, submeshMaterialIndices);
+		});
+	}
+}
+
+
+static void BenchmarkImages(std::vector<MicroBenchmarkResult>& results, std::mt19937& random)
+{
+	//Smooth gradients with some noise, closer to a real texture than pure noise
+	const int size = 512;
+	std::vector<u8> pixels(size * size * 4);
+	std::vector<float> hdrPixels(size * 2 * size * 3);
+
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			u8* pixel = &pixels[(y * size + x) * 4];
+			pixel[0] = (u8)(x / 2 + random() % 16);
+			pixel[1] = (u8)(y / 2 + random() % 16);
+			pixel[2] = (u8)((x + y) / 4);
+			pixel[3] = 255;
+		}
+	}
+
+	for (int i = 0; i < size * 2 * size; ++i)
+	{
+		hdrPixels[i * 3 + 0] = Random01(random) * 4.f;
+		hdrPixels[i * 3 + 1] = (i % (size * 2)) / (float)size;
+		hdrPixels[i * 3 + 2] = (i / (size * 2)) / (float)size * 16.f;
+	}
+
+	bool written = stbi_write_png(MICRO_BENCHMARK_PNG, size, size, 4, pixels.data(), size * 4) != 0;
+	written = written && stbi_write_jpg(MICRO_BENCHMARK_JPG, size, size, 4, pixels.data(), 90) != 0;
+	written = written && stbi_write_hdr(MICRO_BENCHMARK_HDR, size * 2, size, 3, hdrPixels.data()) != 0;
+
+	if (written == false)
+	{
+		ELOG("The images of the micro benchmark can't be written to the working directory");
+	}
+	else
+	{
+		Measure(results, "LoadImage png", size, size * size, [&]()
+		{
+			FreeImage(LoadImage(MICRO_BENCHMARK_PNG));
+		});
+
+		Measure(results, "LoadImage jpg", size, size * size, [&]()
+		{
+			FreeImage(LoadImage(MICRO_BENCHMARK_JPG));
+		});
+
+		//The cpu part of the environment precompute, the cubemap and irradiance are rendered on the gpu
+		Measure(results, "LoadImageHdr", size, size * 2 * size, [&]()
+		{
+			FreeImage(LoadImageHdr(MICRO_BENCHMARK_HDR));
+		});
+	}
+
+	remove(MICRO_BENCHMARK_PNG);
+	remove(MICRO_BENCHMARK_JPG);
+	remove(MICRO_BENCHMARK_HDR);
+}
+
+
+static void BenchmarkFiles(std::vector<MicroBenchmarkResult>& results)
+{
+	String directory = MakeString("Patrick/Textures");
+	String filename = MakeString("Patrick_Albedo.png");
+
+	Measure(results, "MakePath", 0, 1, [&]()
+	{
+		ArenaScope scope(GetThreadArena());
+		benchmarkSink = benchmarkSink + MakePath(directory, filename).len;
+	});
+
+	//The size of a big shader
+	const u32 lineCount = 2048;
+	FILE* file = fopen(MICRO_BENCHMARK_TEXT, "wb");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing %s", MICRO_BENCHMARK_TEXT);
+		return;
+	}
+
+	for (u32 i = 0; i < lineCount; ++i)
+		fprintf(file, "vec3 value%u = texture(uTexture, vTexCoord).xyz * albedo;\n", i);
+
+	fclose(file);
+
+	Measure(results, "ReadTextFile", lineCount, 1, [&]()
+	{
+		ArenaScope scope(GetThreadArena());
+		benchmarkSink = benchmarkSink + ReadTextFile(MICRO_BENCHMARK_TEXT).len;
+	});
+
+	remove(MICRO_BENCHMARK_TEXT);
+}
+
+
+bool LoadMicroBenchmarkBaseline(const char* path, std::vector<MicroBenchmarkResult>& results)
+{
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed reading the baseline %s", path);
+		return false;
+	}
+
+	fclose(file);
+
+	String text = ReadTextFile(path);
+	std::istringstream stream(std::string(text.str, text.len));
+
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		//Lines with a case have all the fields
+		size_t nameStart = line.find("\"name\": \"");
+		size_t param = line.find("\"param\": ");
+		size_t nsPerOp = line.find("\"nsPerOp\": ");
+
+		if (nameStart == std::string::npos || param == std::string::npos || nsPerOp == std::string::npos)
+			continue;
+
+		nameStart += strlen("\"name\": \"");
+		size_t nameEnd = line.find('"', nameStart);
+
+		MicroBenchmarkResult result = {};
+		result.name = line.substr(nameStart, nameEnd - nameStart);
+
+		if (sscanf(line.c_str() + param, "\"param\": %u", &result.param) != 1 || sscanf(line.c_str() + nsPerOp, "\"nsPerOp\": %lf", &result.nsPerOp) != 1)
+			continue;
+
+		results.push_back(result);
+	}
+
+	return true;
+}
+
+
+int RunMicroBenchmarks(const char* outputPath, const char* baselinePath)
+{
+	InitThreadArena(GLOBAL_FRAME_ARENA_SIZE);
+
+	std::vector<MicroBenchmarkResult> baseline;
+	if (baselinePath != nullptr && LoadMicroBenchmarkBaseline(baselinePath, baseline) == false)
+		return -1;
+
+	//The uniform block writes run on it
+	InitJobSystem();
+
+	//Never deleted, its destructor releases gl objects and there is no context
+	App* app = new App();
+
+	std::mt19937 random(1);
+	std::vector<MicroBenchmarkResult> results;
+
+	BenchmarkUniformBlocks(results, app, random);
+	BenchmarkTransforms(results, app, random);
+	BenchmarkMeshImport(results, random);
+	BenchmarkImages(results, random);
+	BenchmarkFiles(results);
+
+	u32 regressions = 0;
+
+	for (MicroBenchmarkResult& result : results)
+	{
+		for (const MicroBenchmarkResult& previous : baseline)
+		{
+			if (previous.name == result.name && previous.param == result.param)
+			{
+				result.baselineNsPerOp = previous.nsPerOp;
+				break;
+			}
+		}
+
+		if (result.baselineNsPerOp > 0.0 && result.nsPerOp > result.baselineNsPerOp * (1.0 + MICRO_BENCHMARK_REGRESSION))
+		{
+			ELOG("Regression in %s %u: %.1f ns, %.1f ns in the baseline", result.name.c_str(), result.param, result.nsPerOp, result.baselineNsPerOp);
+			regressions++;
+		}
+	}
+
+	ShutdownJobSystem();
+
+	FILE* file = fopen(outputPath, "w");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing the micro benchmark result %s", outputPath);
+		return -1;
+	}
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"baseline\": \"%s\",\n", baselinePath != nullptr ? baselinePath : "");
+	fprintf(file, "\t\"regressions\": %u,\n", regressions);
+	fprintf(file, "\t\"results\": [");
+
+	//One case per line, the baseline reader depends on it
+	for (u32 i = 0; i < results.size(); ++i)
+	{
+		const MicroBenchmarkResult& result = results[i];
+
+		fprintf(file, "%s\n\t\t{ \"name\": \"%s\", \"param\": %u, \"items\": %u, \"iterations\": %llu, \"nsPerOp\": %.2f, \"minNsPerOp\": %.2f, \"nsPerItem\": %.3f",
+			i == 0 ? "" : ",", result.name.c_str(), result.param, result.items, (unsigned long long)result.iterations, result.nsPerOp, result.minNsPerOp,
+			result.nsPerOp / glm::max(result.items, 1u));
+
+		if (result.baselineNsPerOp > 0.0)
+			fprintf(file, ", \"baselineNsPerOp\": %.2f, \"change\": %.4f", result.baselineNsPerOp, result.nsPerOp / result.baselineNsPerOp - 1.0);
+
+		fprintf(file, " }");
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+	fclose(file);
+
+	ILOG("Micro benchmark result written to %s, %u regressions", outputPath, regressions);
+
+	return regressions > 0 ? 1 : 0;
+}
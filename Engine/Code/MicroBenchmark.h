@@ -0,0 +1,30 @@
+#pragma once
+
+#include "platform.h"
+
+#define MICRO_BENCHMARK_FILE "MicroBenchmark.json"
+#define MICRO_BENCHMARK_SAMPLES 9				//The median is reported, so noise from other processes mostly drops out
+#define MICRO_BENCHMARK_SAMPLE_TIME 20000000	//Nanoseconds, the iterations of a sample are scaled to last about this
+#define MICRO_BENCHMARK_REGRESSION 0.1			//Slower than the baseline by this fraction counts as a regression
+
+struct MicroBenchmarkResult
+{
+	std::string name;
+	u32 param;				//Entities, vertices, pixels... of the case, 0 if it has none
+	u32 items;				//Handled by every iteration, to compare the cost per item across params
+
+	u64 iterations;			//Per sample
+	double nsPerOp;			//Median of the samples
+	double minNsPerOp;
+
+	double baselineNsPerOp = 0.0;	//0 if the baseline doesn't have the case
+};
+
+
+//Cpu hot paths of the engine timed without a gl context: the uniform block writes, transforms, vao lookup, mesh
+//import, image decoding and paths and text files. The results are written as json, one case per line. Given the
+//output of a previous run, every case is compared with it and the exit code is 1 if any got slower.
+int RunMicroBenchmarks(const char* outputPath, const char* baselinePath);
+
+//Reads a file written by RunMicroBenchmarks, the cases are matched by name and param
+bool LoadMicroBenchmarkBaseline(const char* path, std::vector<MicroBenchmarkResult>& results);
@@ -1,6 +1,7 @@
 #include "ModelStructures.h"
 
 #include <glad/glad.h>
+#include <float.h>
 
 VertexBufferAttribute::VertexBufferAttribute(u8 location, u8 componentCount, u8 offset) :
 	location(location),
@@ -25,10 +26,6 @@ Vao::Vao(u32 handle, u32 programHandle) :
 
 Entity::Entity(std::string name, u32 modelIdx) :
 	name(name),
-	
-	position(0.f, 0.f, 0.f),
-	rotation(0.f, 0.f, 0.f),
-	scale(1.f, 1.f, 1.f),
 
 	modelIdx(modelIdx),
 	localParamsOffset(0),
@@ -39,20 +36,68 @@ Entity::Entity(std::string name, u32 modelIdx) :
 }
 
 
-glm::mat4 Entity::CalculateWorldTransform() const
-{
-	glm::mat4 transform = glm::translate(position);
-	transform = glm::rotate(transform, rotation.x, glm::vec3(1.f, 0.f, 0.f));
-	transform = glm::rotate(transform, rotation.y, glm::vec3(0.f, 1.f, 0.f));
-	transform = glm::rotate(transform, rotation.z, glm::vec3(0.f, 0.f, 1.f));
-	transform = glm::scale(transform, scale);
-
-	return transform;
-}
-
-
 //Submesh---------------------------------------------------------------------------------------------------------------------
 Submesh::Submesh() :
 	vertexOffset(0),
 	indexOffset(0)
 {}
+
+
+//Mesh------------------------------------------------------------------------------------------------------------------------
+void Mesh::CalculateAABB()
+{
+	aabbMin = glm::vec3(FLT_MAX);
+	aabbMax = glm::vec3(-FLT_MAX);
+
+	int submeshCount = submeshes.size();
+	for (int i = 0; i < submeshCount; ++i)
+	{
+		Submesh& submesh = submeshes[i];
+
+		submesh.aabbMin = glm::vec3(FLT_MAX);
+		submesh.aabbMax = glm::vec3(-FLT_MAX);
+
+		//Position is always the first attribute of the vertex
+		u32 floatStride = submesh.vertexBufferLayout.stride / sizeof(float);
+		u32 vertexCount = submesh.vertices.size() / floatStride;
+
+		for (u32 j = 0; j < vertexCount; ++j)
+		{
+			const float* position = &submesh.vertices[j * floatStride];
+			glm::vec3 vertex(position[0], position[1], position[2]);
+
+			submesh.aabbMin = glm::min(submesh.aabbMin, vertex);
+			submesh.aabbMax = glm::max(submesh.aabbMax, vertex);
+		}
+
+		if (submesh.aabbMin.x > submesh.aabbMax.x)
+		{
+			submesh.aabbMin = glm::vec3(0.f);
+			submesh.aabbMax = glm::vec3(0.f);
+		}
+
+		aabbMin = glm::min(aabbMin, submesh.aabbMin);
+		aabbMax = glm::max(aabbMax, submesh.aabbMax);
+	}
+
+	if (aabbMin.x > aabbMax.x)
+	{
+		aabbMin = glm::vec3(0.f);
+		aabbMax = glm::vec3(0.f);
+	}
+}
+
+
+void TransformAABB(const glm::mat4& transform, const glm::vec3& aabbMin, const glm::vec3& aabbMax, glm::vec3& outMin, glm::vec3& outMax)
+{
+	glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+	glm::vec3 extents = (aabbMax - aabbMin) * 0.5f;
+
+	glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.f));
+	glm::vec3 worldExtents = glm::abs(glm::vec3(transform[0])) * extents.x +
+							 glm::abs(glm::vec3(transform[1])) * extents.y +
+							 glm::abs(glm::vec3(transform[2])) * extents.z;
+
+	outMin = worldCenter - worldExtents;
+	outMax = worldCenter + worldExtents;
+}
\ No newline at end of file
@@ -44,18 +44,19 @@ struct Vao
 struct Entity
 {
 	Entity(std::string name, u32 modelIdx);
-	glm::mat4 CalculateWorldTransform() const;
 
 	std::string name;
 
-	glm::vec3 position;
-	glm::vec3 rotation;
-	glm::vec3 scale;
+	//The transform is in App::transforms, at the index of the entity
 
 	u32 modelIdx;
 	u32 localParamsOffset;
 	u32 localParamsSize;
 
+	//Software occlusion
+	bool isOccluder = false;
+	bool culled = false;
+
 	bool drawInspector = false;
 };
 
@@ -64,6 +65,10 @@ struct Model
 	u32 meshIdx;
 	std::string name;
 	std::vector<u32> materialIdx;
+
+	//Materials created from the file, reused when it is reloaded
+	u32 baseMaterialIdx = 0;
+	u32 materialCount = 0;
 };
 
 struct Submesh
@@ -76,15 +81,24 @@ struct Submesh
 	u32 vertexOffset;
 	u32 indexOffset;
 
+	glm::vec3 aabbMin = glm::vec3(0.f);
+	glm::vec3 aabbMax = glm::vec3(0.f);
+
 	std::vector<Vao> vaos;
 };
 
 struct Mesh
 {
+	void CalculateAABB();
+
 	std::vector<Submesh> submeshes;
 
 	u32 vertexBufferHandle;
 	u32 indexBufferHandle;
+
+	//Local space bounds, used by the culling systems
+	glm::vec3 aabbMin = glm::vec3(0.f);
+	glm::vec3 aabbMax = glm::vec3(0.f);
 };
 
 
@@ -108,6 +122,10 @@ struct Material
 };
 
 
+//Axis aligned bounds of a local aabb once transformed
+void TransformAABB(const glm::mat4& transform, const glm::vec3& aabbMin, const glm::vec3& aabbMax, glm::vec3& outMin, glm::vec3& outMax);
+
+
 struct Image
 {
 	void* pixels;
@@ -135,7 +153,10 @@ struct Program
 	u32				   handle;
 	std::string        filepath;
 	std::string        programName;
-	u64                lastWriteTimestamp;
+	std::string        defines;            //Extra #define lines of this variant
+	std::vector<std::string> dependencies; //Files pulled with #include
+	bool               isCompute = false;
+	bool               reflectAttributes = false;  //Fills the layout every time it links
 
 	VertexShaderLayout layout;
 };
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "OcclusionCulling.h"
+
+#include "engine.h"
+#include "GpuMemory.h"
+
+OcclusionCulling::OcclusionCulling(App* app)
+{
+	hiZProgramIdx = CreateComputeProgram(app, "HiZBuild.glsl", "HIZ_BUILD");
+	cullProgramIdx = CreateComputeProgram(app, "OcclusionCulling.glsl", "OCCLUSION_CULL");
+
+	InitHiZ(app->displaySize.x, app->displaySize.y);
+	InitBuffers();
+}
+
+
+OcclusionCulling::~OcclusionCulling()
+{
+	GetGpuMemory().ReleaseTexture(hiZTexture);
+	GetGpuMemory().ReleaseBuffer(objectBuffer);
+	GetGpuMemory().ReleaseBuffer(phaseOneCommandBuffer);
+	GetGpuMemory().ReleaseBuffer(phaseTwoCommandBuffer);
+	GetGpuMemory().ReleaseBuffer(visibilityBuffer);
+	GetGpuMemory().ReleaseBuffer(counterBuffer);
+
+	for (int i = 0; i < OCCLUSION_STATS_RING_SIZE; ++i)
+		GetGpuMemory().ReleaseBuffer(statsBuffers[i]);
+
+	glDeleteTextures(1, &hiZTexture);
+
+	glDeleteBuffers(1, &objectBuffer);
+	glDeleteBuffers(1, &phaseOneCommandBuffer);
+	glDeleteBuffers(1, &phaseTwoCommandBuffer);
+	glDeleteBuffers(1, &visibilityBuffer);
+	glDeleteBuffers(1, &counterBuffer);
+	glDeleteBuffers(OCCLUSION_STATS_RING_SIZE, statsBuffers);
+
+	for (int i = 0; i < OCCLUSION_STATS_RING_SIZE; ++i)
+	{
+		if (statsFences[i] != 0)
+			glDeleteSync(statsFences[i]);
+	}
+}
+
+
+void OcclusionCulling::Resize(int sizeX, int sizeY)
+{
+	InitHiZ(sizeX, sizeY);
+}
+
+
+void OcclusionCulling::RenderModels(App* app, const Program& program)
+{
+	ReadStats();
+	UploadObjects(app);
+
+	if (drawCount == 0)
+		return;
+
+	//Phase one: draw what was visible last frame
+	Cull(app, 1);
+	DrawIndirect(app, program, phaseOneCommandBuffer);
+
+	//Phase two: test everything against the depth of phase one
+	BuildHiZ(app);
+	Cull(app, 2);
+	DrawIndirect(app, program, phaseTwoCommandBuffer);
+
+	RequestStats();
+
+	//Leave a complete pyramid for the effects that run later in the frame
+	BuildHiZ(app);
+}
+
+
+void OcclusionCulling::BuildHiZ(App* app)
+{
+	Program& program = app->programs[hiZProgramIdx];
+	glUseProgram(program.handle);
+
+	u32 srcLevelLoc = glGetUniformLocation(program.handle, "uSrcLevel");
+	u32 fromDepthLoc = glGetUniformLocation(program.handle, "uFromDepth");
+	u32 depthLoc = glGetUniformLocation(program.handle, "depthMap");
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[5].handle);
+	glUniform1i(depthLoc, 0);
+
+	int levelSizeX = hiZSizeX;
+	int levelSizeY = hiZSizeY;
+
+	for (int level = 0; level < hiZMipCount; ++level)
+	{
+		glUniform1i(fromDepthLoc, level == 0 ? 1 : 0);
+		glUniform1i(srcLevelLoc, level == 0 ? 0 : level - 1);
+
+		if (level > 0)
+			glBindImageTexture(0, hiZTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+
+		glBindImageTexture(1, hiZTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute((levelSizeX + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (levelSizeY + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		levelSizeX = glm::max(1, levelSizeX / 2);
+		levelSizeY = glm::max(1, levelSizeY / 2);
+	}
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+	glBindImageTexture(1, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+}
+
+
+void OcclusionCulling::InitHiZ(int sizeX, int sizeY)
+{
+	if (hiZTexture != 0)
+	{
+		GetGpuMemory().ReleaseTexture(hiZTexture);
+		glDeleteTextures(1, &hiZTexture);
+	}
+
+	hiZSizeX = glm::max(1, sizeX);
+	hiZSizeY = glm::max(1, sizeY);
+	hiZMipCount = 1 + (int)floor(log2((float)glm::max(hiZSizeX, hiZSizeY)));
+
+	glGenTextures(1, &hiZTexture);
+	glBindTexture(GL_TEXTURE_2D, hiZTexture);
+	glTexStorage2D(GL_TEXTURE_2D, hiZMipCount, GL_R32F, hiZSizeX, hiZSizeY);
+	GetGpuMemory().TrackTexture(hiZTexture, GPU_MEMORY_CATEGORY::RENDER_TARGET, "Hi-Z pyramid", GL_R32F, hiZSizeX, hiZSizeY, 1, hiZMipCount);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void OcclusionCulling::InitBuffers()
+{
+	glGenBuffers(1, &counterBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(u32) * (int)OCCLUSION_COUNTER::MAX, NULL, GL_DYNAMIC_COPY);
+	GetGpuMemory().TrackBuffer(counterBuffer, GPU_MEMORY_CATEGORY::STORAGE, "Occlusion counters", sizeof(u32) * (int)OCCLUSION_COUNTER::MAX);
+
+	glGenBuffers(OCCLUSION_STATS_RING_SIZE, statsBuffers);
+	for (int i = 0; i < OCCLUSION_STATS_RING_SIZE; ++i)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, statsBuffers[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER, sizeof(u32) * (int)OCCLUSION_COUNTER::MAX, NULL, GL_STREAM_READ);
+		GetGpuMemory().TrackBuffer(statsBuffers[i], GPU_MEMORY_CATEGORY::READBACK, "Occlusion stats", sizeof(u32) * (int)OCCLUSION_COUNTER::MAX);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+void OcclusionCulling::UploadObjects(App* app)
+{
+	objects.clear();
+	commands.clear();
+
+	int entityCount = app->entities.size();
+	for (int i = 0; i < entityCount; ++i)
+	{
+		Entity& entity = app->entities[i];
+		Model& model = app->models[entity.modelIdx];
+		Mesh& mesh = app->meshes[model.meshIdx];
+
+		glm::vec3 worldMin, worldMax;
+		TransformAABB(app->transforms.GetWorld(i), mesh.aabbMin, mesh.aabbMax, worldMin, worldMax);
+
+		//Entities pruned on the cpu keep their slot so the visibility buffer stays indexed by entity
+		int submeshCount = entity.culled == true ? 0 : mesh.submeshes.size();
+
+		CullObject object = {};
+		object.aabbMin = glm::vec4(worldMin, 1.f);
+		object.aabbMax = glm::vec4(worldMax, 1.f);
+		object.firstDraw = commands.size();
+		object.drawCount = submeshCount;
+		objects.push_back(object);
+
+		for (int j = 0; j < submeshCount; ++j)
+		{
+			DrawElementsIndirectCommand command = {};
+			command.count = mesh.submeshes[j].indices.size();
+			command.instanceCount = 0;
+			command.firstIndex = mesh.submeshes[j].indexOffset / sizeof(u32);
+			command.baseVertex = 0;
+			command.baseInstance = 0;
+			commands.push_back(command);
+		}
+	}
+
+	objectCount = objects.size();
+	drawCount = commands.size();
+
+	if (drawCount == 0)
+		return;
+
+	ReserveBuffer(objectBuffer, objectBufferCapacity, objectCount * sizeof(CullObject), GL_DYNAMIC_DRAW, "Occlusion objects");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, objectBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, objectCount * sizeof(CullObject), objects.data());
+
+	ReserveBuffer(phaseOneCommandBuffer, phaseOneCommandBufferCapacity, drawCount * sizeof(DrawElementsIndirectCommand), GL_DYNAMIC_DRAW, "Occlusion phase one commands");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, phaseOneCommandBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, drawCount * sizeof(DrawElementsIndirectCommand), commands.data());
+
+	ReserveBuffer(phaseTwoCommandBuffer, phaseTwoCommandBufferCapacity, drawCount * sizeof(DrawElementsIndirectCommand), GL_DYNAMIC_DRAW, "Occlusion phase two commands");
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, phaseTwoCommandBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, drawCount * sizeof(DrawElementsIndirectCommand), commands.data());
+
+	//The visibility of last frame is meaningless once the entity list changes
+	if (visibilityObjectCount != objectCount)
+	{
+		ReserveBuffer(visibilityBuffer, visibilityBufferCapacity, objectCount * sizeof(u32), GL_DYNAMIC_COPY, "Occlusion visibility");
+
+		u32 zero = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibilityBuffer);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+		visibilityObjectCount = objectCount;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+
+void OcclusionCulling::Cull(App* app, int phase)
+{
+	if (phase == 2)
+	{
+		u32 zero = 0;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	Program& program = app->programs[cullProgramIdx];
+	glUseProgram(program.handle);
+
+	glm::mat4 viewProjection = app->camera.GetProjectionMatrix() * app->camera.GetViewMatrix();
+
+	u32 uniformLoc = glGetUniformLocation(program.handle, "uViewProjection");
+	glUniformMatrix4fv(uniformLoc, 1, GL_FALSE, glm::value_ptr(viewProjection));
+
+	uniformLoc = glGetUniformLocation(program.handle, "uPhase");
+	glUniform1i(uniformLoc, phase);
+
+	uniformLoc = glGetUniformLocation(program.handle, "uObjectCount");
+	glUniform1ui(uniformLoc, objectCount);
+
+	uniformLoc = glGetUniformLocation(program.handle, "uHiZSize");
+	glUniform2f(uniformLoc, hiZSizeX, hiZSizeY);
+
+	uniformLoc = glGetUniformLocation(program.handle, "uRenderScale");
+	glUniform2fv(uniformLoc, 1, glm::value_ptr(app->renderScale));
+
+	uniformLoc = glGetUniformLocation(program.handle, "uHiZMipCount");
+	glUniform1i(uniformLoc, hiZMipCount);
+
+	uniformLoc = glGetUniformLocation(program.handle, "hiZ");
+	glUniform1i(uniformLoc, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, hiZTexture);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(0), objectBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(1), phaseOneCommandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(2), phaseTwoCommandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(3), visibilityBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(4), counterBuffer);
+
+	glDispatchCompute((objectCount + OCCLUSION_CULL_GROUP_SIZE - 1) / OCCLUSION_CULL_GROUP_SIZE, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	for (int i = 0; i < 5; ++i)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BINDING(i), 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+}
+
+
+void OcclusionCulling::DrawIndirect(App* app, const Program& program, u32 commandBuffer)
+{
+	glUseProgram(program.handle);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+
+	u32 geometryUniformTexture = glGetUniformLocation(program.handle, "uTexture");
+	u32 commandIdx = 0;
+
+	int entityCount = app->entities.size();
+	for (int i = 0; i < entityCount; ++i)
+	{
+		if (app->entities[i].culled == true)
+			continue;
+
+		Model& model = app->models[app->entities[i].modelIdx];
+		Mesh& mesh = app->meshes[model.meshIdx];
+
+		int submeshCount = mesh.submeshes.size();
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(1), app->localUniformBuffer.handle, app->entities[i].localParamsOffset, app->entities[i].localParamsSize);
+
+		for (int j = 0; j < submeshCount; ++j, ++commandIdx)
+		{
+			u32 vao = FindVAO(mesh, j, program);
+			glBindVertexArray(vao);
+
+			u32 materialIdx = model.materialIdx[j];
+			Material& material = app->materials[materialIdx];
+
+			glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(2), app->materialUniformBuffer.handle, material.localParamsOffset, material.localParamsSize);
+
+			if (material.albedoTextureIdx != UINT32_MAX)
+			{
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, app->textures[material.albedoTextureIdx].handle);
+				glUniform1i(geometryUniformTexture, 0);
+			}
+
+			glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(u64)(commandIdx * sizeof(DrawElementsIndirectCommand)));
+		}
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+
+void OcclusionCulling::RequestStats()
+{
+	//Drop the oldest request if the gpu is that far behind
+	if (statsFences[statsWriteIdx] != 0)
+		glDeleteSync(statsFences[statsWriteIdx]);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, counterBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, statsBuffers[statsWriteIdx]);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(u32) * (int)OCCLUSION_COUNTER::MAX);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	statsFences[statsWriteIdx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	statsWriteIdx = (statsWriteIdx + 1) % OCCLUSION_STATS_RING_SIZE;
+}
+
+
+void OcclusionCulling::ReadStats()
+{
+	//Oldest request first, so the newest finished one ends up in the stats
+	for (int i = 0; i < OCCLUSION_STATS_RING_SIZE; ++i)
+	{
+		u32 idx = (statsWriteIdx + i) % OCCLUSION_STATS_RING_SIZE;
+
+		if (statsFences[idx] == 0)
+			continue;
+
+		GLenum status = glClientWaitSync(statsFences[idx], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue;
+
+		u32 counters[(int)OCCLUSION_COUNTER::MAX];
+		glBindBuffer(GL_COPY_READ_BUFFER, statsBuffers[idx]);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counters), counters);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+		visibleCount = counters[(int)OCCLUSION_COUNTER::VISIBLE];
+		occludedCount = counters[(int)OCCLUSION_COUNTER::OCCLUDED];
+		frustumCulledCount = counters[(int)OCCLUSION_COUNTER::FRUSTUM_CULLED];
+
+		glDeleteSync(statsFences[idx]);
+		statsFences[idx] = 0;
+	}
+}
+
+
+void OcclusionCulling::ReserveBuffer(u32& handle, u32& capacity, u32 size, GLenum usage, const char* owner)
+{
+	if (handle != 0 && capacity >= size)
+		return;
+
+	if (handle == 0)
+		glGenBuffers(1, &handle);
+
+	capacity = glm::max(size, capacity * 2);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, handle);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, NULL, usage);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	GetGpuMemory().TrackBuffer(handle, GPU_MEMORY_CATEGORY::STORAGE, owner, capacity);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "ModelStructures.h"
+#include "ShaderLayout.h"
+#include "glad/glad.h"
+
+#define OCCLUSION_STATS_RING_SIZE 3
+#define OCCLUSION_CULL_GROUP_SIZE 64
+#define HIZ_GROUP_SIZE 8
+
+struct App;
+
+//Gpu side layout of the objects, must match OcclusionCulling.glsl
+struct CullObject
+{
+	glm::vec4 aabbMin;
+	glm::vec4 aabbMax;
+	u32 firstDraw;
+	u32 drawCount;
+	u32 padding[2];
+};
+
+//std430 array of structs: the stride is the size rounded up to the vec4 alignment
+SHADER_ASSERT_OFFSET(CullObject, firstDraw, 32);
+SHADER_ASSERT_SIZE(CullObject, 48);
+
+
+//Same layout as the one glDrawElementsIndirect expects
+struct DrawElementsIndirectCommand
+{
+	u32 count;
+	u32 instanceCount;
+	u32 firstIndex;
+	u32 baseVertex;
+	u32 baseInstance;
+};
+
+SHADER_ASSERT_SIZE(DrawElementsIndirectCommand, 20);
+
+
+enum class OCCLUSION_COUNTER : int
+{
+	VISIBLE = 0,
+	OCCLUDED,
+	FRUSTUM_CULLED,
+	MAX
+};
+
+
+//Two phase occlusion culling against a hierarchical z pyramid:
+// - Phase one draws the entities that were visible last frame and builds the pyramid from their depth.
+// - Phase two tests every entity against the new pyramid, draws the ones that became visible
+//   and stores the visibility for the next frame.
+//The draw arguments are written by a compute shader so the cpu never waits for the results.
+struct OcclusionCulling
+{
+public:
+	OcclusionCulling(App* app);
+	~OcclusionCulling();
+
+	void Resize(int sizeX, int sizeY);
+
+	//Draws every entity of the scene with the given program, culling the occluded ones
+	void RenderModels(App* app, const Program& program);
+
+	//Rebuilds the pyramid from the depth attachment of the render framebuffer
+	void BuildHiZ(App* app);
+
+private:
+	void InitHiZ(int sizeX, int sizeY);
+	void InitBuffers();
+
+	void UploadObjects(App* app);
+	void Cull(App* app, int phase);
+	void DrawIndirect(App* app, const Program& program, u32 commandBuffer);
+
+	void RequestStats();
+	void ReadStats();
+
+	void ReserveBuffer(u32& handle, u32& capacity, u32 size, GLenum usage, const char* owner);
+
+public:
+	bool enabled = true;
+
+	//Hierarchical z pyramid, each texel stores the farthest depth it covers. Available for other effects.
+	u32 hiZTexture = 0;
+	int hiZSizeX = 0;
+	int hiZSizeY = 0;
+	int hiZMipCount = 0;
+
+	//Last stats received from the gpu, they are some frames old
+	u32 visibleCount = 0;
+	u32 occludedCount = 0;
+	u32 frustumCulledCount = 0;
+
+private:
+	u32 hiZProgramIdx;
+	u32 cullProgramIdx;
+
+	u32 objectBuffer = 0;
+	u32 objectBufferCapacity = 0;
+
+	u32 phaseOneCommandBuffer = 0;
+	u32 phaseOneCommandBufferCapacity = 0;
+	u32 phaseTwoCommandBuffer = 0;
+	u32 phaseTwoCommandBufferCapacity = 0;
+
+	u32 visibilityBuffer = 0;
+	u32 visibilityBufferCapacity = 0;
+	u32 visibilityObjectCount = 0;
+
+	u32 counterBuffer = 0;
+
+	u32 statsBuffers[OCCLUSION_STATS_RING_SIZE] = {};
+	GLsync statsFences[OCCLUSION_STATS_RING_SIZE] = {};
+	u32 statsWriteIdx = 0;
+
+	u32 objectCount = 0;
+	u32 drawCount = 0;
+
+	std::vector<CullObject> objects;
+	std::vector<DrawElementsIndirectCommand> commands;
+};
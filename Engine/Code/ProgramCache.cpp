@@ -0,0 +1,174 @@
+#include "ProgramCache.h"
+
+#include "engine.h"
+#include "Arena.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ull
+#define FNV_PRIME 1099511628211ull
+
+ProgramCache::ProgramCache(const OpenGLInfo& info)
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+
+	if (formatCount == 0)
+	{
+		ILOG("Program cache disabled, the driver has no program binary formats");
+		enabled = false;
+	}
+
+	else if (MakeDirectory(PROGRAM_CACHE_DIRECTORY) == false)
+	{
+		ELOG("Program cache disabled, could not create the directory %s", PROGRAM_CACHE_DIRECTORY);
+		enabled = false;
+	}
+
+	//Binaries are only valid for the exact driver that made them
+	driverKey = FNV_OFFSET_BASIS;
+	driverKey = Hash(driverKey, info.render.c_str(), info.render.size());
+	driverKey = Hash(driverKey, info.vendor.c_str(), info.vendor.size());
+	driverKey = Hash(driverKey, info.version.c_str(), info.version.size());
+}
+
+
+u64 ProgramCache::GetDriverKey() const
+{
+	return driverKey;
+}
+
+
+u64 ProgramCache::HashSources(u64 key, const char* const* sources, const int* lengths, int count)
+{
+	for (int i = 0; i < count; ++i)
+		key = Hash(key, sources[i], lengths[i]);
+
+	return key;
+}
+
+
+//FNV-1a
+u64 ProgramCache::Hash(u64 hash, const void* data, u32 size)
+{
+	const u8* bytes = (const u8*)data;
+
+	for (u32 i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+
+u32 ProgramCache::Load(const char* identity, u64 key)
+{
+	if (enabled == false)
+		return 0;
+
+	char path[256];
+	MakeFilePath(identity, path, sizeof(path));
+
+	FILE* file = fopen(path, "rb");
+
+	if (file == NULL)
+	{
+		missCount++;
+		return 0;
+	}
+
+	//The binary is only needed until the driver copies it
+	ArenaScope scratch(GetThreadArena());
+
+	ProgramBinaryHeader header = {};
+	u8* binary = nullptr;
+
+	bool valid = fread(&header, sizeof(header), 1, file) == 1;
+	valid = valid && header.magic == PROGRAM_CACHE_MAGIC && header.version == PROGRAM_CACHE_VERSION;
+
+	//Different source or driver, the file gets overwritten once the program is compiled again
+	valid = valid && header.key == key && header.size > 0;
+
+	if (valid == true)
+	{
+		binary = GetThreadArena().PushArray<u8>(header.size);
+		valid = fread(binary, 1, header.size, file) == header.size;
+	}
+
+	fclose(file);
+
+	if (valid == false)
+	{
+		missCount++;
+		return 0;
+	}
+
+	GLuint programHandle = glCreateProgram();
+	glProgramBinary(programHandle, header.format, binary, header.size);
+
+	GLint success;
+	glGetProgramiv(programHandle, GL_LINK_STATUS, &success);
+
+	//The driver can reject a binary even if its identity didn't change
+	if (!success)
+	{
+		glDeleteProgram(programHandle);
+		remove(path);
+
+		missCount++;
+		return 0;
+	}
+
+	hitCount++;
+	return programHandle;
+}
+
+
+void ProgramCache::Store(const char* identity, u64 key, u32 programHandle)
+{
+	if (enabled == false)
+		return;
+
+	GLint size = 0;
+	glGetProgramiv(programHandle, GL_PROGRAM_BINARY_LENGTH, &size);
+
+	if (size <= 0)
+		return;
+
+	ArenaScope scratch(GetThreadArena());
+	u8* binary = GetThreadArena().PushArray<u8>(size);
+
+	GLenum format = 0;
+	GLsizei length = 0;
+	glGetProgramBinary(programHandle, size, &length, &format, binary);
+
+	ProgramBinaryHeader header = {};
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.format = format;
+	header.size = length;
+
+	char path[256];
+	MakeFilePath(identity, path, sizeof(path));
+
+	FILE* file = fopen(path, "wb");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing program cache file %s", path);
+		return;
+	}
+
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(binary, 1, length, file);
+	fclose(file);
+}
+
+
+void ProgramCache::MakeFilePath(const char* identity, char* path, u32 pathSize) const
+{
+	u64 identityHash = Hash(FNV_OFFSET_BASIS, identity, strlen(identity));
+
+	snprintf(path, pathSize, "%s/%016llx.bin", PROGRAM_CACHE_DIRECTORY, identityHash);
+}
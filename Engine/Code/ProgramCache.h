@@ -0,0 +1,51 @@
+#pragma once
+
+#include "platform.h"
+
+#define PROGRAM_CACHE_DIRECTORY "ShaderCache"
+#define PROGRAM_CACHE_MAGIC 0x48434750	//"PGCH"
+#define PROGRAM_CACHE_VERSION 1
+
+struct OpenGLInfo;
+
+//Header of every cache file, followed by the binary returned by the driver
+struct ProgramBinaryHeader
+{
+	u32 magic;
+	u32 version;
+	u64 key;
+	u32 format;
+	u32 size;
+};
+
+
+//Stores the linked programs on disk with glGetProgramBinary so they don't have to be compiled on every launch.
+//Every program variant has one file, named after its name and defines. The file is only used if its key,
+//made from the full source given to the driver and the driver identity, matches. Otherwise it is compiled
+//again and overwritten.
+class ProgramCache
+{
+public:
+	ProgramCache(const OpenGLInfo& info);
+
+	//Key of a program: starts from the driver identity and is extended with every source string
+	u64 GetDriverKey() const;
+	static u64 HashSources(u64 key, const char* const* sources, const int* lengths, int count);
+	static u64 Hash(u64 hash, const void* data, u32 size);
+
+	//Returns 0 if there is no valid binary for the key
+	u32 Load(const char* identity, u64 key);
+	void Store(const char* identity, u64 key, u32 programHandle);
+
+private:
+	void MakeFilePath(const char* identity, char* path, u32 pathSize) const;
+
+public:
+	bool enabled = true;
+
+	u32 hitCount = 0;
+	u32 missCount = 0;
+
+private:
+	u64 driverKey = 0;
+};
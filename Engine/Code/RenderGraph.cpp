@@ -0,0 +1,343 @@
+#include "RenderGraph.h"
+
+#include "CpuProfiler.h"
+
+#include <glad/glad.h>
+#include <algorithm>
+
+static bool IsSameDesc(const RenderTargetDesc& a, const RenderTargetDesc& b)
+{
+	return a.sizeX == b.sizeX && a.sizeY == b.sizeY && a.internalFormat == b.internalFormat && a.mipCount == b.mipCount && a.samples == b.samples;
+}
+
+
+void RenderGraphPass::Read(u32 resource)
+{
+	reads.push_back(resource);
+}
+
+
+void RenderGraphPass::Write(u32 resource)
+{
+	writes.push_back(resource);
+}
+
+
+void RenderGraphPass::WriteColor(u32 resource)
+{
+	ASSERT(colorOutputs.size() < RENDER_TARGET_MAX_COLOR_ATTACHMENTS, "Too many color outputs");
+	colorOutputs.push_back(resource);
+}
+
+
+void RenderGraphPass::SetDepth(u32 resource, bool write)
+{
+	depthOutput = resource;
+	depthWrite = write;
+}
+
+
+void RenderGraphPass::SetSideEffect()
+{
+	sideEffect = true;
+}
+
+
+RenderGraph::RenderGraph()
+{
+}
+
+
+RenderGraph::~RenderGraph()
+{
+	for (u32 i = 0; i < frameTextures.size(); ++i)
+	{
+		GetRenderTargetPool().Release(frameTextures[i].handle);
+	}
+}
+
+
+void RenderGraph::Reset()
+{
+	passes.clear();
+	resources.clear();
+
+	compiled = false;
+}
+
+
+u32 RenderGraph::Import(const char* name, u32 texture)
+{
+	for (u32 i = 0; i < resources.size(); ++i)
+	{
+		if (resources[i].type == RENDER_GRAPH_RESOURCE::TEXTURE && resources[i].texture == texture)
+			return i;
+	}
+
+	RenderGraphResource resource = {};
+	resource.name = name;
+	resource.type = RENDER_GRAPH_RESOURCE::TEXTURE;
+	resource.texture = texture;
+
+	resources.push_back(resource);
+	return resources.size() - 1;
+}
+
+
+u32 RenderGraph::ImportWindow()
+{
+	for (u32 i = 0; i < resources.size(); ++i)
+	{
+		if (resources[i].type == RENDER_GRAPH_RESOURCE::WINDOW)
+			return i;
+	}
+
+	RenderGraphResource resource = {};
+	resource.name = "Window";
+	resource.type = RENDER_GRAPH_RESOURCE::WINDOW;
+
+	resources.push_back(resource);
+	return resources.size() - 1;
+}
+
+
+u32 RenderGraph::ImportExternal(const char* name)
+{
+	RenderGraphResource resource = {};
+	resource.name = name;
+	resource.type = RENDER_GRAPH_RESOURCE::EXTERNAL;
+
+	resources.push_back(resource);
+	return resources.size() - 1;
+}
+
+
+u32 RenderGraph::CreateTexture(const char* name, const RenderTargetDesc& desc)
+{
+	RenderGraphResource resource = {};
+	resource.name = name;
+	resource.type = RENDER_GRAPH_RESOURCE::TRANSIENT;
+	resource.desc = desc;
+
+	resources.push_back(resource);
+	return resources.size() - 1;
+}
+
+
+RenderGraphPass& RenderGraph::AddPass(const char* name, std::function<void()> execute)
+{
+	passes.push_back(RenderGraphPass());
+
+	RenderGraphPass& pass = passes.back();
+	pass.name = name;
+	pass.execute = std::move(execute);
+
+	return pass;
+}
+
+
+void RenderGraph::Compile()
+{
+	CPU_PROFILE_FUNCTION();
+
+	//From the last pass back: a pass is kept if a pass kept after it reads what it writes. Writes never end the
+	//need of a resource, so every pass that draws into a target read later is kept, not only the last one
+	std::vector<bool> needed(resources.size(), false);
+
+	for (int i = (int)passes.size() - 1; i >= 0; --i)
+	{
+		RenderGraphPass& pass = passes[i];
+		bool keep = pass.sideEffect;
+
+		for (u32 j = 0; j < pass.writes.size() && keep == false; ++j)
+			keep = needed[pass.writes[j]];
+
+		for (u32 j = 0; j < pass.colorOutputs.size() && keep == false; ++j)
+		{
+			u32 output = pass.colorOutputs[j];
+			if (output != RENDER_GRAPH_NONE)
+				keep = needed[output] || resources[output].type == RENDER_GRAPH_RESOURCE::WINDOW;
+		}
+
+		if (pass.depthOutput != RENDER_GRAPH_NONE && pass.depthWrite == true && keep == false)
+			keep = needed[pass.depthOutput];
+
+		pass.culled = keep == false;
+
+		if (pass.culled == true)
+			continue;
+
+		for (u32 j = 0; j < pass.reads.size(); ++j)
+			needed[pass.reads[j]] = true;
+
+		if (pass.depthOutput != RENDER_GRAPH_NONE)
+			needed[pass.depthOutput] = true;
+	}
+
+	//Lifetimes over the passes kept
+	for (u32 i = 0; i < resources.size(); ++i)
+	{
+		resources[i].firstPass = RENDER_GRAPH_NONE;
+		resources[i].lastPass = RENDER_GRAPH_NONE;
+	}
+
+	for (u32 i = 0; i < passes.size(); ++i)
+	{
+		const RenderGraphPass& pass = passes[i];
+		if (pass.culled == true)
+			continue;
+
+		for (u32 j = 0; j < pass.reads.size(); ++j)
+			UsePass(pass.reads[j], i);
+
+		for (u32 j = 0; j < pass.writes.size(); ++j)
+			UsePass(pass.writes[j], i);
+
+		for (u32 j = 0; j < pass.colorOutputs.size(); ++j)
+			UsePass(pass.colorOutputs[j], i);
+
+		UsePass(pass.depthOutput, i);
+	}
+
+	//Transients in the order they start, each takes a target that is free by then
+	std::vector<u32> transients;
+	for (u32 i = 0; i < resources.size(); ++i)
+	{
+		if (resources[i].type != RENDER_GRAPH_RESOURCE::TRANSIENT)
+			continue;
+
+		resources[i].texture = 0;
+
+		if (resources[i].firstPass != RENDER_GRAPH_NONE)
+			transients.push_back(i);
+	}
+
+	std::sort(transients.begin(), transients.end(), [this](u32 a, u32 b) { return resources[a].firstPass < resources[b].firstPass; });
+
+	for (u32 i = 0; i < transients.size(); ++i)
+	{
+		RenderGraphResource& resource = resources[transients[i]];
+
+		u32 textureIdx = AcquireTexture(resource.desc, resource.name, resource.firstPass);
+		frameTextures[textureIdx].busyUntilPass = resource.lastPass;
+
+		resource.texture = frameTextures[textureIdx].handle;
+	}
+
+	compiled = true;
+}
+
+
+void RenderGraph::Execute()
+{
+	CPU_PROFILE_FUNCTION();
+
+	ASSERT(compiled == true, "The render graph must be compiled first");
+
+	for (u32 i = 0; i < passes.size(); ++i)
+	{
+		RenderGraphPass& pass = passes[i];
+		if (pass.culled == true)
+			continue;
+
+		CPU_PROFILE_SCOPE(pass.name);
+
+		BindFramebuffer(pass);
+		pass.execute();
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	//Back to the pool, the next frame takes them again
+	for (u32 i = 0; i < frameTextures.size(); ++i)
+	{
+		GetRenderTargetPool().Release(frameTextures[i].handle);
+	}
+
+	frameTextures.clear();
+}
+
+
+u32 RenderGraph::GetTexture(u32 resource) const
+{
+	if (resource == RENDER_GRAPH_NONE)
+		return 0;
+
+	return resources[resource].texture;
+}
+
+
+const std::deque<RenderGraphPass>& RenderGraph::GetPasses() const
+{
+	return passes;
+}
+
+
+const std::vector<RenderGraphResource>& RenderGraph::GetResources() const
+{
+	return resources;
+}
+
+
+u32 RenderGraph::AcquireTexture(const RenderTargetDesc& desc, const char* name, u32 firstPass)
+{
+	//Only used by passes that run before the first one of the new transient
+	for (u32 i = 0; i < frameTextures.size(); ++i)
+	{
+		if (frameTextures[i].busyUntilPass < firstPass && IsSameDesc(frameTextures[i].desc, desc) == true)
+			return i;
+	}
+
+	FrameTexture texture;
+	texture.handle = GetRenderTargetPool().Acquire(desc, name);
+	texture.desc = desc;
+	texture.busyUntilPass = RENDER_GRAPH_NONE;
+
+	frameTextures.push_back(texture);
+	return frameTextures.size() - 1;
+}
+
+
+void RenderGraph::BindFramebuffer(const RenderGraphPass& pass)
+{
+	if (pass.colorOutputs.empty() == true && pass.depthOutput == RENDER_GRAPH_NONE)
+		return;
+
+	u32 colorTextures[RENDER_TARGET_MAX_COLOR_ATTACHMENTS] = {};
+	u32 colorCount = pass.colorOutputs.size();
+	bool window = false;
+
+	for (u32 i = 0; i < colorCount; ++i)
+	{
+		u32 output = pass.colorOutputs[i];
+
+		if (output != RENDER_GRAPH_NONE && resources[output].type == RENDER_GRAPH_RESOURCE::WINDOW)
+			window = true;
+		else
+			colorTextures[i] = GetTexture(output);
+	}
+
+	if (window == true)
+	{
+		ASSERT(colorCount == 1, "The window can't be drawn with other targets");
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		return;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, GetRenderTargetPool().GetFramebuffer(colorTextures, colorCount, GetTexture(pass.depthOutput)));
+}
+
+
+void RenderGraph::UsePass(u32 resource, u32 passIdx)
+{
+	if (resource == RENDER_GRAPH_NONE)
+		return;
+
+	RenderGraphResource& usage = resources[resource];
+
+	if (usage.firstPass == RENDER_GRAPH_NONE)
+		usage.firstPass = passIdx;
+
+	usage.lastPass = passIdx;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "platform.h"
+#include "RenderTargetPool.h"
+
+#include <functional>
+#include <deque>
+
+#define RENDER_GRAPH_NONE UINT32_MAX			//Resource of a color output left unbound
+
+
+enum class RENDER_GRAPH_RESOURCE : int
+{
+	TEXTURE = 0,	//Imported, it outlives the frame
+	TRANSIENT,		//Taken from the pool for the passes that use it
+	WINDOW,			//Default framebuffer, writing it keeps a pass
+	EXTERNAL		//Buffers or anything else, only used to order and cull the passes
+};
+
+
+struct RenderGraphResource
+{
+	const char* name;
+	RENDER_GRAPH_RESOURCE type;
+
+	u32 texture;					//Imported, or given by the pool when the graph is compiled
+	RenderTargetDesc desc;			//Transient only
+
+	//First and last of the passes kept that use it, RENDER_GRAPH_NONE if none does
+	u32 firstPass;
+	u32 lastPass;
+};
+
+
+struct RenderGraphPass
+{
+public:
+	//Sampled, fetched or loaded as an image
+	void Read(u32 resource);
+
+	//Written as an image or a buffer, no attachment
+	void Write(u32 resource);
+
+	//Attached as the next draw buffer, in the order of the fragment shader outputs
+	void WriteColor(u32 resource);
+
+	//Attached as depth. The depth test reads it even if it isn't written
+	void SetDepth(u32 resource, bool write);
+
+	//Never culled, for passes with results outside the graph (readbacks, queries)
+	void SetSideEffect();
+
+public:
+	const char* name;
+	std::function<void()> execute;
+
+	std::vector<u32> reads;
+	std::vector<u32> writes;
+	std::vector<u32> colorOutputs;
+	u32 depthOutput = RENDER_GRAPH_NONE;
+	bool depthWrite = false;
+	bool sideEffect = false;
+
+	bool culled = false;
+};
+
+
+//Passes of a frame with the resources they read and write. It is declared again every frame, in the order the
+//passes run. Compiling it culls the passes whose results nothing reads, down from the window and the side effects,
+//and gives the transient textures a target of the render target pool for the passes that use them. Targets with the
+//same description are shared by transients whose lifetimes don't overlap, and go back to the pool after the frame.
+//The framebuffer and draw buffers of every pass come from the attachments it declares, cached by the pool.
+class RenderGraph
+{
+public:
+	RenderGraph();
+	~RenderGraph();
+
+	void Reset();
+
+	//The same texture imported twice is the same resource
+	u32 Import(const char* name, u32 texture);
+	u32 ImportWindow();
+	u32 ImportExternal(const char* name);
+	u32 CreateTexture(const char* name, const RenderTargetDesc& desc);
+
+	//The reference stays valid until Reset()
+	RenderGraphPass& AddPass(const char* name, std::function<void()> execute);
+
+	void Compile();
+	void Execute();
+
+	//Valid once compiled, 0 if the transient isn't used by any pass kept
+	u32 GetTexture(u32 resource) const;
+
+	const std::deque<RenderGraphPass>& GetPasses() const;
+	const std::vector<RenderGraphResource>& GetResources() const;
+
+private:
+	u32 AcquireTexture(const RenderTargetDesc& desc, const char* name, u32 firstPass);
+	void BindFramebuffer(const RenderGraphPass& pass);
+
+	void UsePass(u32 resource, u32 passIdx);
+
+private:
+	std::deque<RenderGraphPass> passes;
+	std::vector<RenderGraphResource> resources;
+
+	//Taken from the pool this frame
+	struct FrameTexture
+	{
+		u32 handle;
+		RenderTargetDesc desc;
+		u32 busyUntilPass;		//Last pass of the transient using it
+	};
+	std::vector<FrameTexture> frameTextures;
+
+	bool compiled = false;
+};
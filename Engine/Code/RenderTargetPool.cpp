@@ -0,0 +1,266 @@
+#include "RenderTargetPool.h"
+
+#include "GpuMemory.h"
+#include "CpuProfiler.h"
+
+#include <glad/glad.h>
+#include <cstring>
+
+static bool IsSameDesc(const RenderTargetDesc& a, const RenderTargetDesc& b)
+{
+	return a.sizeX == b.sizeX && a.sizeY == b.sizeY && a.internalFormat == b.internalFormat && a.mipCount == b.mipCount && a.samples == b.samples;
+}
+
+
+RenderTargetPool::RenderTargetPool()
+{
+}
+
+
+RenderTargetPool::~RenderTargetPool()
+{
+	for (u32 i = 0; i < framebuffers.size(); ++i)
+	{
+		glDeleteFramebuffers(1, &framebuffers[i].handle);
+	}
+
+	for (u32 i = 0; i < targets.size(); ++i)
+	{
+		GetGpuMemory().ReleaseTexture(targets[i].handle);
+		glDeleteTextures(1, &targets[i].handle);
+	}
+}
+
+
+u32 RenderTargetPool::Acquire(const RenderTargetDesc& desc, const char* owner)
+{
+	for (u32 i = 0; i < targets.size(); ++i)
+	{
+		PooledTarget& target = targets[i];
+
+		if (target.free == false || IsSameDesc(target.desc, desc) == false)
+			continue;
+
+		target.free = false;
+		target.lastUsedFrame = frameIdx;
+		reusedCount++;
+
+		//The previous user may have changed it
+		SetDefaultSampling(target.handle, desc);
+
+		//Tracked again so the memory view shows who has it now
+		GetGpuMemory().TrackTexture(target.handle, GPU_MEMORY_CATEGORY::RENDER_TARGET, owner, desc.internalFormat, desc.sizeX, desc.sizeY, desc.samples, desc.mipCount);
+
+		return target.handle;
+	}
+
+	PooledTarget target = {};
+	target.desc = desc;
+	target.free = false;
+	target.lastUsedFrame = frameIdx;
+
+	glGenTextures(1, &target.handle);
+
+	if (desc.samples > 1)
+	{
+		ASSERT(desc.mipCount == 1, "Multisample targets have no mips");
+
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, target.handle);
+		glTexStorage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, desc.samples, desc.internalFormat, desc.sizeX, desc.sizeY, GL_TRUE);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, target.handle);
+		glTexStorage2D(GL_TEXTURE_2D, desc.mipCount, desc.internalFormat, desc.sizeX, desc.sizeY);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		SetDefaultSampling(target.handle, desc);
+	}
+
+	//Every sample takes the memory of a layer
+	GetGpuMemory().TrackTexture(target.handle, GPU_MEMORY_CATEGORY::RENDER_TARGET, owner, desc.internalFormat, desc.sizeX, desc.sizeY, desc.samples, desc.mipCount);
+
+	createdCount++;
+
+	targets.push_back(target);
+	return target.handle;
+}
+
+
+void RenderTargetPool::Release(u32 texture)
+{
+	if (texture == 0)
+		return;
+
+	for (u32 i = 0; i < targets.size(); ++i)
+	{
+		PooledTarget& target = targets[i];
+
+		if (target.handle != texture)
+			continue;
+
+		ASSERT(target.free == false, "The render target was already released");
+
+		target.free = true;
+		target.lastUsedFrame = frameIdx;
+
+		GetGpuMemory().TrackTexture(target.handle, GPU_MEMORY_CATEGORY::RENDER_TARGET, "Render target pool (free)", target.desc.internalFormat, target.desc.sizeX, target.desc.sizeY, target.desc.samples, target.desc.mipCount);
+		return;
+	}
+
+	ELOG("Render target pool: texture %u wasn't acquired from the pool", texture);
+}
+
+
+u32 RenderTargetPool::GetFramebuffer(const u32* colorTextures, u32 colorCount, u32 depthTexture)
+{
+	ASSERT(colorCount <= RENDER_TARGET_MAX_COLOR_ATTACHMENTS, "Too many color attachments");
+
+	u32 colors[RENDER_TARGET_MAX_COLOR_ATTACHMENTS] = {};
+	memcpy(colors, colorTextures, colorCount * sizeof(u32));
+
+	for (u32 i = 0; i < framebuffers.size(); ++i)
+	{
+		CachedFramebuffer& framebuffer = framebuffers[i];
+
+		if (framebuffer.colorCount != colorCount || framebuffer.depthTexture != depthTexture)
+			continue;
+
+		if (memcmp(framebuffer.colorTextures, colors, sizeof(colors)) != 0)
+			continue;
+
+		framebuffer.lastUsedFrame = frameIdx;
+		return framebuffer.handle;
+	}
+
+	CachedFramebuffer framebuffer = {};
+	memcpy(framebuffer.colorTextures, colors, sizeof(colors));
+	framebuffer.colorCount = colorCount;
+	framebuffer.depthTexture = depthTexture;
+	framebuffer.lastUsedFrame = frameIdx;
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+	glGenFramebuffers(1, &framebuffer.handle);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.handle);
+
+	//Unbound outputs keep their slot so the shader locations don't move
+	u32 drawBuffers[RENDER_TARGET_MAX_COLOR_ATTACHMENTS];
+	for (u32 i = 0; i < colorCount; ++i)
+	{
+		if (colors[i] != 0)
+		{
+			glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, colors[i], 0);
+			drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		}
+		else
+			drawBuffers[i] = GL_NONE;
+	}
+
+	if (depthTexture != 0)
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0);
+
+	if (colorCount > 0)
+		glDrawBuffers(colorCount, drawBuffers);
+	else
+		glDrawBuffer(GL_NONE);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		ELOG("Render target pool: framebuffer with %u color attachments is incomplete", colorCount);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+
+	framebuffers.push_back(framebuffer);
+	return framebuffer.handle;
+}
+
+
+void RenderTargetPool::EndFrame()
+{
+	CPU_PROFILE_FUNCTION();
+
+	for (int i = (int)targets.size() - 1; i >= 0; --i)
+	{
+		if (targets[i].free == false || frameIdx - targets[i].lastUsedFrame <= RENDER_TARGET_POOL_LIFETIME)
+			continue;
+
+		//Its name can be reused by a new texture, the framebuffers would attach that one instead
+		DeleteFramebuffersUsing(targets[i].handle);
+
+		GetGpuMemory().ReleaseTexture(targets[i].handle);
+		glDeleteTextures(1, &targets[i].handle);
+		targets.erase(targets.begin() + i);
+	}
+
+	for (int i = (int)framebuffers.size() - 1; i >= 0; --i)
+	{
+		if (frameIdx - framebuffers[i].lastUsedFrame > RENDER_TARGET_POOL_LIFETIME)
+		{
+			glDeleteFramebuffers(1, &framebuffers[i].handle);
+			framebuffers.erase(framebuffers.begin() + i);
+		}
+	}
+
+	frameIdx++;
+}
+
+
+RenderTargetPoolStats RenderTargetPool::GetStats() const
+{
+	RenderTargetPoolStats stats = {};
+	stats.targetCount = targets.size();
+	stats.framebufferCount = framebuffers.size();
+	stats.createdCount = createdCount;
+	stats.reusedCount = reusedCount;
+
+	for (u32 i = 0; i < targets.size(); ++i)
+	{
+		if (targets[i].free == true)
+			stats.freeCount++;
+	}
+
+	return stats;
+}
+
+
+void RenderTargetPool::SetDefaultSampling(u32 texture, const RenderTargetDesc& desc) const
+{
+	//Multisample textures are only fetched
+	if (desc.samples > 1)
+		return;
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.mipCount > 1 ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+void RenderTargetPool::DeleteFramebuffersUsing(u32 texture)
+{
+	for (int i = (int)framebuffers.size() - 1; i >= 0; --i)
+	{
+		bool attached = framebuffers[i].depthTexture == texture;
+		for (u32 j = 0; j < framebuffers[i].colorCount; ++j)
+			attached = attached || framebuffers[i].colorTextures[j] == texture;
+
+		if (attached == true)
+		{
+			glDeleteFramebuffers(1, &framebuffers[i].handle);
+			framebuffers.erase(framebuffers.begin() + i);
+		}
+	}
+}
+
+
+RenderTargetPool& GetRenderTargetPool()
+{
+	static RenderTargetPool pool;
+	return pool;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "platform.h"
+
+#define RENDER_TARGET_POOL_LIFETIME 8		//Frames a free target or a framebuffer is kept unused before it is deleted
+#define RENDER_TARGET_MAX_COLOR_ATTACHMENTS 8
+
+struct RenderTargetDesc
+{
+	int sizeX;
+	int sizeY;
+	u32 internalFormat;
+	int mipCount = 1;
+	int samples = 1;		//More than 1 is a multisample texture, without mips
+};
+
+
+struct RenderTargetPoolStats
+{
+	u32 targetCount;
+	u32 freeCount;
+	u32 framebufferCount;
+
+	u64 createdCount;		//Textures allocated since the start
+	u64 reusedCount;		//Acquires served by a free target
+};
+
+
+//Render target textures and the framebuffers that attach them, shared by everything that draws to a texture.
+//A target released goes back to the pool and is handed to the next acquire of the same size, format, mips and
+//samples, in this frame or a later one. Free targets and framebuffers unused for RENDER_TARGET_POOL_LIFETIME
+//frames are deleted, so resizing back and forth or drawing several views doesn't allocate every time.
+//The textures are immutable, they are never resized in place. Only used from the thread that owns the gl context.
+class RenderTargetPool
+{
+public:
+	RenderTargetPool();
+	~RenderTargetPool();
+
+	//Sampled linearly (nearest mip) and clamped, set anything else after every acquire. The owner is shown by the memory tracker
+	u32 Acquire(const RenderTargetDesc& desc, const char* owner);
+	void Release(u32 texture);
+
+	//Cached by its attachments, 0 leaves a color output unbound and keeps its draw buffer slot.
+	//The draw buffers are set when it is created, they are part of the framebuffer
+	u32 GetFramebuffer(const u32* colorTextures, u32 colorCount, u32 depthTexture);
+
+	//Deletes what wasn't used for long enough, once per frame
+	void EndFrame();
+
+	RenderTargetPoolStats GetStats() const;
+
+private:
+	void SetDefaultSampling(u32 texture, const RenderTargetDesc& desc) const;
+	void DeleteFramebuffersUsing(u32 texture);
+
+private:
+	struct PooledTarget
+	{
+		u32 handle;
+		RenderTargetDesc desc;
+		bool free;
+		u32 lastUsedFrame;
+	};
+	std::vector<PooledTarget> targets;
+
+	struct CachedFramebuffer
+	{
+		u32 handle;
+		u32 colorTextures[RENDER_TARGET_MAX_COLOR_ATTACHMENTS];
+		u32 colorCount;
+		u32 depthTexture;
+		u32 lastUsedFrame;
+	};
+	std::vector<CachedFramebuffer> framebuffers;
+
+	u32 frameIdx = 0;
+
+	u64 createdCount = 0;
+	u64 reusedCount = 0;
+};
+
+
+RenderTargetPool& GetRenderTargetPool();
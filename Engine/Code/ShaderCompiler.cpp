@@ -0,0 +1,246 @@
+#include "ShaderCompiler.h"
+
+#include "engine.h"
+#include "CpuProfiler.h"
+#include "ProgramCache.h"
+
+typedef void (APIENTRY* MaxShaderCompilerThreadsProc)(GLuint count);
+
+ShaderCompiler::ShaderCompiler(const OpenGLInfo& info)
+{
+	const char* threadsFunctionName = nullptr;
+
+	for (int i = 0; i < info.extensions.size(); ++i)
+	{
+		if (info.extensions[i] == "GL_KHR_parallel_shader_compile")
+		{
+			threadsFunctionName = "glMaxShaderCompilerThreadsKHR";
+			break;
+		}
+
+		if (info.extensions[i] == "GL_ARB_parallel_shader_compile")
+			threadsFunctionName = "glMaxShaderCompilerThreadsARB";
+	}
+
+	if (threadsFunctionName == nullptr)
+	{
+		ILOG("Parallel shader compile not supported, programs are checked on the next update");
+		return;
+	}
+
+	parallelCompile = true;
+
+	//Let the driver use as many threads as it wants
+	MaxShaderCompilerThreadsProc maxShaderCompilerThreads = (MaxShaderCompilerThreadsProc)GetGLProcAddress(threadsFunctionName);
+	if (maxShaderCompilerThreads != nullptr)
+		maxShaderCompilerThreads(0xFFFFFFFF);
+}
+
+
+GLuint ShaderCompiler::Submit(App* app, u32 programIdx, const char* cacheIdentity, const ShaderStageSource* stages, u32 stageCount)
+{
+	ASSERT(stageCount <= SHADER_COMPILER_MAX_STAGES, "Too many stages for a program");
+
+	//A newer version of the file replaces any reload still compiling
+	DiscardPending(app, programIdx);
+
+	PendingProgram pending = {};
+	pending.programIdx = programIdx;
+	pending.cacheIdentity = cacheIdentity;
+
+	pending.cacheKey = app->programCache->GetDriverKey();
+	for (u32 i = 0; i < stageCount; ++i)
+		pending.cacheKey = ProgramCache::HashSources(pending.cacheKey, stages[i].sources, stages[i].lengths, stages[i].count);
+
+	pending.handle = app->programCache->Load(cacheIdentity, pending.cacheKey);
+
+	if (pending.handle == 0)
+	{
+		pending.handle = glCreateProgram();
+
+		for (u32 i = 0; i < stageCount; ++i)
+		{
+			GLuint shader = glCreateShader(stages[i].type);
+			glShaderSource(shader, stages[i].count, stages[i].sources, stages[i].lengths);
+			glCompileShader(shader);
+			glAttachShader(pending.handle, shader);
+
+			pending.shaders[pending.shaderCount++] = shader;
+		}
+
+		glProgramParameteri(pending.handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(pending.handle);
+	}
+
+	pendingPrograms.push_back(pending);
+
+	return pending.handle;
+}
+
+
+void ShaderCompiler::Update(App* app)
+{
+	CPU_PROFILE_FUNCTION();
+
+	for (int i = 0; i < pendingPrograms.size();)
+	{
+		if (IsDone(pendingPrograms[i]) == true)
+		{
+			Finish(app, pendingPrograms[i]);
+			pendingPrograms.erase(pendingPrograms.begin() + i);
+		}
+		else
+			++i;
+	}
+}
+
+
+void ShaderCompiler::WaitAll(App* app)
+{
+	CPU_PROFILE_FUNCTION();
+
+	//Submission order, the driver has been working on all of them in the meantime
+	for (int i = 0; i < pendingPrograms.size(); ++i)
+		Finish(app, pendingPrograms[i]);
+
+	pendingPrograms.clear();
+}
+
+
+u32 ShaderCompiler::GetPendingCount() const
+{
+	return pendingPrograms.size();
+}
+
+
+bool ShaderCompiler::IsDone(const PendingProgram& pending) const
+{
+	//Cached binaries are already linked
+	if (parallelCompile == false || pending.shaderCount == 0)
+		return true;
+
+	GLint completed = GL_FALSE;
+	glGetProgramiv(pending.handle, GL_COMPLETION_STATUS_KHR, &completed);
+
+	return completed == GL_TRUE;
+}
+
+
+void ShaderCompiler::Finish(App* app, PendingProgram& pending)
+{
+	GLchar  infoLogBuffer[1024] = {};
+	GLsizei infoLogBufferSize = sizeof(infoLogBuffer);
+	GLsizei infoLogSize;
+	GLint   success;
+
+	Program& program = app->programs[pending.programIdx];
+
+	for (u32 i = 0; i < pending.shaderCount; ++i)
+	{
+		glGetShaderiv(pending.shaders[i], GL_COMPILE_STATUS, &success);
+		if (!success)
+		{
+			glGetShaderInfoLog(pending.shaders[i], infoLogBufferSize, &infoLogSize, infoLogBuffer);
+			ELOG("glCompileShader() failed with program %s\nReported message:\n%s\n", program.programName.c_str(), infoLogBuffer);
+		}
+
+		glDetachShader(pending.handle, pending.shaders[i]);
+		glDeleteShader(pending.shaders[i]);
+	}
+
+	glGetProgramiv(pending.handle, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(pending.handle, infoLogBufferSize, &infoLogSize, infoLogBuffer);
+		ELOG("glLinkProgram() failed with program %s\nReported message:\n%s\n", program.programName.c_str(), infoLogBuffer);
+
+		//Keep rendering with the last version that worked
+		if (program.handle != pending.handle)
+			glDeleteProgram(pending.handle);
+
+		return;
+	}
+
+	ValidateUniformBlocks(pending.handle, program.programName.c_str(), uniformBlockLayouts, uniformBlockLayoutCount);
+
+	if (pending.shaderCount > 0)
+		app->programCache->Store(pending.cacheIdentity.c_str(), pending.cacheKey, pending.handle);
+
+	//Hot reload, swap it now that it is ready
+	if (program.handle != pending.handle)
+	{
+		glDeleteProgram(program.handle);
+		program.handle = pending.handle;
+	}
+
+	if (program.reflectAttributes == true)
+		ReflectAttributes(program);
+}
+
+
+void ShaderCompiler::DiscardPending(App* app, u32 programIdx)
+{
+	GLuint currentHandle = app->programs[programIdx].handle;
+
+	for (int i = 0; i < pendingPrograms.size();)
+	{
+		PendingProgram& pending = pendingPrograms[i];
+
+		//Only reloads can be discarded, the first version is already in use
+		if (pending.programIdx == programIdx && pending.handle != currentHandle)
+		{
+			for (u32 j = 0; j < pending.shaderCount; ++j)
+				glDeleteShader(pending.shaders[j]);
+
+			glDeleteProgram(pending.handle);
+			pendingPrograms.erase(pendingPrograms.begin() + i);
+		}
+		else
+			++i;
+	}
+}
+
+
+void ShaderCompiler::ReflectAttributes(Program& program)
+{
+	program.layout.attributes.clear();
+
+	int attributeCount;
+	glGetProgramiv(program.handle, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+
+	for (int i = 0; i < attributeCount; ++i)
+	{
+		char* name = new char[1000];
+		int length;
+		int size;
+		GLenum type;
+
+		glGetActiveAttrib(program.handle, i, 1000, &length, &size, &type, name);
+		u8 attributeLocation = glGetAttribLocation(program.handle, name);
+
+		u8 attributeCount = 0;
+		switch (type)
+		{
+		case GL_FLOAT:
+			attributeCount = 1;
+			break;
+
+		case GL_FLOAT_VEC2:
+			attributeCount = 2;
+			break;
+
+		case GL_FLOAT_VEC3:
+			attributeCount = 3;
+			break;
+
+		case GL_FLOAT_VEC4:
+			attributeCount = 4;
+			break;
+		default:
+			break;
+		}
+
+		program.layout.attributes.push_back(VertexShaderAttribute(attributeLocation, attributeCount));
+		delete[] name;
+	}
+}
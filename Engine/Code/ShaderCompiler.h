@@ -0,0 +1,70 @@
+#pragma once
+
+#include "platform.h"
+#include "glad/glad.h"
+
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+
+#define SHADER_COMPILER_MAX_STAGES 2
+
+struct App;
+struct Program;
+struct OpenGLInfo;
+
+//Sources of one stage, in the order they are given to glShaderSource
+struct ShaderStageSource
+{
+	GLenum type;
+	const GLchar* const* sources;
+	const GLint* lengths;
+	int count;
+};
+
+
+//Program that has been submitted to the driver but not checked yet
+struct PendingProgram
+{
+	u32 programIdx;
+	GLuint handle;
+
+	GLuint shaders[SHADER_COMPILER_MAX_STAGES];
+	u32 shaderCount;
+
+	std::string cacheIdentity;
+	u64 cacheKey;
+};
+
+
+//Submits the programs without asking for their status, so the driver can compile them while the engine keeps working.
+//With KHR_parallel_shader_compile the pending programs are polled every frame and only checked once they are done.
+//Without it, they are checked on the next update and the driver decides when to block.
+//A hot reload keeps the old program rendering until the new one links, a reload that fails is discarded.
+class ShaderCompiler
+{
+public:
+	ShaderCompiler(const OpenGLInfo& info);
+
+	//Returns the handle of the new program, it can be used right away but any query will wait for the link
+	GLuint Submit(App* app, u32 programIdx, const char* cacheIdentity, const ShaderStageSource* stages, u32 stageCount);
+
+	//Checks the programs that are done, without blocking if the extension is supported
+	void Update(App* app);
+
+	//Checks every pending program, blocking until all of them are linked
+	void WaitAll(App* app);
+
+	u32 GetPendingCount() const;
+
+private:
+	bool IsDone(const PendingProgram& pending) const;
+	void Finish(App* app, PendingProgram& pending);
+
+	void DiscardPending(App* app, u32 programIdx);
+	void ReflectAttributes(Program& program);
+
+public:
+	bool parallelCompile = false;
+
+private:
+	std::vector<PendingProgram> pendingPrograms;
+};
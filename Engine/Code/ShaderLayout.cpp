@@ -0,0 +1,59 @@
+#include "ShaderLayout.h"
+
+#include "glad/glad.h"
+
+bool ValidateUniformBlocks(u32 programHandle, const char* programName, const ShaderBlockLayout* layouts, u32 layoutCount)
+{
+	bool valid = true;
+
+	GLint blockCount = 0;
+	glGetProgramiv(programHandle, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+
+	for (int i = 0; i < blockCount; ++i)
+	{
+		char blockName[128];
+		glGetActiveUniformBlockName(programHandle, i, sizeof(blockName), NULL, blockName);
+
+		const ShaderBlockLayout* layout = nullptr;
+		for (u32 j = 0; j < layoutCount && layout == nullptr; ++j)
+		{
+			if (strcmp(layouts[j].blockName, blockName) == 0)
+				layout = &layouts[j];
+		}
+
+		if (layout == nullptr)
+			continue;
+
+		//Blocks can declare less than the cpu side (LocalParams on the forward path), never more
+		GLint blockSize = 0;
+		glGetActiveUniformBlockiv(programHandle, i, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+
+		if ((u32)blockSize > layout->size)
+		{
+			ELOG("Uniform block %s of program %s takes %d bytes, the cpu layout only %u", blockName, programName, blockSize, layout->size);
+			valid = false;
+		}
+
+		for (u32 j = 0; j < layout->memberCount; ++j)
+		{
+			const ShaderMemberLayout& member = layout->members[j];
+
+			GLuint uniformIdx = GL_INVALID_INDEX;
+			glGetUniformIndices(programHandle, 1, &member.name, &uniformIdx);
+
+			if (uniformIdx == GL_INVALID_INDEX)
+				continue;
+
+			GLint offset = 0;
+			glGetActiveUniformsiv(programHandle, 1, &uniformIdx, GL_UNIFORM_OFFSET, &offset);
+
+			if ((u32)offset != member.offset)
+			{
+				ELOG("Member %s of uniform block %s in program %s is at offset %d, the cpu layout expects %u", member.name, blockName, programName, offset, member.offset);
+				valid = false;
+			}
+		}
+	}
+
+	return valid;
+}
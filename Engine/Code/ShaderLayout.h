@@ -0,0 +1,66 @@
+#pragma once
+
+#include "platform.h"
+
+#include <stddef.h>
+
+//Base alignment of the GLSL types, in bytes. It is the same for std140 and std430,
+//the layouts only differ on the stride of arrays and the alignment of structs.
+template<typename T> struct ShaderAlignment;
+
+template<> struct ShaderAlignment<float>     { static constexpr u32 value = 4; };
+template<> struct ShaderAlignment<u32>       { static constexpr u32 value = 4; };
+template<> struct ShaderAlignment<i32>       { static constexpr u32 value = 4; };
+template<> struct ShaderAlignment<glm::vec2> { static constexpr u32 value = 8; };
+template<> struct ShaderAlignment<glm::vec3> { static constexpr u32 value = 16; };
+template<> struct ShaderAlignment<glm::vec4> { static constexpr u32 value = 16; };
+template<> struct ShaderAlignment<glm::mat4> { static constexpr u32 value = 16; };
+
+//Member of a block placed where GLSL expects it. A vec3 still takes 12 bytes, so a scalar after it fills the last 4.
+//Structs inside a block are declared with alignas(16), std140 and std430 round them up to a vec4.
+#define SHADER_MEMBER(type, name) alignas(ShaderAlignment<type>::value) type name
+
+#define SHADER_ASSERT_OFFSET(block, member, offset) \
+	static_assert(offsetof(block, member) == (offset), #block "::" #member " doesn't match the offset of the GLSL block")
+
+#define SHADER_ASSERT_SIZE(block, size) \
+	static_assert(sizeof(block) == (size), #block " doesn't match the size of the GLSL block")
+
+
+//std140 arrays round the stride of every element up to a vec4, float[6] takes the space of vec4[6]
+template<typename T, u32 Count>
+struct Std140Array
+{
+	struct alignas(16) Element
+	{
+		T value;
+	};
+
+	T& operator[](u32 idx) { return elements[idx].value; }
+	const T& operator[](u32 idx) const { return elements[idx].value; }
+
+	Element elements[Count];
+};
+
+
+//Offset a member is expected at, by the name the driver gives it (arrays by their first element: "uLight[0].color")
+struct ShaderMemberLayout
+{
+	const char* name;
+	u32 offset;
+};
+
+
+struct ShaderBlockLayout
+{
+	const char* blockName;
+	u32 size;
+
+	const ShaderMemberLayout* members;
+	u32 memberCount;
+};
+
+
+//Compares every uniform block of a linked program with the cpu layout of the same name and logs the differences.
+//Blocks without a cpu layout and members the driver doesn't report are skipped.
+bool ValidateUniformBlocks(u32 programHandle, const char* programName, const ShaderBlockLayout* layouts, u32 layoutCount);
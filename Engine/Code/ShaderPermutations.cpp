@@ -0,0 +1,233 @@
+#include "ShaderPermutations.h"
+
+#include "engine.h"
+#include "CpuProfiler.h"
+
+#include <sstream>
+
+//Shifted in 64 bits, a feature can take the whole key
+static u32 GetFeatureMask(const ShaderFeature& feature)
+{
+	return (u32)((1ull << feature.bitCount) - 1ull);
+}
+
+
+u32 ShaderPermutations::Register(const char* filepath, const char* programName)
+{
+	for (int i = 0; i < permutations.size(); ++i)
+	{
+		if (permutations[i].filepath == filepath && permutations[i].programName == programName)
+			return i;
+	}
+
+	ShaderPermutation permutation;
+	permutation.filepath = filepath;
+	permutation.programName = programName;
+	permutations.push_back(permutation);
+
+	return permutations.size() - 1;
+}
+
+
+void ShaderPermutations::AddFeature(u32 permutationIdx, const char* name, u32 bitOffset, u32 bitCount)
+{
+	ShaderPermutation& permutation = permutations[permutationIdx];
+
+	for (int i = 0; i < permutation.features.size(); ++i)
+	{
+		if (permutation.features[i].name == name)
+			return;
+	}
+
+	ASSERT(bitCount > 0, "Shader features need at least one bit");
+	ASSERT(bitOffset + bitCount <= 32, "Shader features don't fit in the variant key");
+	permutation.features.push_back({ name, bitOffset, bitCount });
+}
+
+
+u32 ShaderPermutations::GetVariant(App* app, u32 permutationIdx, u32 key)
+{
+	ShaderPermutation& permutation = permutations[permutationIdx];
+	int variantCount = permutation.variants.size();
+
+	for (int i = 0; i < variantCount; ++i)
+	{
+		if (permutation.variants[i].key == key)
+			return permutation.variants[i].programIdx;
+	}
+
+	std::string defines = BuildDefines(permutation, key);
+
+	ShaderVariant variant;
+	variant.key = key;
+	variant.programIdx = CreateProgram(app, permutation.filepath.c_str(), permutation.programName.c_str(), defines.c_str());
+	permutation.variants.push_back(variant);
+
+	return variant.programIdx;
+}
+
+
+void ShaderPermutations::Prewarm(App* app, const char* manifestPath)
+{
+	CPU_PROFILE_FUNCTION();
+
+	FILE* file = fopen(manifestPath, "rb");
+
+	//The manifest is optional
+	if (file == NULL)
+		return;
+
+	fclose(file);
+
+	String text = ReadTextFile(manifestPath);
+	std::istringstream stream(std::string(text.str, text.len));
+
+	std::string line;
+	u32 lineNumber = 0;
+
+	while (std::getline(stream, line))
+	{
+		lineNumber++;
+
+		//Blank lines and comments
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+
+		u32 permutationIdx;
+		u32 key;
+
+		if (ParseManifestLine(line, permutationIdx, key) == true)
+			GetVariant(app, permutationIdx, key);
+		else
+			ELOG("Unknown program or feature in line %u of %s", lineNumber, manifestPath);
+	}
+}
+
+
+void ShaderPermutations::SaveManifest(const char* manifestPath) const
+{
+	FILE* file = fopen(manifestPath, "wb");
+
+	if (file == NULL)
+	{
+		ELOG("fopen() failed writing shader manifest %s", manifestPath);
+		return;
+	}
+
+	fprintf(file, "# Variants compiled at startup: program name followed by its features\n");
+
+	for (int i = 0; i < permutations.size(); ++i)
+	{
+		const ShaderPermutation& permutation = permutations[i];
+
+		for (int j = 0; j < permutation.variants.size(); ++j)
+		{
+			u32 key = permutation.variants[j].key;
+			fprintf(file, "%s", permutation.programName.c_str());
+
+			for (int k = 0; k < permutation.features.size(); ++k)
+			{
+				const ShaderFeature& feature = permutation.features[k];
+				u32 value = (key >> feature.bitOffset) & GetFeatureMask(feature);
+
+				if (feature.bitCount == 1 && value != 0)
+					fprintf(file, " %s", feature.name.c_str());
+				else if (feature.bitCount > 1)
+					fprintf(file, " %s=%u", feature.name.c_str(), value);
+			}
+
+			fprintf(file, "\n");
+		}
+	}
+
+	fclose(file);
+}
+
+
+u32 ShaderPermutations::GetVariantCount() const
+{
+	u32 count = 0;
+
+	for (int i = 0; i < permutations.size(); ++i)
+		count += permutations[i].variants.size();
+
+	return count;
+}
+
+
+std::string ShaderPermutations::BuildDefines(const ShaderPermutation& permutation, u32 key) const
+{
+	std::string defines;
+	char line[128];
+
+	for (int i = 0; i < permutation.features.size(); ++i)
+	{
+		const ShaderFeature& feature = permutation.features[i];
+		u32 value = (key >> feature.bitOffset) & GetFeatureMask(feature);
+
+		if (feature.bitCount == 1)
+		{
+			if (value != 0)
+			{
+				sprintf_s(line, 128, "#define %s\n", feature.name.c_str());
+				defines += line;
+			}
+		}
+		else
+		{
+			sprintf_s(line, 128, "#define %s %u\n", feature.name.c_str(), value);
+			defines += line;
+		}
+	}
+
+	return defines;
+}
+
+
+bool ShaderPermutations::ParseManifestLine(const std::string& line, u32& permutationIdx, u32& key) const
+{
+	std::istringstream tokens(line);
+
+	std::string programName;
+	if (!(tokens >> programName))
+		return false;
+
+	permutationIdx = UINT32_MAX;
+	for (int i = 0; i < permutations.size(); ++i)
+	{
+		if (permutations[i].programName == programName)
+			permutationIdx = i;
+	}
+
+	if (permutationIdx == UINT32_MAX)
+		return false;
+
+	const ShaderPermutation& permutation = permutations[permutationIdx];
+	key = 0;
+
+	std::string token;
+	while (tokens >> token)
+	{
+		size_t separator = token.find('=');
+		std::string name = token.substr(0, separator);
+		u32 value = separator == std::string::npos ? 1 : (u32)strtoul(token.c_str() + separator + 1, NULL, 10);
+
+		bool found = false;
+		for (int i = 0; i < permutation.features.size() && found == false; ++i)
+		{
+			const ShaderFeature& feature = permutation.features[i];
+
+			if (feature.name == name)
+			{
+				key |= (value & GetFeatureMask(feature)) << feature.bitOffset;
+				found = true;
+			}
+		}
+
+		if (found == false)
+			return false;
+	}
+
+	return true;
+}
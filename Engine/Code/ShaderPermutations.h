@@ -0,0 +1,61 @@
+#pragma once
+
+#include "platform.h"
+
+#define SHADER_VARIANT_MANIFEST "ShaderVariants.txt"
+
+struct App;
+
+//Part of the variant key that becomes a define.
+//One bit features are defined only when set, wider ones are always defined with their value.
+struct ShaderFeature
+{
+	std::string name;
+	u32 bitOffset;
+	u32 bitCount;
+};
+
+
+struct ShaderVariant
+{
+	u32 key;
+	u32 programIdx;
+};
+
+
+struct ShaderPermutation
+{
+	std::string filepath;
+	std::string programName;
+
+	std::vector<ShaderFeature> features;
+	std::vector<ShaderVariant> variants;
+};
+
+
+//Compiles a program once per combination of features, so the shaders can be specialized with #ifdef
+//instead of branching on uniforms. Variants are compiled the first time they are asked for, or at startup
+//if they are listed in the manifest. Every line of the manifest is a program name followed by its features,
+//NAME for one bit features and NAME=value for wider ones.
+class ShaderPermutations
+{
+public:
+	//Returns the same index if the program was already registered
+	u32 Register(const char* filepath, const char* programName);
+	void AddFeature(u32 permutationIdx, const char* name, u32 bitOffset, u32 bitCount = 1);
+
+	//Index in app->programs of the variant, compiled if it doesn't exist yet
+	u32 GetVariant(App* app, u32 permutationIdx, u32 key);
+
+	void Prewarm(App* app, const char* manifestPath);
+	void SaveManifest(const char* manifestPath) const;
+
+	u32 GetVariantCount() const;
+
+private:
+	std::string BuildDefines(const ShaderPermutation& permutation, u32 key) const;
+	bool ParseManifestLine(const std::string& line, u32& permutationIdx, u32& key) const;
+
+private:
+	std::vector<ShaderPermutation> permutations;
+};
@@ -0,0 +1,98 @@
+#include "ShaderPreprocessor.h"
+
+static std::string GetDirectory(const std::string& path)
+{
+	size_t separator = path.find_last_of("/\\");
+
+	if (separator == std::string::npos)
+		return "";
+
+	return path.substr(0, separator + 1);
+}
+
+
+//Returns the path inside the quotes if the line is an #include
+static bool ParseInclude(const std::string& line, std::string& includePath)
+{
+	size_t start = line.find_first_not_of(" \t");
+	if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+		return false;
+
+	size_t open = line.find('"', start + 8);
+	size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+
+	if (close == std::string::npos)
+		return false;
+
+	includePath = line.substr(open + 1, close - open - 1);
+	return true;
+}
+
+
+static bool PreprocessFile(const std::string& path, u32 fileIdx, u32 depth, std::string& source, std::vector<std::string>& dependencies)
+{
+	if (depth > SHADER_INCLUDE_MAX_DEPTH)
+	{
+		ELOG("Shader includes deeper than %d levels in %s, there is probably a cycle", SHADER_INCLUDE_MAX_DEPTH, path.c_str());
+		return false;
+	}
+
+	String text = ReadTextFile(path.c_str());
+	if (text.str == NULL)
+		return false;
+
+	std::string directory = GetDirectory(path);
+	bool success = true;
+
+	u32 lineNumber = 0;
+	u32 lineStart = 0;
+
+	while (lineStart < text.len)
+	{
+		const char* lineEnd = (const char*)memchr(text.str + lineStart, '\n', text.len - lineStart);
+		u32 lineLength = lineEnd ? (u32)(lineEnd - (text.str + lineStart)) : text.len - lineStart;
+
+		std::string line(text.str + lineStart, lineLength);
+		lineStart += lineLength + 1;
+		lineNumber++;
+
+		std::string includePath;
+		if (ParseInclude(line, includePath) == false)
+		{
+			source += line;
+			source += '\n';
+			continue;
+		}
+
+		includePath = directory + includePath;
+
+		bool included = false;
+		for (int i = 0; i < dependencies.size() && included == false; ++i)
+			included = dependencies[i] == includePath;
+
+		if (included == false)
+		{
+			dependencies.push_back(includePath);
+			u32 includeIdx = dependencies.size();
+
+			source += "#line 1 " + std::to_string(includeIdx) + "\n";
+			success = PreprocessFile(includePath, includeIdx, depth + 1, source, dependencies) && success;
+		}
+
+		//Back to the line after the #include
+		source += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIdx) + "\n";
+	}
+
+	return success;
+}
+
+
+bool PreprocessShader(const char* filepath, std::string& source, std::vector<std::string>& dependencies)
+{
+	source.clear();
+	dependencies.clear();
+
+	source += "#line 1 0\n";
+
+	return PreprocessFile(filepath, 0, 0, source, dependencies);
+}
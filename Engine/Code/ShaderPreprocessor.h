@@ -0,0 +1,12 @@
+#pragma once
+
+#include "platform.h"
+
+#define SHADER_INCLUDE_MAX_DEPTH 16
+
+//Resolves the #include "file" lines of a shader, paths are relative to the file that includes them.
+//Every file is only pasted at its first #include, no matter the #ifdef around it, so includes go at the top of a section.
+//#line directives are added so errors report the file as the source string number: 0 is the program file
+//and n the n-th file of dependencies.
+//Returns false if a file can't be read or the includes are too deep (usually a cycle), source is left incomplete.
+bool PreprocessShader(const char* filepath, std::string& source, std::vector<std::string>& dependencies);
@@ -0,0 +1,357 @@
+#include "SoftwareOcclusion.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <float.h>
+
+//Shared edges must give exactly the same (negated) values on both triangles, otherwise the pixels on them are lost
+static void SetupEdge(const glm::vec3& from, const glm::vec3& to, float& a, float& b, float& c)
+{
+	bool flip = to.x < from.x || (to.x == from.x && to.y < from.y);
+
+	const glm::vec3& p0 = flip == true ? to : from;
+	const glm::vec3& p1 = flip == true ? from : to;
+
+	a = p0.y - p1.y;
+	b = p1.x - p0.x;
+	c = -(a * p0.x + b * p0.y);
+
+	if (flip == true)
+	{
+		a = -a;
+		b = -b;
+		c = -c;
+	}
+}
+
+
+SoftwareOcclusion::SoftwareOcclusion()
+{
+	depthBuffer = new float[SOFTWARE_OCCLUSION_WIDTH * SOFTWARE_OCCLUSION_HEIGHT];
+
+	u32 threadCount = GetJobSystem().GetThreadCount();
+	threadTriangles.resize(threadCount);
+	threadBins.resize(threadCount * SOFTWARE_OCCLUSION_TILE_COUNT);
+
+	Clear();
+}
+
+
+SoftwareOcclusion::~SoftwareOcclusion()
+{
+	delete[] depthBuffer;
+}
+
+
+void SoftwareOcclusion::Clear()
+{
+	std::fill(depthBuffer, depthBuffer + SOFTWARE_OCCLUSION_WIDTH * SOFTWARE_OCCLUSION_HEIGHT, 1.f);
+
+	occluders.clear();
+	occluderCount = 0;
+	occluderTriangleCount = 0;
+	rasterizedTriangleCount = 0;
+}
+
+
+void SoftwareOcclusion::AddOccluder(const float* vertices, u32 floatStride, const u32* indices, u32 indexCount, const glm::mat4& worldViewProjection)
+{
+	OccluderMesh occluder = {};
+	occluder.vertices = vertices;
+	occluder.floatStride = floatStride;
+	occluder.indices = indices;
+	occluder.indexCount = indexCount;
+	occluder.worldViewProjection = worldViewProjection;
+	occluders.push_back(occluder);
+
+	occluderCount++;
+	occluderTriangleCount += indexCount / 3;
+}
+
+
+void SoftwareOcclusion::Rasterize()
+{
+	CPU_PROFILE_FUNCTION();
+
+	binJobs.clear();
+
+	int occluderCount = occluders.size();
+	for (int i = 0; i < occluderCount; ++i)
+	{
+		u32 triangleCount = occluders[i].indexCount / 3;
+		for (u32 first = 0; first < triangleCount; first += SOFTWARE_OCCLUSION_TRIANGLES_PER_JOB)
+		{
+			binJobs.push_back(BinJob{ (u32)i, first });
+		}
+	}
+
+	int threadCount = threadTriangles.size();
+	for (int i = 0; i < threadCount; ++i)
+	{
+		threadTriangles[i].clear();
+	}
+
+	int binCount = threadBins.size();
+	for (int i = 0; i < binCount; ++i)
+	{
+		threadBins[i].clear();
+	}
+
+	//Setup and bin the triangles, then every tile is rasterized by a single thread
+	GetJobSystem().ParallelFor("BinTriangles", binJobs.size(), 1, [this](u32 jobIdx, u32 threadIdx) { BinTriangles(jobIdx, threadIdx); });
+	GetJobSystem().ParallelFor("RasterizeTile", SOFTWARE_OCCLUSION_TILE_COUNT, 1, [this](u32 tileIdx, u32 /*threadIdx*/) { RasterizeTile(tileIdx); });
+
+	for (int i = 0; i < threadCount; ++i)
+	{
+		rasterizedTriangleCount += threadTriangles[i].size();
+	}
+}
+
+
+bool SoftwareOcclusion::IsVisible(const glm::vec3& aabbMin, const glm::vec3& aabbMax, const glm::mat4& viewProjection) const
+{
+	glm::vec3 ndcMin(FLT_MAX);
+	glm::vec3 ndcMax(-FLT_MAX);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		glm::vec4 corner((i & 1) ? aabbMax.x : aabbMin.x,
+						 (i & 2) ? aabbMax.y : aabbMin.y,
+						 (i & 4) ? aabbMax.z : aabbMin.z,
+						 1.f);
+
+		glm::vec4 clip = viewProjection * corner;
+
+		//Crossing the near plane, we can't say anything about it
+		if (clip.w <= 0.00001f)
+			return true;
+
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+
+	//Outside of the frustum
+	if (ndcMax.x < -1.f || ndcMin.x > 1.f || ndcMax.y < -1.f || ndcMin.y > 1.f || ndcMin.z > 1.f)
+		return false;
+
+	int minX = glm::max(0, (int)floor((ndcMin.x * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_WIDTH));
+	int minY = glm::max(0, (int)floor((ndcMin.y * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_HEIGHT));
+	int maxX = glm::min(SOFTWARE_OCCLUSION_WIDTH, (int)ceil((ndcMax.x * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_WIDTH));
+	int maxY = glm::min(SOFTWARE_OCCLUSION_HEIGHT, (int)ceil((ndcMax.y * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_HEIGHT));
+
+	float closestDepth = glm::max(0.f, ndcMin.z * 0.5f + 0.5f);
+
+	//Visible as soon as one occluder texel is farther than the closest point of the box
+	for (int y = minY; y < maxY; ++y)
+	{
+		const float* row = depthBuffer + y * SOFTWARE_OCCLUSION_WIDTH;
+		int x = minX;
+
+#if defined(__AVX2__)
+		__m256 closest = _mm256_set1_ps(closestDepth);
+		for (; x + 8 <= maxX; x += 8)
+		{
+			__m256 depth = _mm256_loadu_ps(row + x);
+			if (_mm256_movemask_ps(_mm256_cmp_ps(depth, closest, _CMP_GE_OQ)) != 0)
+				return true;
+		}
+#endif
+
+		for (; x < maxX; ++x)
+		{
+			if (row[x] >= closestDepth)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+
+const float* SoftwareOcclusion::GetDepthBuffer() const
+{
+	return depthBuffer;
+}
+
+
+void SoftwareOcclusion::BinTriangles(u32 jobIdx, u32 threadIdx)
+{
+	const BinJob& job = binJobs[jobIdx];
+	const OccluderMesh& occluder = occluders[job.occluderIdx];
+
+	std::vector<OccluderTriangle>& triangles = threadTriangles[threadIdx];
+	std::vector<u32>* bins = &threadBins[threadIdx * SOFTWARE_OCCLUSION_TILE_COUNT];
+
+	u32 triangleCount = occluder.indexCount / 3;
+	u32 lastTriangle = glm::min(triangleCount, job.firstTriangle + SOFTWARE_OCCLUSION_TRIANGLES_PER_JOB);
+
+	for (u32 t = job.firstTriangle; t < lastTriangle; ++t)
+	{
+		OccluderTriangle triangle;
+		bool discard = false;
+
+		for (int v = 0; v < 3; ++v)
+		{
+			const float* position = occluder.vertices + occluder.indices[t * 3 + v] * occluder.floatStride;
+			glm::vec4 clip = occluder.worldViewProjection * glm::vec4(position[0], position[1], position[2], 1.f);
+
+			//Clipping is not worth it for occluders, dropping the triangle is always conservative
+			if (clip.w <= 0.00001f || clip.z < -clip.w)
+			{
+				discard = true;
+				break;
+			}
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			triangle.v[v] = glm::vec3((ndc.x * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_WIDTH,
+									  (ndc.y * 0.5f + 0.5f) * SOFTWARE_OCCLUSION_HEIGHT,
+									  glm::min(1.f, ndc.z * 0.5f + 0.5f));
+		}
+
+		if (discard == true)
+			continue;
+
+		//Occluders are double sided, make every triangle counter clockwise
+		const glm::vec3& v0 = triangle.v[0];
+		const glm::vec3& v1 = triangle.v[1];
+		const glm::vec3& v2 = triangle.v[2];
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+		if (fabs(area) < 0.0001f)
+			continue;
+
+		if (area < 0.f)
+			std::swap(triangle.v[1], triangle.v[2]);
+
+		float minX = glm::min(v0.x, glm::min(v1.x, v2.x));
+		float minY = glm::min(v0.y, glm::min(v1.y, v2.y));
+		float maxX = glm::max(v0.x, glm::max(v1.x, v2.x));
+		float maxY = glm::max(v0.y, glm::max(v1.y, v2.y));
+
+		if (maxX < 0.f || maxY < 0.f || minX >= SOFTWARE_OCCLUSION_WIDTH || minY >= SOFTWARE_OCCLUSION_HEIGHT)
+			continue;
+
+		int tileMinX = glm::max(0, (int)minX / SOFTWARE_OCCLUSION_TILE_WIDTH);
+		int tileMinY = glm::max(0, (int)minY / SOFTWARE_OCCLUSION_TILE_HEIGHT);
+		int tileMaxX = glm::min(SOFTWARE_OCCLUSION_TILES_X - 1, (int)maxX / SOFTWARE_OCCLUSION_TILE_WIDTH);
+		int tileMaxY = glm::min(SOFTWARE_OCCLUSION_TILES_Y - 1, (int)maxY / SOFTWARE_OCCLUSION_TILE_HEIGHT);
+
+		u32 triangleIdx = triangles.size();
+		triangles.push_back(triangle);
+
+		for (int ty = tileMinY; ty <= tileMaxY; ++ty)
+		{
+			for (int tx = tileMinX; tx <= tileMaxX; ++tx)
+			{
+				bins[ty * SOFTWARE_OCCLUSION_TILES_X + tx].push_back(triangleIdx);
+			}
+		}
+	}
+}
+
+
+void SoftwareOcclusion::RasterizeTile(u32 tileIdx)
+{
+	int tileMinX = (tileIdx % SOFTWARE_OCCLUSION_TILES_X) * SOFTWARE_OCCLUSION_TILE_WIDTH;
+	int tileMinY = (tileIdx / SOFTWARE_OCCLUSION_TILES_X) * SOFTWARE_OCCLUSION_TILE_HEIGHT;
+	int tileMaxX = tileMinX + SOFTWARE_OCCLUSION_TILE_WIDTH;
+	int tileMaxY = tileMinY + SOFTWARE_OCCLUSION_TILE_HEIGHT;
+
+	int threadCount = threadTriangles.size();
+	for (int t = 0; t < threadCount; ++t)
+	{
+		const std::vector<u32>& bin = threadBins[t * SOFTWARE_OCCLUSION_TILE_COUNT + tileIdx];
+		const std::vector<OccluderTriangle>& triangles = threadTriangles[t];
+
+		int binSize = bin.size();
+		for (int i = 0; i < binSize; ++i)
+		{
+			RasterizeTriangle(triangles[bin[i]], tileMinX, tileMinY, tileMaxX, tileMaxY);
+		}
+	}
+}
+
+
+void SoftwareOcclusion::RasterizeTriangle(const OccluderTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+	const glm::vec3& v0 = triangle.v[0];
+	const glm::vec3& v1 = triangle.v[1];
+	const glm::vec3& v2 = triangle.v[2];
+
+	int minX = glm::max(tileMinX, (int)floor(glm::min(v0.x, glm::min(v1.x, v2.x))));
+	int minY = glm::max(tileMinY, (int)floor(glm::min(v0.y, glm::min(v1.y, v2.y))));
+	int maxX = glm::min(tileMaxX, (int)ceil(glm::max(v0.x, glm::max(v1.x, v2.x))));
+	int maxY = glm::min(tileMaxY, (int)ceil(glm::max(v0.y, glm::max(v1.y, v2.y))));
+
+	if (minX >= maxX || minY >= maxY)
+		return;
+
+	//Edge functions E(x, y) = A * x + B * y + C, positive inside of a counter clockwise triangle
+	float a0, b0, c0, a1, b1, c1, a2, b2, c2;
+	SetupEdge(v1, v2, a0, b0, c0);	//Opposite to v0
+	SetupEdge(v2, v0, a1, b1, c1);	//Opposite to v1
+	SetupEdge(v0, v1, a2, b2, c2);	//Opposite to v2
+
+	//Depth plane from the barycentric weights
+	float invArea = 1.f / (a0 * v0.x + b0 * v0.y + c0);
+	float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * invArea;
+	float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * invArea;
+	float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * invArea;
+
+	//Tiles are aligned to 8 pixels so a full register never leaves the tile
+	int startX = minX & ~7;
+
+	for (int y = minY; y < maxY; ++y)
+	{
+		float* row = depthBuffer + y * SOFTWARE_OCCLUSION_WIDTH;
+		float py = y + 0.5f;
+
+		float rowE0 = b0 * py + c0;
+		float rowE1 = b1 * py + c1;
+		float rowE2 = b2 * py + c2;
+		float rowZ = zb * py + zc;
+
+#if defined(__AVX2__)
+		const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+		const __m256 zero = _mm256_setzero_ps();
+
+		for (int x = startX; x < maxX; x += 8)
+		{
+			__m256 px = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+
+			__m256 e0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a0), px), _mm256_set1_ps(rowE0));
+			__m256 e1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a1), px), _mm256_set1_ps(rowE1));
+			__m256 e2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(a2), px), _mm256_set1_ps(rowE2));
+
+			__m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)),
+										  _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+
+			if (_mm256_movemask_ps(inside) == 0)
+				continue;
+
+			__m256 depth = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(za), px), _mm256_set1_ps(rowZ));
+			__m256 current = _mm256_loadu_ps(row + x);
+			__m256 closest = _mm256_min_ps(current, depth);
+
+			_mm256_storeu_ps(row + x, _mm256_blendv_ps(current, closest, inside));
+		}
+#else
+		for (int x = startX; x < maxX; ++x)
+		{
+			float px = x + 0.5f;
+
+			if (a0 * px + rowE0 < 0.f || a1 * px + rowE1 < 0.f || a2 * px + rowE2 < 0.f)
+				continue;
+
+			float depth = za * px + rowZ;
+			if (depth < row[x])
+				row[x] = depth;
+		}
+#endif
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "platform.h"
+
+#define SOFTWARE_OCCLUSION_WIDTH 320
+#define SOFTWARE_OCCLUSION_HEIGHT 192
+#define SOFTWARE_OCCLUSION_TILE_WIDTH 64	//Must be a multiple of 8 (one AVX2 register)
+#define SOFTWARE_OCCLUSION_TILE_HEIGHT 32
+#define SOFTWARE_OCCLUSION_TILES_X (SOFTWARE_OCCLUSION_WIDTH / SOFTWARE_OCCLUSION_TILE_WIDTH)
+#define SOFTWARE_OCCLUSION_TILES_Y (SOFTWARE_OCCLUSION_HEIGHT / SOFTWARE_OCCLUSION_TILE_HEIGHT)
+#define SOFTWARE_OCCLUSION_TILE_COUNT (SOFTWARE_OCCLUSION_TILES_X * SOFTWARE_OCCLUSION_TILES_Y)
+#define SOFTWARE_OCCLUSION_TRIANGLES_PER_JOB 1024
+
+//Triangle already in occlusion buffer space: xy in pixels, z depth in [0, 1]
+struct OccluderTriangle
+{
+	glm::vec3 v[3];
+};
+
+
+struct OccluderMesh
+{
+	const float* vertices;
+	u32 floatStride;
+	const u32* indices;
+	u32 indexCount;
+	glm::mat4 worldViewProjection;
+};
+
+
+//Cpu rasterizer of a small set of occluders into a low resolution depth buffer.
+//It doesn't touch OpenGL, everything works from plain vertex and index arrays. The binning and the tiles run on the job system.
+//Usage per frame: Clear() -> AddOccluder() for each occluder -> Rasterize() -> IsVisible() for each object.
+class SoftwareOcclusion
+{
+public:
+	SoftwareOcclusion();
+	~SoftwareOcclusion();
+
+	void Clear();
+	void AddOccluder(const float* vertices, u32 floatStride, const u32* indices, u32 indexCount, const glm::mat4& worldViewProjection);
+	void Rasterize();
+
+	//Conservative test of a world space aabb against the rasterized occluders
+	bool IsVisible(const glm::vec3& aabbMin, const glm::vec3& aabbMax, const glm::mat4& viewProjection) const;
+
+	const float* GetDepthBuffer() const;
+
+private:
+	void BinTriangles(u32 jobIdx, u32 threadIdx);
+	void RasterizeTile(u32 tileIdx);
+	void RasterizeTriangle(const OccluderTriangle& triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+
+public:
+	//Stats of the last frame
+	u32 occluderCount = 0;
+	u32 occluderTriangleCount = 0;
+	u32 rasterizedTriangleCount = 0;
+
+private:
+	float* depthBuffer = nullptr;
+
+	std::vector<OccluderMesh> occluders;
+
+	//Triangle setup job: an occluder and the first triangle of the chunk
+	struct BinJob
+	{
+		u32 occluderIdx;
+		u32 firstTriangle;
+	};
+	std::vector<BinJob> binJobs;
+
+	//Every thread bins into its own lists so no locks are needed
+	std::vector<std::vector<OccluderTriangle>> threadTriangles;
+	std::vector<std::vector<u32>> threadBins;	//[thread * TILE_COUNT + tile]
+
+};
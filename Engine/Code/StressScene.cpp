@@ -0,0 +1,271 @@
+#include "StressScene.h"
+
+#include "engine.h"
+#include "assimp_model_loading.h"
+#include "CpuProfiler.h"
+
+#include <glm/gtx/color_space.hpp>
+#include <glm/gtc/constants.hpp>
+
+static const char* stressModelFiles[STRESS_SCENE_MAX_MODELS] =
+{
+	"DefaultShapes/cube.FBX",
+	"DefaultShapes/Sphere.fbx",
+	"DefaultShapes/Cylinder.FBX",
+	"DefaultShapes/Pyramid.FBX",
+	"Patrick/Patrick.obj"
+};
+
+
+void StressScene::Generate(App* app)
+{
+	CPU_PROFILE_FUNCTION();
+
+	if (active == false)
+	{
+		savedEntities = app->entities;
+		savedTransforms = app->transforms;
+		savedLights = app->lights;
+		active = true;
+	}
+
+	if (poolLoaded == false)
+	{
+		for (u32 i = 0; i < STRESS_SCENE_MAX_MODELS; ++i)
+		{
+			poolModels[i] = UINT32_MAX;
+
+			//The scene may have loaded it already
+			for (u32 j = 0; j < app->models.size(); ++j)
+			{
+				if (app->models[j].name == stressModelFiles[i])
+				{
+					poolModels[i] = j;
+					break;
+				}
+			}
+
+			if (poolModels[i] == UINT32_MAX)
+				poolModels[i] = LoadModel(app, stressModelFiles[i]);
+
+			if (poolModels[i] == UINT32_MAX)
+				ELOG("The stress scene can't use %s", stressModelFiles[i]);
+		}
+
+		poolLoaded = true;
+	}
+
+	u32 modelCount = glm::clamp(settings.modelCount, 1u, (u32)STRESS_SCENE_MAX_MODELS);
+	u32 materialCount = glm::clamp(settings.materialCount, 1u, (u32)STRESS_SCENE_MAX_MATERIALS);
+
+	random.seed(settings.seed);
+
+	//Every layout covers the area of the grid
+	u32 gridSide = (u32)glm::ceil(glm::sqrt((float)glm::max(settings.entityCount, 1u)));
+	extent = gridSide * settings.spacing * 0.5f;
+
+	clusterCenters.clear();
+	if (settings.layout == STRESS_LAYOUT::CLUSTERED)
+	{
+		u32 clusterCount = glm::max(settings.clusterCount, 1u);
+		for (u32 i = 0; i < clusterCount; ++i)
+			clusterCenters.push_back(glm::vec3((Random01() * 2.f - 1.f) * extent, 0.f, (Random01() * 2.f - 1.f) * extent));
+
+		//Twice as dense as the grid
+		clusterRadius = settings.spacing * glm::sqrt((float)settings.entityCount / clusterCount) * 0.25f;
+	}
+
+	ClearEntities(app);
+	app->entities.reserve(settings.entityCount);
+	app->transforms.Reserve(settings.entityCount);
+
+	for (u32 i = 0; i < settings.entityCount; ++i)
+	{
+		//Both picked from the index, so the counts only change what is drawn, not where
+		u32 poolIdx = i % modelCount;
+		u32 materialIdx = (i / modelCount) % materialCount;
+
+		u32 modelIdx = GetModel(app, poolIdx, materialIdx);
+		if (modelIdx == UINT32_MAX)
+			continue;
+
+		const Mesh& mesh = app->meshes[app->models[modelIdx].meshIdx];
+		glm::vec3 size = mesh.aabbMax - mesh.aabbMin;
+		float largestSide = glm::max(size.x, glm::max(size.y, size.z));
+		float scale = largestSide > 0.f ? settings.entitySize / largestSide : 1.f;
+
+		//Resting on the ground
+		glm::vec3 position = GetPosition(i, -mesh.aabbMin.y * scale);
+
+		glm::quat rotation = glm::quat(1.f, 0.f, 0.f, 0.f);
+		if (settings.layout != STRESS_LAYOUT::GRID)
+			rotation = glm::angleAxis(Random01() * glm::two_pi<float>(), glm::vec3(0.f, 1.f, 0.f));
+
+		app->entityIdCount++;
+		AddEntity(app, "Stress " + std::to_string(i), modelIdx, position, rotation, glm::vec3(scale));
+	}
+
+	app->lights.clear();
+	app->lights.reserve(settings.lightCount);
+
+	//The lighting uniform block holds no more
+	u32 lightCount = glm::min(settings.lightCount, (u32)GLOBAL_PARAMS_MAX_LIGHTS);
+
+	for (u32 i = 0; i < lightCount; ++i)
+	{
+		glm::vec3 color = glm::rgbColor(glm::vec3(Random01() * 360.f, 0.5f, 1.f));
+		glm::vec3 position = glm::vec3((Random01() * 2.f - 1.f) * extent, settings.spacing * 1.5f, (Random01() * 2.f - 1.f) * extent);
+
+		app->lights.push_back(Light(LIGHT_TYPE::POINT, color, glm::vec3(0.f, -1.f, 0.f), position));
+		app->lights.back().maxDistance = settings.spacing * 4.f;
+	}
+
+	generatedEntities = app->entities.size();
+	generatedLights = app->lights.size();
+
+	ILOG("Stress scene: %u entities, %u models, %u materials, %u lights, %s layout", generatedEntities, modelCount, materialCount,
+		generatedLights, GetStressLayoutName(settings.layout));
+}
+
+
+void StressScene::Restore(App* app)
+{
+	if (active == false)
+		return;
+
+	app->entities = savedEntities;
+	app->transforms = savedTransforms;
+	app->lights = savedLights;
+
+	savedEntities.clear();
+	savedTransforms.Clear();
+	savedLights.clear();
+	active = false;
+
+	generatedEntities = 0;
+	generatedLights = 0;
+}
+
+
+bool StressScene::IsActive() const
+{
+	return active;
+}
+
+
+float StressScene::GetExtent() const
+{
+	return extent;
+}
+
+
+u32 StressScene::GetModel(App* app, u32 poolIdx, u32 materialIdx)
+{
+	u32 baseModelIdx = poolModels[poolIdx];
+	if (baseModelIdx == UINT32_MAX)
+		return UINT32_MAX;
+
+	u32 key = poolIdx * STRESS_SCENE_MAX_MATERIALS + materialIdx;
+	u32 material = GetMaterial(app, materialIdx);
+
+	auto it = variants.find(key);
+	if (it == variants.end())
+	{
+		Model variant = {};
+		variant.meshIdx = app->models[baseModelIdx].meshIdx;
+		variant.name = app->models[baseModelIdx].name + " #" + std::to_string(materialIdx);
+
+		app->models.push_back(variant);
+		it = variants.emplace(key, (u32)app->models.size() - 1).first;
+	}
+
+	//The mesh may have been reloaded with another number of submeshes
+	Model& model = app->models[it->second];
+	model.materialIdx.assign(app->meshes[model.meshIdx].submeshes.size(), material);
+
+	return it->second;
+}
+
+
+u32 StressScene::GetMaterial(App* app, u32 materialIdx)
+{
+	while (materials.size() <= materialIdx)
+	{
+		u32 idx = materials.size();
+
+		//Hues spread with the golden ratio, so any count gives distinct colours
+		Material material = {};
+		material.name = "Stress " + std::to_string(idx);
+		material.albedo = glm::rgbColor(glm::vec3(glm::fract(idx * 0.618034f) * 360.f, 0.6f, 0.9f));
+		material.emissive = glm::vec3(0.f);
+		material.smoothness = (idx % 4) / 3.f;
+		material.reflectivity = (idx % 3) * 0.25f;
+
+		material.albedoTextureIdx = app->whiteTexIdx;
+		material.emissiveTextureIdx = UINT32_MAX;
+		material.specularTextureIdx = UINT32_MAX;
+		material.normalsTextureIdx = UINT32_MAX;
+		material.bumpTextureIdx = UINT32_MAX;
+
+		app->materials.push_back(material);
+		materials.push_back(app->materials.size() - 1);
+	}
+
+	return materials[materialIdx];
+}
+
+
+glm::vec3 StressScene::GetPosition(u32 idx, float y)
+{
+	switch (settings.layout)
+	{
+	case STRESS_LAYOUT::GRID:
+	{
+		u32 side = (u32)glm::ceil(glm::sqrt((float)glm::max(settings.entityCount, 1u)));
+		float offset = (side - 1) * settings.spacing * 0.5f;
+
+		return glm::vec3((idx % side) * settings.spacing - offset, y, (idx / side) * settings.spacing - offset);
+	}
+
+	case STRESS_LAYOUT::RANDOM:
+		return glm::vec3((Random01() * 2.f - 1.f) * extent, y, (Random01() * 2.f - 1.f) * extent);
+
+	case STRESS_LAYOUT::CLUSTERED:
+	{
+		const glm::vec3& center = clusterCenters[idx % clusterCenters.size()];
+
+		//The sum of two uniforms is denser in the middle. Stacked up too, to hide each other
+		float x = (Random01() + Random01() - 1.f) * clusterRadius;
+		float z = (Random01() + Random01() - 1.f) * clusterRadius;
+		float height = Random01() * clusterRadius * 0.5f;
+
+		return center + glm::vec3(x, y + height, z);
+	}
+
+	case STRESS_LAYOUT::MAX:
+		break;
+	}
+
+	return glm::vec3(0.f, y, 0.f);
+}
+
+
+float StressScene::Random01()
+{
+	//From the raw generator output, the standard distributions differ between libraries. 24 bits fit a float exactly
+	return (random() >> 8) / 16777216.f;
+}
+
+
+const char* GetStressLayoutName(STRESS_LAYOUT layout)
+{
+	switch (layout)
+	{
+	case STRESS_LAYOUT::GRID: return "Grid";
+	case STRESS_LAYOUT::RANDOM: return "Random";
+	case STRESS_LAYOUT::CLUSTERED: return "Clustered";
+	case STRESS_LAYOUT::MAX: break;
+	}
+
+	return "Unknown";
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "platform.h"
+#include "ModelStructures.h"
+#include "Light.h"
+#include "TransformStore.h"
+
+#include <random>
+#include <unordered_map>
+
+#define STRESS_SCENE_MAX_MODELS 5
+#define STRESS_SCENE_MAX_MATERIALS 64
+
+struct App;
+
+enum class STRESS_LAYOUT : int
+{
+	GRID = 0,
+	RANDOM,
+	CLUSTERED,		//Dense groups, the case the occlusion culling is meant for
+	MAX
+};
+
+
+struct StressSceneSettings
+{
+	u32 entityCount = 1000;
+	u32 modelCount = 4;			//Up to STRESS_SCENE_MAX_MODELS
+	u32 materialCount = 8;		//Up to STRESS_SCENE_MAX_MATERIALS
+	u32 lightCount = 16;			//Up to GLOBAL_PARAMS_MAX_LIGHTS
+	STRESS_LAYOUT layout = STRESS_LAYOUT::GRID;
+	u32 seed = 1;
+
+	float spacing = 3.f;		//Between entities of the grid, the other layouts cover the same area
+	float entitySize = 1.f;		//Largest side of every entity
+	u32 clusterCount = 8;
+};
+
+
+//Replaces the scene with generated entities and lights to see how the engine scales. The same settings
+//always give the same scene. The entities use the default shapes and Patrick, with flat colour materials,
+//and every model and material pair is a model that shares the mesh. Those are kept between generations,
+//so regenerating doesn't grow the model and material lists.
+class StressScene
+{
+public:
+	void Generate(App* app);
+
+	//Puts back the scene there was before the first generation
+	void Restore(App* app);
+
+	bool IsActive() const;
+
+	//Half the side of the area covered by the entities
+	float GetExtent() const;
+
+private:
+	u32 GetModel(App* app, u32 poolIdx, u32 materialIdx);
+	u32 GetMaterial(App* app, u32 materialIdx);
+
+	glm::vec3 GetPosition(u32 idx, float y);
+	float Random01();
+
+public:
+	StressSceneSettings settings;
+
+	u32 generatedEntities = 0;
+	u32 generatedLights = 0;
+
+private:
+	bool active = false;
+	std::vector<Entity> savedEntities;
+	TransformStore savedTransforms;
+	std::vector<Light> savedLights;
+
+	u32 poolModels[STRESS_SCENE_MAX_MODELS];
+	bool poolLoaded = false;
+
+	std::vector<u32> materials;
+	std::unordered_map<u32, u32> variants;		//Pool model and material to the model that pairs them
+
+	std::mt19937 random;
+	float extent = 0.f;
+	std::vector<glm::vec3> clusterCenters;
+	float clusterRadius = 0.f;
+};
+
+
+const char* GetStressLayoutName(STRESS_LAYOUT layout);
@@ -0,0 +1,169 @@
+#include "TemporalAA.h"
+
+#include "engine.h"
+#include "GpuProfiler.h"
+#include "RenderTargetPool.h"
+#include "DynamicResolution.h"
+
+TemporalAA::TemporalAA(App* app)
+{
+	programIdx = CreateComputeProgram(app, "TemporalResolve.glsl", "TEMPORAL_RESOLVE");
+
+	InitHistory(app->displaySize.x, app->displaySize.y);
+}
+
+
+TemporalAA::~TemporalAA()
+{
+	GetRenderTargetPool().Release(history[0]);
+	GetRenderTargetPool().Release(history[1]);
+}
+
+
+void TemporalAA::Resize(int sizeX, int sizeY)
+{
+	InitHistory(sizeX, sizeY);
+}
+
+
+bool TemporalAA::IsActive(const App* app) const
+{
+	return enabled == true && app->mode == Mode_Deferred;
+}
+
+
+void TemporalAA::Update(App* app)
+{
+	prevViewProjection = viewProjection;
+	viewProjection = app->camera.GetUnjitteredProjectionMatrix() * app->camera.GetViewMatrix();
+
+	if (IsActive(app) == false)
+	{
+		app->camera.SetJitter(glm::vec2(0.f));
+		jitterPixels = glm::vec2(0.f);
+
+		wasActive = false;
+		return;
+	}
+
+	//The history is from a different mode or doesn't exist yet. The render graph culls the resolve when
+	//nothing shows it (debug views), then the history stopped following the camera
+	if (wasActive == false || resolvedLastFrame == false)
+		historyValid = false;
+
+	wasActive = true;
+	resolvedLastFrame = false;
+
+	//Every output pixel needs about the same number of samples, so upscaling needs a longer sequence
+	glm::ivec2 renderSize = app->dynamicResolution->GetRenderSize(app->displaySize);
+	float scale = glm::max((float)renderSize.x / glm::max(app->displaySize.x, 1), 0.01f);
+
+	jitterPhases = glm::clamp((int)ceil(baseJitterPhases / (scale * scale)), 1, TAA_MAX_JITTER_PHASES);
+
+	//Halton starts at 1, index 0 would always be the same corner
+	int phase = (frameIdx % jitterPhases) + 1;
+	frameIdx++;
+
+	jitterPixels = glm::vec2(Halton(phase, 2) - 0.5f, Halton(phase, 3) - 0.5f);
+
+	app->camera.SetJitter(jitterPixels * 2.f / glm::vec2(renderSize));
+}
+
+
+void TemporalAA::Resolve(App* app)
+{
+	if (IsActive(app) == false)
+		return;
+
+	GPU_PROFILE_SCOPE(app, "TemporalResolve");
+
+	Program& program = app->programs[programIdx];
+	glUseProgram(program.handle);
+
+	u32 prevHistory = history[1 - currentHistory];
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[3].handle);
+	glUniform1i(glGetUniformLocation(program.handle, "colorMap"), 0);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[6].handle);
+	glUniform1i(glGetUniformLocation(program.handle, "velocityMap"), 1);
+
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[5].handle);
+	glUniform1i(glGetUniformLocation(program.handle, "depthMap"), 2);
+
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, prevHistory);
+	glUniform1i(glGetUniformLocation(program.handle, "historyMap"), 3);
+
+	glUniform2i(glGetUniformLocation(program.handle, "uRenderSize"), app->renderSize.x, app->renderSize.y);
+	glUniform2i(glGetUniformLocation(program.handle, "uOutputSize"), historySize.x, historySize.y);
+	glUniform2fv(glGetUniformLocation(program.handle, "uJitter"), 1, glm::value_ptr(jitterPixels));
+	glUniform1f(glGetUniformLocation(program.handle, "uBlendFactor"), blendFactor);
+	glUniform1f(glGetUniformLocation(program.handle, "uVarianceClip"), varianceClip);
+	glUniform1i(glGetUniformLocation(program.handle, "uHistoryValid"), historyValid ? 1 : 0);
+
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	glUniformMatrix4fv(glGetUniformLocation(program.handle, "uInverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glUniformMatrix4fv(glGetUniformLocation(program.handle, "uPrevViewProjection"), 1, GL_FALSE, glm::value_ptr(prevViewProjection));
+
+	glBindImageTexture(0, history[currentHistory], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+	glDispatchCompute((historySize.x + TAA_GROUP_SIZE - 1) / TAA_GROUP_SIZE, (historySize.y + TAA_GROUP_SIZE - 1) / TAA_GROUP_SIZE, 1);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+	for (int i = 3; i >= 0; --i)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	glUseProgram(0);
+
+	//The texture just written is the output and the history of the next frame
+	historyValid = true;
+	resolvedLastFrame = true;
+	currentHistory = 1 - currentHistory;
+}
+
+
+u32 TemporalAA::GetOutputTexture() const
+{
+	return history[1 - currentHistory];
+}
+
+
+void TemporalAA::InitHistory(int sizeX, int sizeY)
+{
+	//Back to the pool, resizing back to a previous size takes them again
+	GetRenderTargetPool().Release(history[0]);
+	GetRenderTargetPool().Release(history[1]);
+
+	historySize = glm::max(glm::ivec2(sizeX, sizeY), glm::ivec2(1));
+
+	RenderTargetDesc desc = { historySize.x, historySize.y, GL_RGBA16F };
+	history[0] = GetRenderTargetPool().Acquire(desc, "Temporal history");
+	history[1] = GetRenderTargetPool().Acquire(desc, "Temporal history");
+
+	historyValid = false;
+}
+
+
+float TemporalAA::Halton(int index, int base) const
+{
+	float result = 0.f;
+	float fraction = 1.f;
+
+	while (index > 0)
+	{
+		fraction /= base;
+		result += fraction * (index % base);
+		index /= base;
+	}
+
+	return result;
+}
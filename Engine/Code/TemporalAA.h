@@ -0,0 +1,65 @@
+#pragma once
+
+#include "platform.h"
+
+#define TAA_GROUP_SIZE 8
+#define TAA_MAX_JITTER_PHASES 64
+
+struct App;
+
+//Temporal anti aliasing and upscaling:
+// - The projection is jittered every frame with a Halton sequence.
+// - The geometry pass writes the screen motion of every pixel into the velocity attachment.
+// - A resolve pass reprojects the history, clamps it to the neighborhood of the current frame and
+//   accumulates the new samples at the window resolution, so the scene can be rendered at a lower scale.
+struct TemporalAA
+{
+public:
+	TemporalAA(App* app);
+	~TemporalAA();
+
+	void Resize(int sizeX, int sizeY);
+
+	//Only runs in deferred mode
+	bool IsActive(const App* app) const;
+
+	//Picks the jitter of this frame, must run before the matrices are uploaded
+	void Update(App* app);
+
+	//Needs the light and bloom passes done, the result is at window resolution
+	void Resolve(App* app);
+
+	u32 GetOutputTexture() const;
+
+private:
+	void InitHistory(int sizeX, int sizeY);
+
+	float Halton(int index, int base) const;
+
+public:
+	bool enabled = false;
+
+	float blendFactor = 0.1f;		//Weight of the current frame
+	float varianceClip = 1.25f;		//Size of the clamping box in standard deviations
+	int baseJitterPhases = 8;		//Phases at native resolution, more are used when upscaling
+
+	//Matrices without jitter, the previous ones are used to find the motion of the camera
+	glm::mat4 viewProjection = glm::mat4(1.f);
+	glm::mat4 prevViewProjection = glm::mat4(1.f);
+
+	glm::vec2 jitterPixels = glm::vec2(0.f);
+	int jitterPhases = 0;
+
+private:
+	u32 programIdx;
+
+	u32 history[2] = {};
+	glm::ivec2 historySize;
+	u32 currentHistory = 0;
+
+	bool historyValid = false;
+	bool wasActive = false;
+	bool resolvedLastFrame = false;
+
+	u32 frameIdx = 0;
+};
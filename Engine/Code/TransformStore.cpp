@@ -0,0 +1,242 @@
+#include "TransformStore.h"
+
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+
+#include <glm/gtx/euler_angles.hpp>
+#include <xmmintrin.h>
+
+TransformStore::TransformStore()
+{
+}
+
+
+u32 TransformStore::Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	positions.push_back(position);
+	rotations.push_back(rotation);
+	scales.push_back(scale);
+
+	//Built right away, with no motion for the first frame
+	glm::mat4 world = ComposeTransform(position, rotation, scale);
+	worldMatrices.push_back(world);
+	prevWorldMatrices.push_back(world);
+
+	dirty.push_back(0);
+
+	return positions.size() - 1;
+}
+
+
+void TransformStore::Remove(u32 idx)
+{
+	positions.erase(positions.begin() + idx);
+	rotations.erase(rotations.begin() + idx);
+	scales.erase(scales.begin() + idx);
+	worldMatrices.erase(worldMatrices.begin() + idx);
+	prevWorldMatrices.erase(prevWorldMatrices.begin() + idx);
+	dirty.erase(dirty.begin() + idx);
+
+	//The ones after it moved down
+	std::vector<u32>* lists[] = { &dirtyList, &movedList };
+	for (std::vector<u32>* list : lists)
+	{
+		for (int i = (int)list->size() - 1; i >= 0; --i)
+		{
+			if ((*list)[i] == idx)
+				list->erase(list->begin() + i);
+			else if ((*list)[i] > idx)
+				(*list)[i]--;
+		}
+	}
+}
+
+
+void TransformStore::Clear()
+{
+	positions.clear();
+	rotations.clear();
+	scales.clear();
+	worldMatrices.clear();
+	prevWorldMatrices.clear();
+	dirty.clear();
+
+	dirtyList.clear();
+	movedList.clear();
+}
+
+
+void TransformStore::Reserve(u32 count)
+{
+	positions.reserve(count);
+	rotations.reserve(count);
+	scales.reserve(count);
+	worldMatrices.reserve(count);
+	prevWorldMatrices.reserve(count);
+	dirty.reserve(count);
+}
+
+
+u32 TransformStore::GetCount() const
+{
+	return positions.size();
+}
+
+
+void TransformStore::SetPosition(u32 idx, const glm::vec3& position)
+{
+	positions[idx] = position;
+	MarkDirty(idx);
+}
+
+
+void TransformStore::SetRotation(u32 idx, const glm::quat& rotation)
+{
+	rotations[idx] = rotation;
+	MarkDirty(idx);
+}
+
+
+void TransformStore::SetScale(u32 idx, const glm::vec3& scale)
+{
+	scales[idx] = scale;
+	MarkDirty(idx);
+}
+
+
+const glm::vec3& TransformStore::GetPosition(u32 idx) const
+{
+	return positions[idx];
+}
+
+
+const glm::quat& TransformStore::GetRotation(u32 idx) const
+{
+	return rotations[idx];
+}
+
+
+const glm::vec3& TransformStore::GetScale(u32 idx) const
+{
+	return scales[idx];
+}
+
+
+const glm::mat4& TransformStore::GetWorld(u32 idx) const
+{
+	return worldMatrices[idx];
+}
+
+
+const glm::mat4& TransformStore::GetPrevWorld(u32 idx) const
+{
+	return prevWorldMatrices[idx];
+}
+
+
+void TransformStore::MarkAllDirty()
+{
+	for (u32 i = 0; i < positions.size(); ++i)
+		MarkDirty(i);
+}
+
+
+void TransformStore::Update()
+{
+	CPU_PROFILE_FUNCTION();
+
+	//Still holding the matrix from before their last change
+	for (u32 i = 0; i < movedList.size(); ++i)
+	{
+		u32 idx = movedList[i];
+		if (dirty[idx] == 0)
+			prevWorldMatrices[idx] = worldMatrices[idx];
+	}
+
+	//Every job only writes the transforms of its items
+	GetJobSystem().ParallelFor("UpdateTransforms", dirtyList.size(), TRANSFORMS_PER_JOB, [this](u32 i, u32 /*threadIdx*/)
+		{
+			u32 idx = dirtyList[i];
+
+			prevWorldMatrices[idx] = worldMatrices[idx];
+			worldMatrices[idx] = ComposeTransform(positions[idx], rotations[idx], scales[idx]);
+
+			dirty[idx] = 0;
+		});
+
+	updatedCount = dirtyList.size();
+
+	movedList.swap(dirtyList);
+	dirtyList.clear();
+}
+
+
+u32 TransformStore::GetUpdatedCount() const
+{
+	return updatedCount;
+}
+
+
+void TransformStore::MarkDirty(u32 idx)
+{
+	if (dirty[idx] != 0)
+		return;
+
+	dirty[idx] = 1;
+	dirtyList.push_back(idx);
+}
+
+
+glm::mat4 ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	glm::mat3 rotationMatrix = glm::mat3_cast(rotation);
+
+	glm::mat4 transform;
+	transform[0] = glm::vec4(rotationMatrix[0] * scale.x, 0.f);
+	transform[1] = glm::vec4(rotationMatrix[1] * scale.y, 0.f);
+	transform[2] = glm::vec4(rotationMatrix[2] * scale.z, 0.f);
+	transform[3] = glm::vec4(position, 1.f);
+
+	return transform;
+}
+
+
+glm::quat EulerToRotation(const glm::vec3& euler)
+{
+	return glm::angleAxis(euler.x, glm::vec3(1.f, 0.f, 0.f)) * glm::angleAxis(euler.y, glm::vec3(0.f, 1.f, 0.f)) * glm::angleAxis(euler.z, glm::vec3(0.f, 0.f, 1.f));
+}
+
+
+glm::vec3 RotationToEuler(const glm::quat& rotation)
+{
+	glm::vec3 euler;
+	glm::extractEulerAngleXYZ(glm::mat4_cast(rotation), euler.x, euler.y, euler.z);
+
+	return euler;
+}
+
+
+void MultiplyMatrix(const glm::mat4& left, const glm::mat4& right, glm::mat4& result)
+{
+	const float* a = glm::value_ptr(left);
+	const float* b = glm::value_ptr(right);
+
+	__m128 leftColumns[4] = { _mm_loadu_ps(a), _mm_loadu_ps(a + 4), _mm_loadu_ps(a + 8), _mm_loadu_ps(a + 12) };
+
+	//Column i of the result is the columns of left weighted by column i of right
+	__m128 columns[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		__m128 column = _mm_mul_ps(leftColumns[0], _mm_set1_ps(b[i * 4]));
+		column = _mm_add_ps(column, _mm_mul_ps(leftColumns[1], _mm_set1_ps(b[i * 4 + 1])));
+		column = _mm_add_ps(column, _mm_mul_ps(leftColumns[2], _mm_set1_ps(b[i * 4 + 2])));
+		column = _mm_add_ps(column, _mm_mul_ps(leftColumns[3], _mm_set1_ps(b[i * 4 + 3])));
+
+		columns[i] = column;
+	}
+
+	//Stored after every column is computed, result can be one of the inputs
+	float* r = glm::value_ptr(result);
+	for (int i = 0; i < 4; ++i)
+		_mm_storeu_ps(r + i * 4, columns[i]);
+}
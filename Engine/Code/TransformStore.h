@@ -0,0 +1,72 @@
+#pragma once
+
+#include "platform.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#define TRANSFORMS_PER_JOB 1024
+
+//Transforms of the entities, an array per component so the per frame updates walk memory in order and only load
+//what they use. A transform has the index of its entity: AddEntity(), RemoveEntity() and ClearEntities() keep both
+//in step. The world matrix is only rebuilt when the transform changed, the one of the last frame is kept for the velocity.
+class TransformStore
+{
+public:
+	TransformStore();
+
+	u32 Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	void Remove(u32 idx);
+	void Clear();
+	void Reserve(u32 count);
+
+	u32 GetCount() const;
+
+	void SetPosition(u32 idx, const glm::vec3& position);
+	void SetRotation(u32 idx, const glm::quat& rotation);
+	void SetScale(u32 idx, const glm::vec3& scale);
+
+	const glm::vec3& GetPosition(u32 idx) const;
+	const glm::quat& GetRotation(u32 idx) const;
+	const glm::vec3& GetScale(u32 idx) const;
+
+	const glm::mat4& GetWorld(u32 idx) const;
+	const glm::mat4& GetPrevWorld(u32 idx) const;
+
+	//Every transform is rebuilt by the next update, for the benchmarks
+	void MarkAllDirty();
+
+	//Once per frame before the matrices are read. The dirty transforms are rebuilt on the job system, and the ones
+	//that changed last frame and not in this one take their world matrix as the previous one
+	void Update();
+
+	//Rebuilt by the last update
+	u32 GetUpdatedCount() const;
+
+private:
+	void MarkDirty(u32 idx);
+
+private:
+	std::vector<glm::vec3> positions;
+	std::vector<glm::quat> rotations;
+	std::vector<glm::vec3> scales;
+
+	std::vector<glm::mat4> worldMatrices;
+	std::vector<glm::mat4> prevWorldMatrices;
+
+	std::vector<u8> dirty;
+	std::vector<u32> dirtyList;		//Changed since the last update
+	std::vector<u32> movedList;		//Changed before the last update, their previous matrix is still older
+
+	u32 updatedCount = 0;
+};
+
+
+//Translation * rotation * scale, without trigonometry
+glm::mat4 ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+//Rotated around x, then y, then z, the order the entities used with euler angles
+glm::quat EulerToRotation(const glm::vec3& euler);
+glm::vec3 RotationToEuler(const glm::quat& rotation);
+
+//left * right with SSE, a column of the result at a time. The matrices don't need to be aligned
+void MultiplyMatrix(const glm::mat4& left, const glm::mat4& right, glm::mat4& result);
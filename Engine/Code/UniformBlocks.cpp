@@ -0,0 +1,44 @@
+#include "UniformBlocks.h"
+
+static const ShaderMemberLayout globalParamsMembers[] = {
+	{ "uCameraPosition", offsetof(GlobalParams, cameraPosition) },
+	{ "uLightCount", offsetof(GlobalParams, lightCount) },
+	{ "uAmbientLightStrength", offsetof(GlobalParams, ambientLightStrength) },
+	{ "uAmbientLightCol", offsetof(GlobalParams, ambientLightColor) },
+	{ "uLight[0].type", offsetof(GlobalParams, lights) + offsetof(LightParams, type) },
+	{ "uLight[0].maxDistance", offsetof(GlobalParams, lights) + offsetof(LightParams, maxDistance) },
+	{ "uLight[0].color", offsetof(GlobalParams, lights) + offsetof(LightParams, color) },
+	{ "uLight[0].direction", offsetof(GlobalParams, lights) + offsetof(LightParams, direction) },
+	{ "uLight[0].position", offsetof(GlobalParams, lights) + offsetof(LightParams, position) },
+	{ "uLight[1].type", offsetof(GlobalParams, lights) + sizeof(LightParams) }
+};
+
+static const ShaderMemberLayout localParamsMembers[] = {
+	{ "uWorldMatrix", offsetof(LocalParams, worldMatrix) },
+	{ "uWorldProjectionMatrix", offsetof(LocalParams, worldProjectionMatrix) },
+	{ "uCurrentWorldProjectionMatrix", offsetof(LocalParams, currentWorldProjectionMatrix) },
+	{ "uPrevWorldProjectionMatrix", offsetof(LocalParams, prevWorldProjectionMatrix) }
+};
+
+static const ShaderMemberLayout materialParamsMembers[] = {
+	{ "albedo", offsetof(MaterialParams, albedo) },
+	{ "emissive", offsetof(MaterialParams, emissive) },
+	{ "reflectivity", offsetof(MaterialParams, reflectivity) }
+};
+
+static const ShaderMemberLayout bloomParamsMembers[] = {
+	{ "uThreshold", offsetof(BloomParams, threshold) },
+	{ "uKnee", offsetof(BloomParams, knee) },
+	{ "uIntensity", offsetof(BloomParams, intensity) },
+	{ "uLevelIntensity[0]", offsetof(BloomParams, levelIntensity) },
+	{ "uLevelIntensity[1]", offsetof(BloomParams, levelIntensity) + sizeof(glm::vec4) }
+};
+
+const ShaderBlockLayout uniformBlockLayouts[] = {
+	{ "GlobalParams", sizeof(GlobalParams), globalParamsMembers, ARRAY_COUNT(globalParamsMembers) },
+	{ "LocalParams", sizeof(LocalParams), localParamsMembers, ARRAY_COUNT(localParamsMembers) },
+	{ "MaterialParams", sizeof(MaterialParams), materialParamsMembers, ARRAY_COUNT(materialParamsMembers) },
+	{ "BloomParams", sizeof(BloomParams), bloomParamsMembers, ARRAY_COUNT(bloomParamsMembers) }
+};
+
+const u32 uniformBlockLayoutCount = ARRAY_COUNT(uniformBlockLayouts);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ShaderLayout.h"
+
+#define GLOBAL_PARAMS_MAX_LIGHTS 16	//Must match Lighting.glsl
+#define BLOOM_MIP_COUNT 6			//Must match the bloom shaders
+
+//Cpu side of the uniform blocks, every offset is checked against the std140 rules at compile time
+//and against the driver reflection once a program that uses the block links.
+
+//Lighting.glsl
+struct alignas(16) LightParams
+{
+	SHADER_MEMBER(u32, type);
+	SHADER_MEMBER(float, maxDistance);
+	SHADER_MEMBER(glm::vec3, color);
+	SHADER_MEMBER(glm::vec3, direction);
+	SHADER_MEMBER(glm::vec3, position);
+};
+
+SHADER_ASSERT_OFFSET(LightParams, color, 16);
+SHADER_ASSERT_OFFSET(LightParams, direction, 32);
+SHADER_ASSERT_OFFSET(LightParams, position, 48);
+SHADER_ASSERT_SIZE(LightParams, 64);
+
+
+//Lighting.glsl
+struct GlobalParams
+{
+	SHADER_MEMBER(glm::vec3, cameraPosition);
+	SHADER_MEMBER(u32, lightCount);
+
+	SHADER_MEMBER(float, ambientLightStrength);
+	SHADER_MEMBER(glm::vec3, ambientLightColor);
+
+	LightParams lights[GLOBAL_PARAMS_MAX_LIGHTS];
+};
+
+SHADER_ASSERT_OFFSET(GlobalParams, lightCount, 12);
+SHADER_ASSERT_OFFSET(GlobalParams, ambientLightStrength, 16);
+SHADER_ASSERT_OFFSET(GlobalParams, ambientLightColor, 32);
+SHADER_ASSERT_OFFSET(GlobalParams, lights, 48);
+SHADER_ASSERT_SIZE(GlobalParams, 48 + 64 * GLOBAL_PARAMS_MAX_LIGHTS);
+
+
+//shaders.glsl, ForwardRendering.glsl only declares the first two
+struct LocalParams
+{
+	SHADER_MEMBER(glm::mat4, worldMatrix);
+	SHADER_MEMBER(glm::mat4, worldProjectionMatrix);
+
+	//Without jitter, for the velocity
+	SHADER_MEMBER(glm::mat4, currentWorldProjectionMatrix);
+	SHADER_MEMBER(glm::mat4, prevWorldProjectionMatrix);
+};
+
+SHADER_ASSERT_OFFSET(LocalParams, worldProjectionMatrix, 64);
+SHADER_ASSERT_OFFSET(LocalParams, currentWorldProjectionMatrix, 128);
+SHADER_ASSERT_OFFSET(LocalParams, prevWorldProjectionMatrix, 192);
+SHADER_ASSERT_SIZE(LocalParams, 256);
+
+
+//shaders.glsl and ForwardRendering.glsl
+struct MaterialParams
+{
+	SHADER_MEMBER(glm::vec3, albedo);
+	SHADER_MEMBER(glm::vec3, emissive);
+	SHADER_MEMBER(float, reflectivity);
+};
+
+SHADER_ASSERT_OFFSET(MaterialParams, emissive, 16);
+SHADER_ASSERT_OFFSET(MaterialParams, reflectivity, 28);
+SHADER_ASSERT_SIZE(MaterialParams, 32);
+
+
+//BloomDownsample.glsl, BloomUpsample.glsl and Composite.glsl
+struct BloomParams
+{
+	SHADER_MEMBER(float, threshold);
+	SHADER_MEMBER(float, knee);
+	SHADER_MEMBER(float, intensity);
+
+	Std140Array<float, BLOOM_MIP_COUNT> levelIntensity;	//vec4 on the shaders, only x is used
+};
+
+SHADER_ASSERT_OFFSET(BloomParams, knee, 4);
+SHADER_ASSERT_OFFSET(BloomParams, intensity, 8);
+SHADER_ASSERT_OFFSET(BloomParams, levelIntensity, 16);
+SHADER_ASSERT_SIZE(BloomParams, 16 + 16 * BLOOM_MIP_COUNT);
+
+
+//Layouts of every block above, for ValidateUniformBlocks()
+extern const ShaderBlockLayout uniformBlockLayouts[];
+extern const u32 uniformBlockLayoutCount;
@@ -1,20 +1,32 @@
 
 #include "assimp_model_loading.h"
+#include "CpuProfiler.h"
+#include "GpuMemory.h"
 
 #include <assimp/cimport.h>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "ModelStructures.h"
+#include "FileWatcher.h"
 
 
 void ProcessAssimpMesh(const aiScene* scene, aiMesh *mesh, Mesh *myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices)
 {
+    bool hasTexCoords = mesh->mTextureCoords[0] != nullptr;
+    bool hasTangentSpace = mesh->mTangents != nullptr && mesh->mBitangents != nullptr;
+
+    u32 indexCount = 0;
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+        indexCount += mesh->mFaces[i].mNumIndices;
+
+    // the arrays end up in the submesh, so they are sized once instead of growing vertex by vertex
+    u32 floatsPerVertex = 6 + (hasTexCoords ? 2 : 0) + (hasTangentSpace ? 6 : 0);
+
     std::vector<float> vertices;
     std::vector<u32> indices;
-
-    bool hasTexCoords = false;
-    bool hasTangentSpace = false;
+    vertices.reserve(mesh->mNumVertices * floatsPerVertex);
+    indices.reserve(indexCount);
 
     // process vertices
     for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -26,16 +38,14 @@ void ProcessAssimpMesh(const aiScene* scene, aiMesh *mesh, Mesh *myMesh, u32 bas
         vertices.push_back(mesh->mNormals[i].y);
         vertices.push_back(mesh->mNormals[i].z);
 
-        if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
+        if(hasTexCoords) // does the mesh contain texture coordinates?
         {
-            hasTexCoords = true;
             vertices.push_back(mesh->mTextureCoords[0][i].x);
             vertices.push_back(mesh->mTextureCoords[0][i].y);
         }
 
-        if(mesh->mTangents != nullptr && mesh->mBitangents)
+        if(hasTangentSpace)
         {
-            hasTangentSpace = true;
             vertices.push_back(mesh->mTangents[i].x);
             vertices.push_back(mesh->mTangents[i].y);
             vertices.push_back(mesh->mTangents[i].z);
@@ -57,7 +67,7 @@ void ProcessAssimpMesh(const aiScene* scene, aiMesh *mesh, Mesh *myMesh, u32 bas
     // process indices
     for(unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
-        aiFace face = mesh->mFaces[i];
+        const aiFace& face = mesh->mFaces[i];
         for(unsigned int j = 0; j < face.mNumIndices; j++)
         {
             indices.push_back(face.mIndices[j]);
@@ -169,8 +179,54 @@ void ProcessAssimpNode(const aiScene* scene, aiNode *node, Mesh *myMesh, u32 bas
     }
 }
 
-u32 LoadModel(App* app, const char* filename, bool createEntity)
+void UploadMesh(Mesh& mesh, const char* owner)
+{
+    u32 vertexBufferSize = 0;
+    u32 indexBufferSize = 0;
+
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        vertexBufferSize += mesh.submeshes[i].vertices.size() * sizeof(float);
+        indexBufferSize  += mesh.submeshes[i].indices.size()  * sizeof(u32);
+    }
+
+    glGenBuffers(1, &mesh.vertexBufferHandle);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
+    glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &mesh.indexBufferHandle);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, NULL, GL_STATIC_DRAW);
+
+    GetGpuMemory().TrackBuffer(mesh.vertexBufferHandle, GPU_MEMORY_CATEGORY::MESH, owner, vertexBufferSize);
+    GetGpuMemory().TrackBuffer(mesh.indexBufferHandle, GPU_MEMORY_CATEGORY::MESH, owner, indexBufferSize);
+
+    u32 indicesOffset = 0;
+    u32 verticesOffset = 0;
+
+    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    {
+        const void* verticesData = mesh.submeshes[i].vertices.data();
+        const u32   verticesSize = mesh.submeshes[i].vertices.size() * sizeof(float);
+        glBufferSubData(GL_ARRAY_BUFFER, verticesOffset, verticesSize, verticesData);
+        mesh.submeshes[i].vertexOffset = verticesOffset;
+        verticesOffset += verticesSize;
+
+        const void* indicesData = mesh.submeshes[i].indices.data();
+        const u32   indicesSize = mesh.submeshes[i].indices.size() * sizeof(u32);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indicesOffset, indicesSize, indicesData);
+        mesh.submeshes[i].indexOffset = indicesOffset;
+        indicesOffset += indicesSize;
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+u32 LoadModel(App* app, const char* filename, bool createEntity, const glm::vec3& position, const glm::vec3& scale)
 {
+    CPU_PROFILE_FUNCTION();
+
     const aiScene* scene = aiImportFile(filename,
                                         aiProcess_Triangulate           |
                                         aiProcess_GenSmoothNormals      |
@@ -200,7 +256,7 @@ u32 LoadModel(App* app, const char* filename, bool createEntity)
     if (createEntity == true)
     {
         app->entityIdCount++;
-        app->entities.push_back(Entity(std::string(filename) + std::to_string(app->entityIdCount), modelIdx));
+        AddEntity(app, std::string(filename) + std::to_string(app->entityIdCount), modelIdx, position, glm::quat(1.f, 0.f, 0.f, 0.f), scale);
     }
 
 
@@ -208,6 +264,8 @@ u32 LoadModel(App* app, const char* filename, bool createEntity)
 
     // Create a list of materials
     u32 baseMeshMaterialIndex = (u32)app->materials.size();
+    model.baseMaterialIdx = baseMeshMaterialIndex;
+    model.materialCount = scene->mNumMaterials;
     for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
     {
         app->materials.push_back(Material{});
@@ -219,43 +277,76 @@ u32 LoadModel(App* app, const char* filename, bool createEntity)
 
     aiReleaseImport(scene);
 
-    u32 vertexBufferSize = 0;
-    u32 indexBufferSize = 0;
+    mesh.CalculateAABB();
+    UploadMesh(mesh, filename);
 
-    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    app->fileWatcher->Watch(filename);
+
+    return modelIdx;
+}
+
+u32 ReloadModel(App* app, u32 modelIdx)
+{
+    CPU_PROFILE_FUNCTION();
+
+    Model& model = app->models[modelIdx];
+
+    const aiScene* scene = aiImportFile(model.name.c_str(),
+                                        aiProcess_Triangulate           |
+                                        aiProcess_GenSmoothNormals      |
+                                        aiProcess_CalcTangentSpace      |
+                                        aiProcess_JoinIdenticalVertices |
+                                        aiProcess_PreTransformVertices  |
+                                        aiProcess_ImproveCacheLocality  |
+                                        aiProcess_OptimizeMeshes        |
+                                        aiProcess_SortByPType);
+
+    //Keep the old version if the file is broken or still being written
+    if (!scene)
     {
-        vertexBufferSize += mesh.submeshes[i].vertices.size() * sizeof(float);
-        indexBufferSize  += mesh.submeshes[i].indices.size()  * sizeof(u32);
+        ELOG("Error reloading mesh %s: %s", model.name.c_str(), aiGetErrorString());
+        return UINT32_MAX;
     }
 
-    glGenBuffers(1, &mesh.vertexBufferHandle);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBufferHandle);
-    glBufferData(GL_ARRAY_BUFFER, vertexBufferSize, NULL, GL_STATIC_DRAW);
+    String directory = GetDirectoryPart(MakeString(model.name.c_str()));
 
-    glGenBuffers(1, &mesh.indexBufferHandle);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, NULL, GL_STATIC_DRAW);
-
-    u32 indicesOffset = 0;
-    u32 verticesOffset = 0;
+    //Reuse the material slots if the file still has the same materials, so the edits done from the gui are lost but nothing leaks
+    if (scene->mNumMaterials != model.materialCount)
+    {
+        model.baseMaterialIdx = (u32)app->materials.size();
+        model.materialCount = scene->mNumMaterials;
+        app->materials.resize(app->materials.size() + scene->mNumMaterials);
+    }
 
-    for (u32 i = 0; i < mesh.submeshes.size(); ++i)
+    for (unsigned int i = 0; i < scene->mNumMaterials; ++i)
     {
-        const void* verticesData = mesh.submeshes[i].vertices.data();
-        const u32   verticesSize = mesh.submeshes[i].vertices.size() * sizeof(float);
-        glBufferSubData(GL_ARRAY_BUFFER, verticesOffset, verticesSize, verticesData);
-        mesh.submeshes[i].vertexOffset = verticesOffset;
-        verticesOffset += verticesSize;
+        Material& material = app->materials[model.baseMaterialIdx + i];
+        material = Material{};
+        ProcessAssimpMaterial(app, scene->mMaterials[i], material, directory);
+    }
 
-        const void* indicesData = mesh.submeshes[i].indices.data();
-        const u32   indicesSize = mesh.submeshes[i].indices.size() * sizeof(u32);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, indicesOffset, indicesSize, indicesData);
-        mesh.submeshes[i].indexOffset = indicesOffset;
-        indicesOffset += indicesSize;
+    Mesh mesh = {};
+    model.materialIdx.clear();
+    ProcessAssimpNode(scene, scene->mRootNode, &mesh, model.baseMaterialIdx, model.materialIdx);
+
+    aiReleaseImport(scene);
+
+    mesh.CalculateAABB();
+    UploadMesh(mesh, model.name.c_str());
+
+    Mesh& oldMesh = app->meshes[model.meshIdx];
+    GetGpuMemory().ReleaseBuffer(oldMesh.vertexBufferHandle);
+    GetGpuMemory().ReleaseBuffer(oldMesh.indexBufferHandle);
+    glDeleteBuffers(1, &oldMesh.vertexBufferHandle);
+    glDeleteBuffers(1, &oldMesh.indexBufferHandle);
+
+    for (u32 i = 0; i < oldMesh.submeshes.size(); ++i)
+    {
+        for (u32 j = 0; j < oldMesh.submeshes[i].vaos.size(); ++j)
+            glDeleteVertexArrays(1, &oldMesh.submeshes[i].vaos[j].handle);
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    oldMesh = mesh;
 
     return modelIdx;
 }
@@ -346,6 +437,7 @@ u32 LoadPlane(App* app)
     submesh.vertices.swap(vertices);
     submesh.indices.swap(indices);
     mesh.submeshes.push_back(submesh);
+    mesh.CalculateAABB();
 
     u32 vertexBufferSize = submesh.vertices.size() * sizeof(float);
     u32 indexBufferSize = submesh.indices.size() * sizeof(u32);    
@@ -358,6 +450,9 @@ u32 LoadPlane(App* app)
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBufferHandle);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBufferSize, NULL, GL_STATIC_DRAW);
 
+    GetGpuMemory().TrackBuffer(mesh.vertexBufferHandle, GPU_MEMORY_CATEGORY::MESH, "Plane", vertexBufferSize);
+    GetGpuMemory().TrackBuffer(mesh.indexBufferHandle, GPU_MEMORY_CATEGORY::MESH, "Plane", indexBufferSize);
+
     u32 indicesOffset = 0;
     u32 verticesOffset = 0;
     
@@ -14,6 +14,12 @@ void ProcessAssimpMaterial(App* app, aiMaterial* material, Material& myMaterial,
 
 void ProcessAssimpNode(const aiScene* scene, aiNode* node, Mesh* myMesh, u32 baseMeshMaterialIndex, std::vector<u32>& submeshMaterialIndices);
 
-u32 LoadModel(App* app, const char* filename, bool createEntity = false);
+void UploadMesh(Mesh& mesh, const char* owner);
+
+//The entity is created with its transform, so it doesn't move on its first frame
+u32 LoadModel(App* app, const char* filename, bool createEntity = false, const glm::vec3& position = glm::vec3(0.f), const glm::vec3& scale = glm::vec3(1.f));
+
+//Imports the file of the model again into its mesh, returns UINT32_MAX and keeps the old one if it fails
+u32 ReloadModel(App* app, u32 modelIdx);
 
 u32 LoadPlane(App* app);
\ No newline at end of file
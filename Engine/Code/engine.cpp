@@ -8,18 +8,36 @@
 #include "engine.h"
 #include "assimp_model_loading.h"
 #include "Environment.h"
+#include "OcclusionCulling.h"
+#include "SoftwareOcclusion.h"
+#include "LowResLighting.h"
+#include "DynamicResolution.h"
+#include "AutoExposure.h"
+#include "TemporalAA.h"
+#include "Composite.h"
+#include "ProgramCache.h"
+#include "ShaderCompiler.h"
+#include "FileWatcher.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderPermutations.h"
+#include "Arena.h"
+#include "GpuMemory.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "CameraPath.h"
+#include "StressScene.h"
+#include "FrameCapture.h"
+#include "JobSystem.h"
+#include "RenderGraph.h"
+#include "RenderTargetPool.h"
 
 #include <imgui.h>
 #include <stb_image.h>
 #include <stb_image_write.h>
+#include <algorithm>
 
-GLuint CreateProgramFromSource(String programSource, const char* shaderName)
+GLuint CreateProgramFromSource(App* app, u32 programIdx, String programSource, const char* shaderName, const char* defines)
 {
-	GLchar  infoLogBuffer[1024] = {};
-	GLsizei infoLogBufferSize = sizeof(infoLogBuffer);
-	GLsizei infoLogSize;
-	GLint   success;
-
 	char versionString[] = "#version 430\n";
 	char shaderNameDefine[128];
 	sprintf(shaderNameDefine, "#define %s\n", shaderName);
@@ -29,135 +47,140 @@ GLuint CreateProgramFromSource(String programSource, const char* shaderName)
 	const GLchar* vertexShaderSource[] = {
 		versionString,
 		shaderNameDefine,
+		defines,
 		vertexShaderDefine,
 		programSource.str
 	};
 	const GLint vertexShaderLengths[] = {
 		(GLint)strlen(versionString),
 		(GLint)strlen(shaderNameDefine),
+		(GLint)strlen(defines),
 		(GLint)strlen(vertexShaderDefine),
 		(GLint)programSource.len
 	};
 	const GLchar* fragmentShaderSource[] = {
 		versionString,
 		shaderNameDefine,
+		defines,
 		fragmentShaderDefine,
 		programSource.str
 	};
 	const GLint fragmentShaderLengths[] = {
 		(GLint)strlen(versionString),
 		(GLint)strlen(shaderNameDefine),
+		(GLint)strlen(defines),
 		(GLint)strlen(fragmentShaderDefine),
 		(GLint)programSource.len
 	};
 
-	GLuint vshader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vshader, ARRAY_COUNT(vertexShaderSource), vertexShaderSource, vertexShaderLengths);
-	glCompileShader(vshader);
-	glGetShaderiv(vshader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(vshader, infoLogBufferSize, &infoLogSize, infoLogBuffer);
-		ELOG("glCompileShader() failed with vertex shader %s\nReported message:\n%s\n", shaderName, infoLogBuffer);
-	}
+	const ShaderStageSource stages[] = {
+		{ GL_VERTEX_SHADER, vertexShaderSource, vertexShaderLengths, ARRAY_COUNT(vertexShaderSource) },
+		{ GL_FRAGMENT_SHADER, fragmentShaderSource, fragmentShaderLengths, ARRAY_COUNT(fragmentShaderSource) }
+	};
 
-	GLuint fshader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fshader, ARRAY_COUNT(fragmentShaderSource), fragmentShaderSource, fragmentShaderLengths);
-	glCompileShader(fshader);
-	glGetShaderiv(fshader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		glGetShaderInfoLog(fshader, infoLogBufferSize, &infoLogSize, infoLogBuffer);
-		ELOG("glCompileShader() failed with fragment shader %s\nReported message:\n%s\n", shaderName, infoLogBuffer);
-	}
+	//Every variant has its own cache file, only used while the sources and the driver don't change
+	std::string cacheIdentity = std::string(shaderNameDefine) + defines;
 
-	GLuint programHandle = glCreateProgram();
-	glAttachShader(programHandle, vshader);
-	glAttachShader(programHandle, fshader);
-	glLinkProgram(programHandle);
-	glGetProgramiv(programHandle, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		glGetProgramInfoLog(programHandle, infoLogBufferSize, &infoLogSize, infoLogBuffer);
-		ELOG("glLinkProgram() failed with program %s\nReported message:\n%s\n", shaderName, infoLogBuffer);
-	}
+	return app->shaderCompiler->Submit(app, programIdx, cacheIdentity.c_str(), stages, ARRAY_COUNT(stages));
+}
 
-	glUseProgram(0);
 
-	glDetachShader(programHandle, vshader);
-	glDetachShader(programHandle, fshader);
-	glDeleteShader(vshader);
-	glDeleteShader(fshader);
+GLuint CreateComputeProgramFromSource(App* app, u32 programIdx, String programSource, const char* shaderName)
+{
+	char versionString[] = "#version 430\n";
+	char shaderNameDefine[128];
+	sprintf_s(shaderNameDefine, 128, "#define %s\n", shaderName);
+	char computeShaderDefine[] = "#define COMPUTE\n";
+
+	const GLchar* computeShaderSource[] = {
+		versionString,
+		shaderNameDefine,
+		computeShaderDefine,
+		programSource.str
+	};
+	const GLint computeShaderLengths[] = {
+		(GLint)strlen(versionString),
+		(GLint)strlen(shaderNameDefine),
+		(GLint)strlen(computeShaderDefine),
+		(GLint)programSource.len
+	};
+
+	const ShaderStageSource stage = { GL_COMPUTE_SHADER, computeShaderSource, computeShaderLengths, ARRAY_COUNT(computeShaderSource) };
+
+	std::string cacheIdentity = std::string(shaderNameDefine) + computeShaderDefine;
 
-	return programHandle;
+	return app->shaderCompiler->Submit(app, programIdx, cacheIdentity.c_str(), &stage, 1);
 }
 
 
-u32 CreateProgram(App* app, const char* filepath, const char* programName)
+GLuint CompileProgram(App* app, u32 programIdx)
 {
-	u32 ret = LoadProgram(app, filepath, programName);
-	Program& program = app->programs[ret];
+	CPU_PROFILE_FUNCTION();
 
-	int attributeCount;
-	glGetProgramiv(program.handle, GL_ACTIVE_ATTRIBUTES, &attributeCount);
+	Program& program = app->programs[programIdx];
 
-	for (int i = 0; i < attributeCount; ++i)
-	{
-		char* name = new char[1000];
-		int length;
-		int size;
-		GLenum type;
+	std::string source;
+	PreprocessShader(program.filepath.c_str(), source, program.dependencies);
 
-		glGetActiveAttrib(program.handle, i, 1000, &length, &size, &type, name);
-		u8 attributeLocation = glGetAttribLocation(program.handle, name);
+	//Editing any of the included files reloads the program too
+	app->fileWatcher->Watch(program.filepath.c_str());
+	for (int i = 0; i < program.dependencies.size(); ++i)
+		app->fileWatcher->Watch(program.dependencies[i].c_str());
 
-		u8 attributeCount = 0;
-		switch (type)
-		{
-		case GL_FLOAT:
-			attributeCount = 1;
-			break;
+	String programSource = { (char*)source.c_str(), (u32)source.size() };
 
-		case GL_FLOAT_VEC2:
-			attributeCount = 2;
-			break;
+	if (program.isCompute == true)
+		return CreateComputeProgramFromSource(app, programIdx, programSource, program.programName.c_str());
 
-		case GL_FLOAT_VEC3:
-			attributeCount = 3;
-			break;
+	return CreateProgramFromSource(app, programIdx, programSource, program.programName.c_str(), program.defines.c_str());
+}
 
-		case GL_FLOAT_VEC4:
-			attributeCount = 4;
-			break;
-		default:
-			break;
-		}
 
-		program.layout.attributes.push_back(VertexShaderAttribute(attributeLocation, attributeCount));
-		delete[] name;
-	}
+u32 CreateComputeProgram(App* app, const char* filepath, const char* programName)
+{
+	Program program = {};
+	program.filepath = filepath;
+	program.programName = programName;
+	program.isCompute = true;
+	app->programs.push_back(program);
 
-	return ret;
+	u32 programIdx = app->programs.size() - 1;
+	app->programs[programIdx].handle = CompileProgram(app, programIdx);
+
+	return programIdx;
 }
 
 
-u32 LoadProgram(App* app, const char* filepath, const char* programName)
+u32 CreateProgram(App* app, const char* filepath, const char* programName, const char* defines)
 {
-	String programSource = ReadTextFile(filepath);
+	u32 ret = LoadProgram(app, filepath, programName, defines);
+
+	//The vertex layout is read once the program is linked
+	app->programs[ret].reflectAttributes = true;
+
+	return ret;
+}
 
+
+u32 LoadProgram(App* app, const char* filepath, const char* programName, const char* defines)
+{
 	Program program = {};
-	program.handle = CreateProgramFromSource(programSource, programName);
 	program.filepath = filepath;
 	program.programName = programName;
-	program.lastWriteTimestamp = GetFileLastWriteTimestamp(filepath);
+	program.defines = defines;
 	app->programs.push_back(program);
 
-	return app->programs.size() - 1;
+	u32 programIdx = app->programs.size() - 1;
+	app->programs[programIdx].handle = CompileProgram(app, programIdx);
+
+	return programIdx;
 }
 
 
 Image LoadImage(const char* filename)
 {
+	CPU_PROFILE_FUNCTION();
+
 	Image img = {};
 	stbi_set_flip_vertically_on_load(true);
 	img.pixels = stbi_load(filename, &img.size.x, &img.size.y, &img.nchannels, 0);
@@ -173,14 +196,34 @@ Image LoadImage(const char* filename)
 }
 
 
+Image LoadImageHdr(const char* filename)
+{
+	CPU_PROFILE_FUNCTION();
+
+	Image img = {};
+	stbi_set_flip_vertically_on_load(true);
+	img.pixels = stbi_loadf(filename, &img.size.x, &img.size.y, &img.nchannels, 0);
+	if (img.pixels)
+	{
+		img.stride = img.size.x * img.nchannels;
+	}
+	else
+	{
+		ELOG("Could not open file %s", filename);
+	}
+	return img;
+}
+
 void FreeImage(Image image)
 {
 	stbi_image_free(image.pixels);
 }
 
 
-u32 CreateTexture2DFromImage(Image image)
+u32 CreateTexture2DFromImage(Image image, const char* owner)
 {
+	CPU_PROFILE_FUNCTION();
+
 	GLenum internalFormat = GL_RGB8;
 	GLenum dataFormat = GL_RGB;
 	GLenum dataType = GL_UNSIGNED_BYTE;
@@ -204,6 +247,9 @@ u32 CreateTexture2DFromImage(Image image)
 	glGenerateMipmap(GL_TEXTURE_2D);
 	glBindTexture(GL_TEXTURE_2D, 0);
 
+	u32 mipCount = GpuMemoryTracker::GetMipCount(image.size.x, image.size.y);
+	GetGpuMemory().TrackTexture(texHandle, GPU_MEMORY_CATEGORY::TEXTURE, owner, internalFormat, image.size.x, image.size.y, 1, mipCount);
+
 	return texHandle;
 }
 
@@ -218,12 +264,14 @@ u32 LoadTexture2D(App* app, const char* filepath)
 	if (image.pixels)
 	{
 		Texture tex = {};
-		tex.handle = CreateTexture2DFromImage(image);
+		tex.handle = CreateTexture2DFromImage(image, filepath);
 		tex.filepath = filepath;
 
 		u32 texIdx = app->textures.size();
 		app->textures.push_back(tex);
 
+		app->fileWatcher->Watch(filepath);
+
 		FreeImage(image);
 		return texIdx;
 	}
@@ -233,11 +281,57 @@ u32 LoadTexture2D(App* app, const char* filepath)
 	}
 }
 
+u32 ReloadTexture2D(App* app, u32 texIdx)
+{
+	Texture& tex = app->textures[texIdx];
+	Image image = LoadImage(tex.filepath.c_str());
+
+	//Keep the old texture if the file can't be read yet
+	if (image.pixels == nullptr)
+		return UINT32_MAX;
+
+	GetGpuMemory().ReleaseTexture(tex.handle);
+	glDeleteTextures(1, &tex.handle);
+	tex.handle = CreateTexture2DFromImage(image, tex.filepath.c_str());
+
+	FreeImage(image);
+	return texIdx;
+}
+
+
+Entity& AddEntity(App* app, const std::string& name, u32 modelIdx, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	app->entities.push_back(Entity(name, modelIdx));
+	app->transforms.Add(position, rotation, scale);
+
+	return app->entities.back();
+}
+
+
+void RemoveEntity(App* app, u32 entityIdx)
+{
+	app->entities.erase(app->entities.begin() + entityIdx);
+	app->transforms.Remove(entityIdx);
+}
+
+
+void ClearEntities(App* app)
+{
+	app->entities.clear();
+	app->transforms.Clear();
+}
+
 
 //Init------------------------------------------------------------------
 void Init(App* app)
 {
+	CPU_PROFILE_FUNCTION();
+
 	GetAppInfo(app);
+	app->programCache = new ProgramCache(app->info);
+	app->fileWatcher = new FileWatcher();
+	app->shaderPermutations = new ShaderPermutations();
+	app->shaderCompiler = new ShaderCompiler(app->info);
 
 	InitRect(app);
 	InitPrograms(app);
@@ -255,6 +349,24 @@ void Init(App* app)
 	}
 	
 	app->skybox = new Environment(app, "neon_photostudio_4k.hdr");
+	app->occlusionCulling = new OcclusionCulling(app);
+	app->softwareOcclusion = new SoftwareOcclusion();
+	app->lowResLighting = new LowResLighting(app);
+	app->dynamicResolution = new DynamicResolution();
+	app->autoExposure = new AutoExposure(app);
+	app->temporalAA = new TemporalAA(app);
+	app->composite = new Composite(app);
+	app->gpuProfiler = new GpuProfiler();
+	app->cameraPath = new CameraPath();
+	app->stressScene = new StressScene();
+	app->frameCapture = new FrameCapture();
+	app->renderGraph = new RenderGraph();
+	app->renderSize = app->displaySize;
+
+	app->shaderPermutations->Prewarm(app, SHADER_VARIANT_MANIFEST);
+
+	//Everything has been compiling while the scene loaded, the vertex layouts are needed for the first frame
+	app->shaderCompiler->WaitAll(app);
 
 	app->mode = Mode_Deferred;
 }
@@ -292,6 +404,7 @@ void InitRect(App* app)
 	glGenBuffers(1, &app->embeddedVertices);
 	glBindBuffer(GL_ARRAY_BUFFER, app->embeddedVertices);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(rectVertices), rectVertices, GL_STATIC_DRAW);
+	GetGpuMemory().TrackBuffer(app->embeddedVertices, GPU_MEMORY_CATEGORY::MESH, "Screen rect", sizeof(rectVertices));
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -299,6 +412,7 @@ void InitRect(App* app)
 	glGenBuffers(1, &app->embeddedElements);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, app->embeddedElements);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(rectIndices), rectIndices, GL_STATIC_DRAW);
+	GetGpuMemory().TrackBuffer(app->embeddedElements, GPU_MEMORY_CATEGORY::MESH, "Screen rect", sizeof(rectIndices));
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
@@ -320,20 +434,14 @@ void InitRect(App* app)
 void InitPrograms(App* app)
 {
 	// - programs (and retrieve uniform indices)
-	app->screenRectProgramIdx = CreateProgram(app, "texturedQuad.glsl", "TEXTURED_QUAD");
-	app->albedoTexture = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "albedo");	//TODO ask what to do about these
-	app->normalsTexture = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "normals");
-	app->worldPositionTexture = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "worldPos");
-	app->defaultTexture = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "defaultTexture");
-	app->bloomTexure = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "bloom");
-	app->depthTexture = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "depth");
-	app->reflectivityTexture = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "reflectivity");
-	app->drawModeUniform = glGetUniformLocation(app->programs[app->screenRectProgramIdx].handle, "drawMode");
-
 	app->texturedGeometryProgramIdx = CreateProgram(app, "shaders.glsl", "TEXTURED_GEOMETRY");
 	app->geometryUniformTexture = glGetUniformLocation(app->programs[app->texturedGeometryProgramIdx].handle, "uTexture");
 
-	app->lightProgramIdx = CreateProgram(app, "lightPass.glsl", "LIGHT_PASS");
+	app->lightPassPermutationIdx = app->shaderPermutations->Register("lightPass.glsl", "LIGHT_PASS");
+	app->shaderPermutations->AddFeature(app->lightPassPermutationIdx, "LOW_RES_DIFFUSE", 0);
+	app->shaderPermutations->AddFeature(app->lightPassPermutationIdx, "LOW_RES_AMBIENT", 1);
+	app->shaderPermutations->AddFeature(app->lightPassPermutationIdx, "LOW_RES_REFLECTION", 2);
+	app->shaderPermutations->GetVariant(app, app->lightPassPermutationIdx, 0);
 
 	app->forwardRenderProgramIdx = CreateProgram(app, "ForwardRendering.glsl", "FORWARD_RENDER");
 }
@@ -352,19 +460,12 @@ void InitTextures(App* app)
 
 void InitScene(App* app)
 {
-	LoadModel(app, "Patrick/Patrick.obj", true);
-	if (app->entities.size() != 0)
-	{
-		app->entities[0].scale = glm::vec3(0.4f, 0.4f, 0.4f);
-		app->entities[0].position = glm::vec3(0.0f, 1.9f, 0.6f);
-	}
-
+	LoadModel(app, "Patrick/Patrick.obj", true, glm::vec3(0.0f, 1.9f, 0.6f), glm::vec3(0.4f, 0.4f, 0.4f));
 	LoadModel(app, "Room/Room.obj", true);
-	app->sphereModel = LoadModel(app, "DefaultShapes/Sphere.fbx", true);
+	app->sphereModel = LoadModel(app, "DefaultShapes/Sphere.fbx", true, glm::vec3(0.0f, 4.f, 0.0f));
 
 	if (app->entities.size() != 0)
 	{
-		app->entities[2].position = glm::vec3(0.0f, 4.f, 0.0f);
 		u32 modelIdx = app->entities[2].modelIdx;
 		u32 materialIdx = app->models[modelIdx].materialIdx[0];
 		app->materials[materialIdx].reflectivity = 0.8;
@@ -387,10 +488,11 @@ void InitUniformBuffers(App* app)
 	glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxUniformBufferSize);
 	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
 
-	app->localUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW);
-	app->debugLightUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW);
-	app->materialUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW);
-	app->globalUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW);
+	app->localUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW, "Local params");
+	app->debugLightUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW, "Debug light params");
+	app->materialUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW, "Material params");
+	app->globalUniformBuffer = CreateBuffer(maxUniformBufferSize, uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW, "Global params");
+	app->bloomUniformBuffer = CreateBuffer(sizeof(BloomParams), uniformAlignment, GL_UNIFORM_BUFFER, GL_STREAM_DRAW, "Bloom params");
 }
 
 
@@ -399,6 +501,8 @@ void InitUniformBuffers(App* app)
 void InitFramebuffer(App* app)
 {
 	//Generate framebuffer
+	app->framebuffer.owner = "GBuffer";
+
 	//Albedo
 	app->framebuffer.PushTexture(app->displaySize.x, app->displaySize.y, GL_RGBA16F, GL_RGBA, GL_FLOAT);
 
@@ -411,119 +515,32 @@ void InitFramebuffer(App* app)
 	//Default
 	app->framebuffer.PushTexture(app->displaySize.x, app->displaySize.y, GL_RGBA16F, GL_RGBA, GL_FLOAT);
 
-	//Bloom
-	app->framebuffer.PushTexture(app->displaySize.x, app->displaySize.y, GL_RGBA16F, GL_RGBA, GL_UNSIGNED_BYTE);
-
 	//Reflectivity
 	app->framebuffer.PushTexture(app->displaySize.x, app->displaySize.y, GL_R16F, GL_RED, GL_FLOAT);
 	
 	//Depth
 	app->framebuffer.PushTexture(app->displaySize.x, app->displaySize.y, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT);
 
+	//Velocity
+	app->framebuffer.PushTexture(app->displaySize.x, app->displaySize.y, GL_RG16F, GL_RG, GL_FLOAT);
+
 	app->framebuffer.AttachTextures();
 }
 
 
 void InitBloomResources(App* app)
 {
-	app->fboBloom1.ClearColorAttachments();
-	app->fboBloom2.ClearColorAttachments();
-	app->fboBloom3.ClearColorAttachments();
-	app->fboBloom4.ClearColorAttachments();
-	app->fboBloom5.ClearColorAttachments();
-
-	//Bright mipmap
-	if (app->rtBright != 0)
-		glDeleteTextures(1, &app->rtBright);
-
-	glGenTextures(1, &app->rtBright);
-	glBindTexture(GL_TEXTURE_2D, app->rtBright);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 4);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, app->displaySize.x / 2,  app->displaySize.y / 2,  0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, app->displaySize.x / 4,  app->displaySize.y / 4,  0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 2, GL_RGBA16F, app->displaySize.x / 8,  app->displaySize.y / 8,  0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 3, GL_RGBA16F, app->displaySize.x / 16, app->displaySize.y / 16, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 4, GL_RGBA16F, app->displaySize.x / 32, app->displaySize.y / 32, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	//Bloom mipmap
-	if (app->rtBloom != 0)
-		glDeleteTextures(1, &app->rtBloom);
-
-	glGenTextures(1, &app->rtBloom);
-	glBindTexture(GL_TEXTURE_2D, app->rtBloom);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 4);
-
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, app->displaySize.x / 2, app->displaySize.y / 2, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, app->displaySize.x / 4, app->displaySize.y / 4, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 2, GL_RGBA16F, app->displaySize.x / 8, app->displaySize.y / 8, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 3, GL_RGBA16F, app->displaySize.x / 16, app->displaySize.y / 16, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glTexImage2D(GL_TEXTURE_2D, 4, GL_RGBA16F, app->displaySize.x / 32, app->displaySize.y / 32, 0, GL_RGBA, GL_FLOAT, nullptr);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	//FBO 1
-	app->fboBloom1.Create();
-	app->fboBloom1.Bind();
-	app->fboBloom1.PushColorAttachment(0, app->rtBright, 0);
-	app->fboBloom1.PushColorAttachment(1, app->rtBloom, 0);
-	app->fboBloom1.Unbind();
-	app->fboBloom1.CheckStatus();
-
-
-	//FBO 2
-	app->fboBloom2.Create();
-	app->fboBloom2.Bind();
-	app->fboBloom2.PushColorAttachment(0, app->rtBright, 1);
-	app->fboBloom2.PushColorAttachment(1, app->rtBloom, 1);
-	app->fboBloom2.Unbind();
-	app->fboBloom2.CheckStatus();
-
-
-	//FBO 3
-	app->fboBloom3.Create();
-	app->fboBloom3.Bind();
-	app->fboBloom3.PushColorAttachment(0, app->rtBright, 2);
-	app->fboBloom3.PushColorAttachment(1, app->rtBloom, 2);
-	app->fboBloom3.Unbind();
-	app->fboBloom3.CheckStatus();
-
-	//FBO 4
-	app->fboBloom4.Create();
-	app->fboBloom4.Bind();
-	app->fboBloom4.PushColorAttachment(0, app->rtBright, 3);
-	app->fboBloom4.PushColorAttachment(1, app->rtBloom, 3);
-	app->fboBloom4.Unbind();
-	app->fboBloom4.CheckStatus();
-
-	//FBO 5
-	app->fboBloom5.Create();
-	app->fboBloom5.Bind();
-	app->fboBloom5.PushColorAttachment(0, app->rtBright, 4);
-	app->fboBloom5.PushColorAttachment(1, app->rtBloom, 4);
-	app->fboBloom5.Unbind();
-	app->fboBloom5.CheckStatus();
+	//Mip 0 is at half resolution, never smaller than a downsample tile so the whole chain exists.
+	//The chains themselves are transient targets of the render graph
+	app->bloomSize = glm::max(app->displaySize / 2, glm::ivec2(BLOOM_TILE_SIZE));
 }
 
 
 void InitBloomPrograms(App* app)
 {
-	app->brightPixelProgramIdx = CreateProgram(app, "BrightPixelDetection.glsl", "BRIGHT_DETECTION");
+	app->bloomDownsampleProgramIdx = CreateComputeProgram(app, "BloomDownsample.glsl", "BLOOM_DOWNSAMPLE");
+	app->bloomUpsampleProgramIdx = CreateComputeProgram(app, "BloomUpsample.glsl", "BLOOM_UPSAMPLE");
 	app->bloomBlurrProgramIdx = CreateProgram(app, "BloomBlurrPass.glsl", "BLURR_BLOOM");
-	app->bloomProgramIdx = CreateProgram(app, "BloomPass.glsl", "BLOOM_PASS");
 }
 
 
@@ -536,6 +553,8 @@ void InitCubemap(App* app)
 //GUI------------------------------------------------------------------------------------------
 void Gui(App* app)
 {
+	CPU_PROFILE_FUNCTION();
+
 	ImGui::Begin("Window");
 
 	DrawModeGui(app);
@@ -544,6 +563,10 @@ void Gui(App* app)
 	
 	DrawInfoGui(app);
 
+	DrawGpuMemoryGui(app);
+
+	DrawGpuProfilerGui(app);
+
 	ImGui::NewLine();
 	ImGui::Separator();
 	ImGui::NewLine();
@@ -560,6 +583,12 @@ void Gui(App* app)
 	ImGui::Separator();
 	ImGui::NewLine();
 
+	DrawStressSceneGui(app);
+
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
 	DrawCameraGui(app);
 
 	ImGui::NewLine();
@@ -574,6 +603,48 @@ void Gui(App* app)
 
 	DrawBloomGui(app);
 
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
+	DrawOcclusionCullingGui(app);
+
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
+	DrawSoftwareOcclusionGui(app);
+
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
+	DrawDynamicResolutionGui(app);
+
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
+	DrawExposureGui(app);
+
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
+	DrawTemporalAAGui(app);
+
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
+	DrawCaptureGui(app);
+
+	ImGui::NewLine();
+	ImGui::Separator();
+	ImGui::NewLine();
+
+	DrawRenderGraphGui(app);
+
 	DrawEntityGui(app);
 	
 	ImGui::End();
@@ -632,6 +703,32 @@ void DrawInfoGui(App* app)
 		ImGui::Text("Vendor: %s", app->info.vendor.c_str());
 		ImGui::Text("Shading language version: %s", app->info.shadingLanguageVersion.c_str());
 
+		ImGui::Separator();
+		ImGui::Text("Program cache: %s", app->programCache->enabled ? "enabled" : "disabled");
+		ImGui::Text("Programs loaded from cache: %u", app->programCache->hitCount);
+		ImGui::Text("Programs compiled: %u", app->programCache->missCount);
+		ImGui::Text("Parallel shader compile: %s", app->shaderCompiler->parallelCompile ? "supported" : "not supported");
+		ImGui::Text("Programs compiling: %u", app->shaderCompiler->GetPendingCount());
+		ImGui::Text("Watched files: %u (%s)", app->fileWatcher->GetWatchedCount(), app->fileWatcher->IsEventDriven() ? "inotify" : "polling");
+		ImGui::Text("Shader variants: %u", app->shaderPermutations->GetVariantCount());
+
+		//Compiles every variant used in this session at the next launch
+		if (ImGui::Button("Save shader variants"))
+			app->shaderPermutations->SaveManifest(SHADER_VARIANT_MANIFEST);
+
+		ImGui::Separator();
+		ArenaStats arenaStats = GetArenaStats();
+		ImGui::Text("Frame arenas: %u threads, %.2f MB reserved", arenaStats.arenaCount, arenaStats.reservedBytes / (1024.0 * 1024.0));
+		ImGui::Text("Arena peak: %.2f MB, %u overflows", arenaStats.highWaterMark / (1024.0 * 1024.0), arenaStats.overflowCount);
+
+		ImGui::Separator();
+		JobSystemStats jobStats = GetJobSystem().GetStats();
+		ImGui::Text("Job workers: %u", jobStats.workerCount);
+		ImGui::Text("Jobs run: %llu, %llu stolen", (unsigned long long)jobStats.executedCount, (unsigned long long)jobStats.stolenCount);
+
+		ImGui::Separator();
+		ImGui::Text("Transforms rebuilt: %u of %u", app->transforms.GetUpdatedCount(), app->transforms.GetCount());
+
 		int flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanFullWidth;
 
 		bool open = ImGui::TreeNodeEx("Extensions", flags);
@@ -652,99 +749,326 @@ void DrawInfoGui(App* app)
 }
 
 
-void DrawModelListGui(App* app)
+void DrawGpuMemoryGui(App* app)
 {
-	if (ImGui::CollapsingHeader("Model list", ImGuiTreeNodeFlags_None))
+	if (ImGui::CollapsingHeader("Gpu memory", ImGuiTreeNodeFlags_None))
 	{
-		int modelCount = app->models.size();
-		for (int i = 0; i < modelCount; ++i)
+		GpuMemoryTracker& memory = GetGpuMemory();
+		const double toMB = 1.0 / (1024.0 * 1024.0);
+
+		ImGui::NewLine();
+
+		ImGui::Text("Total: %.2f MB, peak %.2f MB", memory.totalBytes * toMB, memory.totalPeak * toMB);
+		ImGui::Text("Allocations: %u", (u32)memory.GetAllocations().size());
+
+		ImGui::NewLine();
+
+		for (int i = 0; i < (int)GPU_MEMORY_CATEGORY::MAX; ++i)
 		{
-			if (ImGui::Button(app->models[i].name.c_str()))
-			{
-				app->entityIdCount++;
-				app->entities.push_back(Entity(app->models[i].name + std::to_string(app->entityIdCount), i));
-			}
+			const char* name = GetGpuMemoryCategoryName((GPU_MEMORY_CATEGORY)i);
+			bool overBudget = memory.categoryBytes[i] > memory.budgets[i];
+
+			ImVec4 color = overBudget ? ImVec4(1.0, 0.4, 0.4, 1.0) : ImVec4(1.0, 1.0, 1.0, 1.0);
+			ImGui::TextColored(color, "%s: %.2f MB (%u), peak %.2f MB", name, memory.categoryBytes[i] * toMB, memory.categoryCounts[i], memory.categoryPeaks[i] * toMB);
+
+			ImGui::PushID(i);
+
+			float budget = memory.budgets[i] * toMB;
+			if (ImGui::DragFloat("Budget (MB)", &budget, 1.f, 0.f, 8192.f))
+				memory.budgets[i] = (u64)(budget * 1024.0 * 1024.0);
+
+			ImGui::PopID();
 		}
-	}
-}
 
+		ImGui::NewLine();
 
-void DrawEntityListGui(App* app)
-{
-	if (ImGui::CollapsingHeader("Entity list", ImGuiTreeNodeFlags_None))
-	{
-		int entityCount = app->entities.size();
-		for (int i = 0; i < entityCount; ++i)
+		if (ImGui::Button("Save memory dump"))
+			memory.WriteDump(GPU_MEMORY_DUMP_FILE);
+
+		ImGui::SameLine();
+
+		//Everything created after the mark that is still alive is listed below
+		if (ImGui::Button("Set leak mark"))
+			memory.SetLeakMark();
+
+		ImGui::SameLine();
+
+		if (ImGui::Button("Find stale handles"))
+			ILOG("%u stale gpu allocations removed", memory.RemoveStaleAllocations());
+
+		std::vector<const GpuAllocation*> sinceMark;
+		memory.GetAllocationsSinceMark(sinceMark);
+
+		u64 sinceMarkBytes = 0;
+		for (const GpuAllocation* allocation : sinceMark)
+			sinceMarkBytes += allocation->bytes;
+
+		ImGui::Text("Alive since mark: %u, %.2f MB", (u32)sinceMark.size(), sinceMarkBytes * toMB);
+
+		int flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanFullWidth;
+
+		if (ImGui::TreeNodeEx("Allocations", flags))
 		{
-			ImGui::PushID(i);
-			if (ImGui::Button(app->entities[i].name.c_str()))
+			std::vector<const GpuAllocation*> sorted;
+			for (const std::pair<const u64, GpuAllocation>& entry : memory.GetAllocations())
+				sorted.push_back(&entry.second);
+
+			//Biggest first
+			std::sort(sorted.begin(), sorted.end(), [](const GpuAllocation* a, const GpuAllocation* b) { return a->bytes > b->bytes; });
+
+			for (const GpuAllocation* allocation : sorted)
 			{
-				app->entities[i].drawInspector = !app->entities[i].drawInspector;
+				ImGui::Text("%8.2f MB  %s %u  %s  %s", allocation->bytes * toMB, GetGpuResourceTypeName(allocation->type), allocation->handle,
+					GetGpuMemoryCategoryName(allocation->category), allocation->owner.c_str());
 			}
-			ImGui::PopID();
+
+			ImGui::TreePop();
 		}
+
+		ImGui::NewLine();
 	}
 }
 
 
-void DrawEntityGui(App* app)
+void DrawGpuProfilerGui(App* app)
 {
-	for (int i = 0; i < app->entities.size(); ++i)
+	if (ImGui::CollapsingHeader("Gpu profiler", ImGuiTreeNodeFlags_None))
 	{
-		bool deleteEnity = false;
+		GpuProfiler* profiler = app->gpuProfiler;
+		const std::vector<GpuPassStats>& passes = profiler->GetPassStats();
+		const std::vector<GpuTimelineEntry>& timeline = profiler->GetTimeline();
 
-		if (app->entities[i].drawInspector == true)
-		{
-			Entity& entity = app->entities[i];
-			
-			ImGui::PushID(i);
-			ImGui::Begin(entity.name.c_str(), &entity.drawInspector);
+		ImGui::NewLine();
 
-			ImGui::NewLine();
+		ImGui::Checkbox("Enable gpu profiler", &profiler->enabled);
+		ImGui::Text("Gpu frame: %.3f ms", profiler->GetFrameTime());
+		ImGui::Text("Dropped frames: %u, skipped scopes: %u", profiler->droppedFrames, profiler->overflowScopes);
 
-			ImGui::DragFloat3("Position", &entity.position.x, 0.05f);
-			ImGui::DragFloat3("Rotation", &entity.rotation.x, 0.05f);
-			ImGui::DragFloat3("Scale", &entity.scale.x, 0.05f);
+		//The first pass is the whole frame
+		if (passes.empty() == false)
+		{
+			const GpuPassStats& frame = passes[0];
+			ImGui::PlotLines("##FrameHistory", frame.samples, frame.sampleCount, frame.sampleCount == GPU_PROFILER_HISTORY ? frame.nextSample : 0,
+				NULL, 0.f, frame.GetMax(), ImVec2(0, 60));
+		}
 
-			ImGui::NewLine();
-			
-			if (ImGui::Button("Delete entity"))
-				deleteEnity = true;
+		ImGui::NewLine();
 
-			ImGui::NewLine();
+		//Timeline of the last frame read, one row per depth
+		float frameTime = profiler->GetFrameTime();
+		if (timeline.empty() == false && frameTime > 0.f)
+		{
+			const float rowHeight = ImGui::GetTextLineHeight() + 4.f;
 
-			Model& model = app->models[app->entities[i].modelIdx];
+			u32 maxDepth = 0;
+			for (const GpuTimelineEntry& entry : timeline)
+				maxDepth = glm::max(maxDepth, entry.depth);
 
-			int materialCount = model.materialIdx.size();
-			for (int j = 0; j < materialCount; ++j)
+			ImDrawList* drawList = ImGui::GetWindowDrawList();
+			ImVec2 origin = ImGui::GetCursorScreenPos();
+			float width = glm::max(ImGui::GetContentRegionAvail().x, 100.f);
+			float scale = width / frameTime;
+
+			for (const GpuTimelineEntry& entry : timeline)
 			{
-				Material& mat = app->materials[model.materialIdx[j]];
-				if (ImGui::CollapsingHeader(mat.name.c_str(), ImGuiTreeNodeFlags_None))
-				{
-					ImGui::PushID(j);
-					ImGui::Spacing();	ImGui::Spacing();
+				ImVec2 min(origin.x + entry.start * scale, origin.y + entry.depth * rowHeight);
+				ImVec2 max(origin.x + glm::max(entry.end * scale, entry.start * scale + 1.f), min.y + rowHeight - 1.f);
 
-					ImGui::InputFloat3("Albedo", &mat.albedo.x, "%.1f", ImGuiInputTextFlags_AutoSelectAll);
-					ImGui::Spacing();
-					ImGui::InputFloat3("Emissive", &mat.emissive.x, "%.1f", ImGuiInputTextFlags_AutoSelectAll);
-					ImGui::Spacing();
-					ImGui::DragFloat("Smoothness", &mat.smoothness, 0.01f, 0.0f, 100.0f);
-					ImGui::Spacing();
-					ImGui::DragFloat("Reflectivity", &mat.reflectivity, 0.005f, 0.0f, 1.0f);
+				//Same color for a pass every frame
+				u32 hash = 0;
+				for (const char* c = entry.name; *c != '\0'; ++c)
+					hash = hash * 31 + *c;
 
-					ImVec2 textureSize = ImVec2(124, 124);
+				ImU32 color = IM_COL32(80 + hash % 120, 80 + (hash >> 8) % 120, 80 + (hash >> 16) % 120, 255);
 
-					ImGui::Spacing();	ImGui::Separator();		ImGui::Spacing();
+				drawList->AddRectFilled(min, max, color);
 
-					ImGui::TextColored(ImVec4(0.4, 1.0, 0.4, 1.0), "Albedo texture");
+				const char* label = entry.name;
+				if (ImGui::CalcTextSize(label).x < max.x - min.x - 4.f)
+					drawList->AddText(ImVec2(min.x + 2.f, min.y + 2.f), IM_COL32_WHITE, label);
 
-					if (mat.albedoTextureIdx != UINT32_MAX)
-						ImGui::Image((ImTextureID)app->textures[mat.albedoTextureIdx].handle, textureSize);
+				if (ImGui::IsMouseHoveringRect(min, max))
+					ImGui::SetTooltip("%s: %.3f ms", entry.name, entry.end - entry.start);
+			}
 
-					else
-						ImGui::Text("No texture");
+			ImGui::Dummy(ImVec2(width, (maxDepth + 1) * rowHeight));
+		}
 
-					ImGui::Spacing();	ImGui::Separator();		ImGui::Spacing();
+		ImGui::NewLine();
+
+		for (const GpuPassStats& pass : passes)
+		{
+			ImGui::Text("%*s%-18s avg %6.3f  p50 %6.3f  p95 %6.3f  p99 %6.3f  max %6.3f ms", pass.depth * 2, "", pass.name,
+				pass.average, pass.GetPercentile(0.5f), pass.GetPercentile(0.95f), pass.GetPercentile(0.99f), pass.GetMax());
+		}
+
+		ImGui::NewLine();
+
+		if (ImGui::Button("Export csv"))
+			profiler->WriteCsv(GPU_PROFILER_CSV_FILE);
+
+		ImGui::SameLine();
+
+		if (ImGui::Button("Export json"))
+			profiler->WriteJson(GPU_PROFILER_JSON_FILE);
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawModelListGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Model list", ImGuiTreeNodeFlags_None))
+	{
+		int modelCount = app->models.size();
+		for (int i = 0; i < modelCount; ++i)
+		{
+			if (ImGui::Button(app->models[i].name.c_str()))
+			{
+				app->entityIdCount++;
+				AddEntity(app, app->models[i].name + std::to_string(app->entityIdCount), i);
+			}
+		}
+	}
+}
+
+
+void DrawEntityListGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Entity list", ImGuiTreeNodeFlags_None))
+	{
+		//Only the visible rows are drawn, the stress scenes have thousands
+		ImGuiListClipper clipper;
+		clipper.Begin(app->entities.size());
+
+		while (clipper.Step())
+		{
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+			{
+				ImGui::PushID(i);
+				if (ImGui::Button(app->entities[i].name.c_str()))
+				{
+					app->entities[i].drawInspector = !app->entities[i].drawInspector;
+				}
+				ImGui::PopID();
+			}
+		}
+	}
+}
+
+
+void DrawStressSceneGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Stress scene", ImGuiTreeNodeFlags_None))
+	{
+		StressSceneSettings& settings = app->stressScene->settings;
+
+		ImGui::NewLine();
+
+		ImGui::DragInt("Entities", (int*)&settings.entityCount, 10.f, 0, 100000);
+		ImGui::SliderInt("Models", (int*)&settings.modelCount, 1, STRESS_SCENE_MAX_MODELS);
+		ImGui::SliderInt("Materials", (int*)&settings.materialCount, 1, STRESS_SCENE_MAX_MATERIALS);
+		ImGui::DragInt("Lights", (int*)&settings.lightCount, 1.f, 0, GLOBAL_PARAMS_MAX_LIGHTS);
+
+		const char* layoutNames[] = { "Grid", "Random", "Clustered" };
+		ImGui::Combo("Layout", (int*)&settings.layout, layoutNames, ARRAY_COUNT(layoutNames));
+
+		ImGui::DragInt("Seed", (int*)&settings.seed, 1.f, 0, INT_MAX);
+		ImGui::DragFloat("Spacing", &settings.spacing, 0.05f, 0.1f, 100.f);
+		ImGui::DragFloat("Entity size", &settings.entitySize, 0.05f, 0.1f, 100.f);
+
+		if (settings.layout == STRESS_LAYOUT::CLUSTERED)
+			ImGui::SliderInt("Clusters", (int*)&settings.clusterCount, 1, 64);
+
+		ImGui::NewLine();
+
+		if (ImGui::Button("Generate"))
+			app->stressScene->Generate(app);
+
+		if (app->stressScene->IsActive() == true)
+		{
+			ImGui::SameLine();
+			if (ImGui::Button("Restore scene"))
+				app->stressScene->Restore(app);
+
+			ImGui::Text("%u entities, %u lights", app->stressScene->generatedEntities, app->stressScene->generatedLights);
+		}
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawEntityGui(App* app)
+{
+	for (int i = 0; i < app->entities.size(); ++i)
+	{
+		bool deleteEnity = false;
+
+		if (app->entities[i].drawInspector == true)
+		{
+			Entity& entity = app->entities[i];
+			
+			ImGui::PushID(i);
+			ImGui::Begin(entity.name.c_str(), &entity.drawInspector);
+
+			ImGui::NewLine();
+
+			//Only written back when edited, so untouched entities stay clean
+			glm::vec3 position = app->transforms.GetPosition(i);
+			if (ImGui::DragFloat3("Position", &position.x, 0.05f))
+				app->transforms.SetPosition(i, position);
+
+			glm::vec3 rotation = RotationToEuler(app->transforms.GetRotation(i));
+			if (ImGui::DragFloat3("Rotation", &rotation.x, 0.05f))
+				app->transforms.SetRotation(i, EulerToRotation(rotation));
+
+			glm::vec3 scale = app->transforms.GetScale(i);
+			if (ImGui::DragFloat3("Scale", &scale.x, 0.05f))
+				app->transforms.SetScale(i, scale);
+
+			ImGui::Checkbox("Occluder", &entity.isOccluder);
+
+			ImGui::NewLine();
+			
+			if (ImGui::Button("Delete entity"))
+				deleteEnity = true;
+
+			ImGui::NewLine();
+
+			Model& model = app->models[app->entities[i].modelIdx];
+
+			int materialCount = model.materialIdx.size();
+			for (int j = 0; j < materialCount; ++j)
+			{
+				Material& mat = app->materials[model.materialIdx[j]];
+				if (ImGui::CollapsingHeader(mat.name.c_str(), ImGuiTreeNodeFlags_None))
+				{
+					ImGui::PushID(j);
+					ImGui::Spacing();	ImGui::Spacing();
+
+					ImGui::InputFloat3("Albedo", &mat.albedo.x, "%.1f", ImGuiInputTextFlags_AutoSelectAll);
+					ImGui::Spacing();
+					ImGui::InputFloat3("Emissive", &mat.emissive.x, "%.1f", ImGuiInputTextFlags_AutoSelectAll);
+					ImGui::Spacing();
+					ImGui::DragFloat("Smoothness", &mat.smoothness, 0.01f, 0.0f, 100.0f);
+					ImGui::Spacing();
+					ImGui::DragFloat("Reflectivity", &mat.reflectivity, 0.005f, 0.0f, 1.0f);
+
+					ImVec2 textureSize = ImVec2(124, 124);
+
+					ImGui::Spacing();	ImGui::Separator();		ImGui::Spacing();
+
+					ImGui::TextColored(ImVec4(0.4, 1.0, 0.4, 1.0), "Albedo texture");
+
+					if (mat.albedoTextureIdx != UINT32_MAX)
+						ImGui::Image((ImTextureID)app->textures[mat.albedoTextureIdx].handle, textureSize);
+
+					else
+						ImGui::Text("No texture");
+
+					ImGui::Spacing();	ImGui::Separator();		ImGui::Spacing();
 
 					ImGui::TextColored(ImVec4(0.4, 1.0, 0.4, 1.0), "Emissive texture");
 
@@ -792,7 +1116,7 @@ void DrawEntityGui(App* app)
 
 		if (deleteEnity == true)
 		{
-			app->entities.erase(app->entities.begin() + i);
+			RemoveEntity(app, i);
 			i--;
 		}
 	}
@@ -813,6 +1137,32 @@ void DrawCameraGui(App* app)
 		ImGui::DragFloat("FOV", app->camera.GetFOV(), 0.05f);
 		ImGui::DragFloat("Z Near", app->camera.GetZNear(), 0.001f, 0.f);
 		ImGui::DragFloat("Z Far", app->camera.GetZFar(), 0.6f);
+
+		ImGui::NewLine();
+
+		if (app->recordingCameraPath == false)
+		{
+			if (ImGui::Button("Record camera path"))
+			{
+				app->cameraPath->Clear();
+				app->cameraPathRecordTime = 0.f;
+				app->recordingCameraPath = true;
+			}
+		}
+		else if (ImGui::Button("Stop recording"))
+		{
+			app->recordingCameraPath = false;
+		}
+
+		ImGui::SameLine();
+
+		//Replayed with the benchmark
+		if (ImGui::Button("Save camera path"))
+			app->cameraPath->Save(CAMERA_PATH_FILE);
+
+		ImGui::Text("Keyframes: %u, %.2f s", app->cameraPath->GetKeyframeCount(), app->cameraPath->GetDuration());
+
+		ImGui::NewLine();
 	}
 }
 
@@ -841,6 +1191,13 @@ void DrawLightGui(App* app)
 
 		ImGui::NewLine();
 
+		const char* resolutionNames[] = { "Full", "Half", "Quarter" };
+		ImGui::Combo("Diffuse resolution", (int*)&app->lowResLighting->diffuseResolution, resolutionNames, ARRAY_COUNT(resolutionNames));
+		ImGui::Combo("Ambient resolution", (int*)&app->lowResLighting->ambientResolution, resolutionNames, ARRAY_COUNT(resolutionNames));
+		ImGui::Combo("Reflection resolution", (int*)&app->lowResLighting->reflectionResolution, resolutionNames, ARRAY_COUNT(resolutionNames));
+
+		ImGui::NewLine();
+
 		char lightNameBuffer[100];
 
 		for (int i = 0; i < app->lights.size(); ++i)
@@ -910,11 +1267,244 @@ void DrawBloomGui(App* app)
 
 		ImGui::NewLine();
 
-		ImGui::SliderFloat("LOD 1 intensity:", &app->bloomIntensity1, 0.0f, 1.0f);
-		ImGui::SliderFloat("LOD 2 intensity:", &app->bloomIntensity2, 0.0f, 1.0f);
-		ImGui::SliderFloat("LOD 3 intensity:", &app->bloomIntensity3, 0.0f, 1.0f);
-		ImGui::SliderFloat("LOD 4 intensity:", &app->bloomIntensity4, 0.0f, 1.0f);
-		ImGui::SliderFloat("LOD 5 intensity:", &app->bloomIntensity5, 0.0f, 1.0f);
+		ImGui::SliderFloat("Threshold:", &app->bloomThreshold, 0.0f, 5.0f);
+		ImGui::SliderFloat("Knee:", &app->bloomKnee, 0.0f, 1.0f);
+		ImGui::SliderFloat("Intensity:", &app->bloomIntensity, 0.0f, 2.0f);
+
+		ImGui::NewLine();
+
+		char lodNameBuffer[50];
+
+		for (int i = 0; i < BLOOM_MIP_COUNT; ++i)
+		{
+			sprintf_s(lodNameBuffer, 50, "LOD %i intensity:", i + 1);
+			ImGui::SliderFloat(lodNameBuffer, &app->bloomLevelIntensity[i], 0.0f, 1.0f);
+		}
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawOcclusionCullingGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Occlusion culling", ImGuiTreeNodeFlags_None))
+	{
+		OcclusionCulling* culling = app->occlusionCulling;
+
+		ImGui::NewLine();
+
+		ImGui::Checkbox("Enable occlusion culling", &culling->enabled);
+
+		ImGui::NewLine();
+
+		ImGui::Text("Visible: %u", culling->visibleCount);
+		ImGui::Text("Occluded: %u", culling->occludedCount);
+		ImGui::Text("Frustum culled: %u", culling->frustumCulledCount);
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawSoftwareOcclusionGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Software occlusion", ImGuiTreeNodeFlags_None))
+	{
+		SoftwareOcclusion* occlusion = app->softwareOcclusion;
+
+		ImGui::NewLine();
+
+		ImGui::Checkbox("Enable software occlusion", &app->applySoftwareOcclusion);
+		ImGui::Checkbox("Auto select occluders", &app->autoSelectOccluders);
+		ImGui::DragFloat("Occluder min size", &app->occluderMinSize, 0.1f, 0.f, 1000.f);
+		ImGui::DragInt("Occluder max triangles", &app->occluderMaxTriangles, 16.f, 0, 1000000);
+
+		ImGui::NewLine();
+
+		ImGui::Text("Occluders: %u", occlusion->occluderCount);
+		ImGui::Text("Occluder triangles: %u", occlusion->occluderTriangleCount);
+		ImGui::Text("Rasterized triangles: %u", occlusion->rasterizedTriangleCount);
+		ImGui::Text("Culled entities: %u", app->softwareCulledCount);
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawDynamicResolutionGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Dynamic resolution", ImGuiTreeNodeFlags_None))
+	{
+		DynamicResolution* resolution = app->dynamicResolution;
+
+		ImGui::NewLine();
+
+		ImGui::Checkbox("Enable dynamic resolution", &resolution->enabled);
+		ImGui::DragFloat("Target frame time (ms)", &resolution->targetFrameTime, 0.1f, 1.f, 100.f);
+		ImGui::SliderFloat("Min scale", &resolution->minScale, 0.25f, 1.f);
+		ImGui::SliderFloat("Max scale", &resolution->maxScale, 0.25f, 1.f);
+
+		if (resolution->minScale > resolution->maxScale)
+			resolution->minScale = resolution->maxScale;
+
+		ImGui::NewLine();
+
+		ImGui::Text("Gpu frame time: %.2f ms", resolution->gpuFrameTime);
+		ImGui::Text("Render scale: %.2f", resolution->renderScale);
+		ImGui::Text("Render size: %i x %i", app->renderSize.x, app->renderSize.y);
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawExposureGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Exposure", ImGuiTreeNodeFlags_None))
+	{
+		AutoExposure* exposure = app->autoExposure;
+
+		ImGui::NewLine();
+
+		const char* tonemapNames[] = { "None", "Reinhard", "ACES", "Uncharted 2" };
+		ImGui::Combo("Tonemap operator", (int*)&exposure->tonemapOperator, tonemapNames, ARRAY_COUNT(tonemapNames));
+
+		if (exposure->tonemapOperator == TONEMAP_OPERATOR::UNCHARTED2)
+			ImGui::DragFloat("White point", &exposure->whitePoint, 0.1f, 1.f, 50.f);
+
+		ImGui::NewLine();
+
+		ImGui::Checkbox("Auto exposure", &exposure->enabled);
+
+		if (exposure->enabled == true)
+		{
+			ImGui::DragFloat("Exposure compensation (EV)", &exposure->exposureCompensation, 0.05f, -5.f, 5.f);
+			ImGui::DragFloat("Key value", &exposure->keyValue, 0.005f, 0.01f, 1.f);
+			ImGui::DragFloat("Adaptation speed", &exposure->adaptationSpeed, 0.05f, 0.01f, 10.f);
+			ImGui::DragFloat("Min log luminance", &exposure->minLogLuminance, 0.1f, -20.f, exposure->maxLogLuminance - 0.1f);
+			ImGui::DragFloat("Max log luminance", &exposure->maxLogLuminance, 0.1f, exposure->minLogLuminance + 0.1f, 20.f);
+
+			ImGui::NewLine();
+
+			ImGui::Text("Average luminance: %.4f", exposure->averageLuminance);
+			ImGui::Text("Exposure: %.3f", exposure->exposure);
+		}
+		else
+			ImGui::DragFloat("Exposure", &exposure->manualExposure, 0.01f, 0.f, 20.f);
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawTemporalAAGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Temporal anti aliasing", ImGuiTreeNodeFlags_None))
+	{
+		TemporalAA* temporalAA = app->temporalAA;
+
+		ImGui::NewLine();
+
+		ImGui::Checkbox("Enable TAA", &temporalAA->enabled);
+		ImGui::SliderFloat("Blend factor", &temporalAA->blendFactor, 0.01f, 1.f);
+		ImGui::SliderFloat("Variance clip", &temporalAA->varianceClip, 0.5f, 3.f);
+		ImGui::SliderInt("Base jitter phases", &temporalAA->baseJitterPhases, 1, 32);
+
+		ImGui::NewLine();
+
+		ImGui::Text("Jitter phases: %i", temporalAA->jitterPhases);
+		ImGui::Text("Jitter: %.3f, %.3f", temporalAA->jitterPixels.x, temporalAA->jitterPixels.y);
+		ImGui::Text("Output size: %i x %i", app->displaySize.x, app->displaySize.y);
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawCaptureGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Capture", ImGuiTreeNodeFlags_None))
+	{
+		FrameCapture* capture = app->frameCapture;
+
+		ImGui::NewLine();
+
+		const char* sourceNames[] = { "Final", "Albedo", "Normals", "World position", "Color", "Reflectivity", "Depth", "Velocity" };
+		ImGui::Combo("Source", (int*)&capture->source, sourceNames, ARRAY_COUNT(sourceNames));
+
+		const char* formatNames[] = { "PNG", "HDR" };
+		ImGui::Combo("Format", (int*)&capture->format, formatNames, ARRAY_COUNT(formatNames));
+
+		if (ImGui::Button("Screenshot"))
+			capture->RequestScreenshot(capture->source, capture->format);
+
+		ImGui::NewLine();
+
+		if (capture->IsRecording() == false)
+		{
+			if (ImGui::Button("Start recording"))
+				capture->StartVideo(app->displaySize.x, app->displaySize.y);
+		}
+		else
+		{
+			if (ImGui::Button("Stop recording"))
+				capture->StopVideo();
+
+			ImGui::SameLine();
+			ImGui::Text("%u frames", capture->videoFrameCount);
+		}
+
+		ImGui::NewLine();
+
+		ImGui::Text("Captured frames: %u", capture->capturedCount);
+		ImGui::Text("Dropped frames: %u", capture->droppedCount);
+
+		ImGui::NewLine();
+	}
+}
+
+
+void DrawRenderGraphGui(App* app)
+{
+	if (ImGui::CollapsingHeader("Render graph", ImGuiTreeNodeFlags_None))
+	{
+		RenderGraph* graph = app->renderGraph;
+
+		ImGui::NewLine();
+
+		const std::deque<RenderGraphPass>& passes = graph->GetPasses();
+		for (u32 i = 0; i < passes.size(); ++i)
+		{
+			if (passes[i].culled == true)
+				ImGui::TextDisabled("%s (culled)", passes[i].name);
+			else
+				ImGui::Text("%s", passes[i].name);
+		}
+
+		ImGui::NewLine();
+
+		//Lifetimes in passes, over the ones kept
+		const std::vector<RenderGraphResource>& resources = graph->GetResources();
+		for (u32 i = 0; i < resources.size(); ++i)
+		{
+			const RenderGraphResource& resource = resources[i];
+
+			if (resource.firstPass == RENDER_GRAPH_NONE)
+				ImGui::TextDisabled("%s: unused", resource.name);
+			else if (resource.type == RENDER_GRAPH_RESOURCE::TRANSIENT)
+				ImGui::Text("%s: passes %u - %u, texture %u", resource.name, resource.firstPass, resource.lastPass, resource.texture);
+			else
+				ImGui::Text("%s: passes %u - %u", resource.name, resource.firstPass, resource.lastPass);
+		}
+
+		ImGui::NewLine();
+
+		//Shared with the other render targets
+		RenderTargetPoolStats poolStats = GetRenderTargetPool().GetStats();
+		ImGui::Text("Pooled targets: %u (%u free)", poolStats.targetCount, poolStats.freeCount);
+		ImGui::Text("Cached framebuffers: %u", poolStats.framebufferCount);
+		ImGui::Text("Targets created: %llu, reused: %llu", (unsigned long long)poolStats.createdCount, (unsigned long long)poolStats.reusedCount);
 
 		ImGui::NewLine();
 	}
@@ -924,36 +1514,68 @@ void DrawBloomGui(App* app)
 //Update----------------------------------------------------------------------------
 void Update(App* app)
 {
+	CPU_PROFILE_FUNCTION();
+
 	// You can handle app->input keyboard/mouse here
-	CheckToUpdateShaders(app);
+	if (app->input.keys[K_P] == BUTTON_PRESS)
+		WriteChromeTrace(CPU_TRACE_FILE, app->gpuProfiler);
+
+	CheckToReloadAssets(app);
+	GetJobSystem().RunMainThreadJobs();
+	app->frameCapture->Poll();
 
 	UpdateCamera(app);
+	app->temporalAA->Update(app);
+
+	//The occlusion culling and the uniform blocks read the world matrices
+	app->transforms.Update();
 
 	FillUniformGlobalParams(app);
 	FillUniformDebugLightParams(app);
 	FillUniformMaterialParams(app);
 	FillUniformLocalParams(app);
+	FillUniformBloomParams(app);
 }
 
 
-void CheckToUpdateShaders(App* app)
+void CheckToReloadAssets(App* app)
 {
-	int programCount = app->programs.size();
+	CPU_PROFILE_FUNCTION();
 
-	for (int i = 0; i < programCount; ++i)
+	std::vector<std::string> changedPaths;
+	app->fileWatcher->Drain(changedPaths);
+
+	for (int i = 0; i < changedPaths.size(); ++i)
 	{
-		std::string path = app->programs[i].filepath;
-		u64 currentTimeStamp = GetFileLastWriteTimestamp(path.c_str());
+		const std::string& path = changedPaths[i];
 
-		if (app->programs[i].lastWriteTimestamp < currentTimeStamp)
+		for (int j = 0; j < app->programs.size(); ++j)
 		{
-			glDeleteProgram(app->programs[i].handle);
+			Program& program = app->programs[j];
+
+			bool changed = program.filepath == path;
+			for (int k = 0; k < program.dependencies.size() && changed == false; ++k)
+				changed = program.dependencies[k] == path;
 
-			String source = ReadTextFile(app->programs[i].filepath.c_str());
-			app->programs[i].handle = CreateProgramFromSource(source, app->programs[i].programName.c_str());
-			app->programs[i].lastWriteTimestamp = currentTimeStamp;
+			//The old program keeps rendering until the shader compiler swaps it
+			if (changed == true)
+				CompileProgram(app, j);
+		}
+
+		for (int j = 0; j < app->textures.size(); ++j)
+		{
+			if (app->textures[j].filepath == path)
+				ReloadTexture2D(app, j);
+		}
+
+		for (int j = 0; j < app->models.size(); ++j)
+		{
+			if (app->models[j].name == path)
+				ReloadModel(app, j);
 		}
 	}
+
+	app->shaderCompiler->Update(app);
 }
 
 
@@ -965,153 +1587,410 @@ void UpdateCamera(App* app)
 	}
 
 	app->camera.HandleInput(&app->input);
+
+	if (app->recordingCameraPath == true)
+	{
+		//A keyframe every interval, the spline smooths the path between them
+		if (app->cameraPath->GetKeyframeCount() == 0 || app->cameraPathRecordTime >= app->cameraPath->GetDuration() + CAMERA_PATH_RECORD_INTERVAL)
+			app->cameraPath->AddKeyframe(app->cameraPathRecordTime, app->camera.GetPositionV3(), app->camera.GetTargetV3());
+
+		app->cameraPathRecordTime += app->deltaTime;
+	}
 }
 
 
 void FillUniformLocalParams(App* app)
 {
+	CPU_PROFILE_FUNCTION();
+
+	//A block per entity, the stress scenes can go over the size it was created with
+	ReserveBuffer(app->localUniformBuffer, GetBlockArraySize(app->localUniformBuffer, sizeof(LocalParams), app->entities.size()));
+
 	BindBuffer(app->localUniformBuffer);
 	MapBuffer(app->localUniformBuffer, GL_WRITE_ONLY);
 
-	glm::mat4 projection = app->camera.GetProjectionMatrix();
-	glm::mat4 view = app->camera.GetViewMatrix();
+	PushLocalParams(app, app->localUniformBuffer, app->temporalAA->viewProjection, app->temporalAA->prevViewProjection);
+
+	UnmapBuffer(app->localUniformBuffer);
+}
+
+
+void PushLocalParams(App* app, Buffer& buffer, const glm::mat4& viewProjection, const glm::mat4& prevViewProjection)
+{
+	glm::mat4 cameraViewProjection = app->camera.GetProjectionMatrix() * app->camera.GetViewMatrix();
 
 	int entityCount = app->entities.size();
-	for (int i = 0; i < entityCount; ++i)
-	{
-		AlignHead(app->localUniformBuffer, app->localUniformBuffer.alignement);
+	u32 stride = Align(sizeof(LocalParams), buffer.alignement);
+	u32 firstOffset = PushBlockArray(buffer, sizeof(LocalParams), entityCount);
 
-		app->entities[i].localParamsOffset = app->localUniformBuffer.head;
-		
-		glm::mat4 worldTransform = app->entities[i].CalculateWorldTransform();
-		PushMat4(app->localUniformBuffer, worldTransform);
+	//The world matrices are already up to date (TransformStore::Update()), only the camera matrices are applied.
+	//Every entity only writes its own block, so they are split across the job system
+	const TransformStore& transforms = app->transforms;
+	GetJobSystem().ParallelFor("PushLocalParams", entityCount, LOCAL_PARAMS_ENTITIES_PER_JOB, [&](u32 i, u32 /*threadIdx*/)
+		{
+			Entity& entity = app->entities[i];
+			const glm::mat4& worldTransform = transforms.GetWorld(i);
 
-		glm::mat4 worldViewProjection = projection * view * worldTransform;
-		PushMat4(app->localUniformBuffer, worldViewProjection);
+			LocalParams params;
+			params.worldMatrix = worldTransform;
+			MultiplyMatrix(cameraViewProjection, worldTransform, params.worldProjectionMatrix);
+			MultiplyMatrix(viewProjection, worldTransform, params.currentWorldProjectionMatrix);
+			MultiplyMatrix(prevViewProjection, transforms.GetPrevWorld(i), params.prevWorldProjectionMatrix);
 
-		app->entities[i].localParamsSize = app->localUniformBuffer.head - app->entities[i].localParamsOffset;
-	}
+			entity.localParamsOffset = firstOffset + i * stride;
+			entity.localParamsSize = sizeof(params);
 
-	UnmapBuffer(app->localUniformBuffer);
+			memcpy((u8*)buffer.data + entity.localParamsOffset, &params, sizeof(params));
+		});
 }
 
 
 void FillUniformDebugLightParams(App* app)
 {
+	CPU_PROFILE_FUNCTION();
+
+	ReserveBuffer(app->debugLightUniformBuffer, GetBlockArraySize(app->debugLightUniformBuffer, sizeof(LocalParams), app->lights.size()));
+
 	BindBuffer(app->debugLightUniformBuffer);
 	MapBuffer(app->debugLightUniformBuffer, GL_WRITE_ONLY);
 
-	glm::mat4 projection = app->camera.GetProjectionMatrix();
-	glm::mat4 view = app->camera.GetViewMatrix();
+	PushDebugLightParams(app, app->debugLightUniformBuffer, app->temporalAA->viewProjection, app->temporalAA->prevViewProjection);
+
+	UnmapBuffer(app->debugLightUniformBuffer);
+}
+
+
+void PushDebugLightParams(App* app, Buffer& buffer, const glm::mat4& viewProjection, const glm::mat4& prevViewProjection)
+{
+	//Once for every light
+	glm::mat4 cameraViewProjection = app->camera.GetProjectionMatrix() * app->camera.GetViewMatrix();
 
 	int lightCount = app->lights.size();
 	for (int i = 0; i < lightCount; ++i)
 	{
-		AlignHead(app->debugLightUniformBuffer, app->debugLightUniformBuffer.alignement);
-
-		app->lights[i].localParamsOffset = app->debugLightUniformBuffer.head;
-
 		glm::mat4 worldTransform = app->lights[i].CalculateWorldTransform();
-		PushMat4(app->debugLightUniformBuffer, worldTransform);
 
-		glm::mat4 worldViewProjection = projection * view * worldTransform;
-		PushMat4(app->debugLightUniformBuffer, worldViewProjection);
+		LocalParams params;
+		params.worldMatrix = worldTransform;
+		MultiplyMatrix(cameraViewProjection, worldTransform, params.worldProjectionMatrix);
 
-		app->lights[i].localParamsSize = app->debugLightUniformBuffer.head - app->lights[i].localParamsOffset;
-	}
+		//Lights are only moved from the editor, the camera motion is enough
+		MultiplyMatrix(viewProjection, worldTransform, params.currentWorldProjectionMatrix);
+		MultiplyMatrix(prevViewProjection, worldTransform, params.prevWorldProjectionMatrix);
 
-	UnmapBuffer(app->debugLightUniformBuffer);
+		app->lights[i].localParamsOffset = PushBlock(buffer, params);
+		app->lights[i].localParamsSize = sizeof(params);
+	}
 }
 
 
 void FillUniformMaterialParams(App* app)
 {
+	CPU_PROFILE_FUNCTION();
+
+	ReserveBuffer(app->materialUniformBuffer, GetBlockArraySize(app->materialUniformBuffer, sizeof(MaterialParams), app->materials.size()));
+
 	BindBuffer(app->materialUniformBuffer);
 	MapBuffer(app->materialUniformBuffer, GL_WRITE_ONLY);
 
+	PushMaterialParams(app, app->materialUniformBuffer);
+
+	UnmapBuffer(app->materialUniformBuffer);
+}
+
+
+void PushMaterialParams(App* app, Buffer& buffer)
+{
 	int materialCount = app->materials.size();
 	for (int i = 0; i < materialCount; ++i)
 	{
-		AlignHead(app->materialUniformBuffer, app->materialUniformBuffer.alignement);
+		MaterialParams params;
+		params.albedo = app->materials[i].albedo;
+		params.emissive = app->materials[i].emissive;
+		params.reflectivity = app->materials[i].reflectivity;
 
-		app->materials[i].localParamsOffset = app->materialUniformBuffer.head;
+		app->materials[i].localParamsOffset = PushBlock(buffer, params);
+		app->materials[i].localParamsSize = sizeof(params);
+	}
+}
 
-		PushVec3(app->materialUniformBuffer, app->materials[i].albedo);
 
-		PushVec3(app->materialUniformBuffer, app->materials[i].emissive);
+void FillUniformGlobalParams(App* app)
+{
+	CPU_PROFILE_FUNCTION();
 
-		PushFloat(app->materialUniformBuffer, app->materials[i].reflectivity);
+	BindBuffer(app->globalUniformBuffer);
+	MapBuffer(app->globalUniformBuffer, GL_WRITE_ONLY);
 
-		app->materials[i].localParamsSize = app->materialUniformBuffer.head - app->materials[i].localParamsOffset;
+	PushGlobalParams(app, app->globalUniformBuffer);
+
+	UnmapBuffer(app->globalUniformBuffer);
+}
+
+
+void PushGlobalParams(App* app, Buffer& buffer)
+{
+	//The block has room for a fixed number of lights, the rest are ignored
+	u32 lightCount = glm::min((u32)app->lights.size(), (u32)GLOBAL_PARAMS_MAX_LIGHTS);
+
+	GlobalParams params = {};
+	params.cameraPosition = app->camera.GetPositionV3();
+	params.lightCount = lightCount;
+
+	params.ambientLightStrength = app->ambientLightStrength;
+	params.ambientLightColor = app->ambientLightColor;
+
+	for (u32 i = 0; i < lightCount; ++i)
+	{
+		params.lights[i].type = (u32)app->lights[i].type;
+		params.lights[i].maxDistance = app->lights[i].maxDistance;
+		params.lights[i].color = app->lights[i].color;
+		params.lights[i].direction = app->lights[i].direction;
+		params.lights[i].position = app->lights[i].position;
 	}
 
-	UnmapBuffer(app->materialUniformBuffer);
+	app->globalParamsOffset = PushBlock(buffer, params);
+	app->globalParamsSize = sizeof(params);
 }
 
 
-void FillUniformGlobalParams(App* app)
+void FillUniformBloomParams(App* app)
 {
-	BindBuffer(app->globalUniformBuffer);
-	MapBuffer(app->globalUniformBuffer, GL_WRITE_ONLY);
-	
-	app->globalParamsOffset = app->globalUniformBuffer.head;
+	CPU_PROFILE_FUNCTION();
+
+	BindBuffer(app->bloomUniformBuffer);
+	MapBuffer(app->bloomUniformBuffer, GL_WRITE_ONLY);
+
+	BloomParams params;
+	params.threshold = app->bloomThreshold;
+	params.knee = app->bloomKnee;
+	params.intensity = app->bloomIntensity;
+
+	for (int i = 0; i < BLOOM_MIP_COUNT; ++i)
+		params.levelIntensity[i] = app->bloomLevelIntensity[i];
 
-	PushVec3(app->globalUniformBuffer, app->camera.GetPositionV3());
-	PushUInt(app->globalUniformBuffer, app->lights.size());
+	app->bloomParamsOffset = PushBlock(app->bloomUniformBuffer, params);
+	app->bloomParamsSize = sizeof(params);
 
-	PushFloat(app->globalUniformBuffer,app->ambientLightStrength);
-	PushVec3(app->globalUniformBuffer, app->ambientLightColor);
+	UnmapBuffer(app->bloomUniformBuffer);
+}
+
+
+//Render----------------------------------------------------------------------------
+void Render(App* app)
+{
+	CPU_PROFILE_FUNCTION();
+
+	app->dynamicResolution->BeginFrame();
+
+	//Only the deferred targets are scaled, forward rendering draws straight to the window
+	if (app->mode == Mode_Deferred)
+		app->renderSize = app->dynamicResolution->GetRenderSize(app->displaySize);
+	else
+		app->renderSize = app->displaySize;
+
+	if (app->displaySize.x > 0 && app->displaySize.y > 0)
+		app->renderScale = glm::vec2(app->renderSize) / glm::vec2(app->displaySize);
+
+	SoftwareOcclusionPass(app);
+
+	RenderGraph* graph = app->renderGraph;
+	graph->Reset();
+
+	switch (app->mode)
+	{
+	case Mode_Deferred:
+		AddDeferredPasses(app, *graph);
+		break;
+
+	case Mode_Forward:
+		AddForwardPasses(app, *graph);
+		break;
+
+	default:
+		break;
+	}
+
+	//Before the gui is drawn on top
+	AddCapturePass(app, *graph);
+
+	graph->Compile();
+	graph->Execute();
+
+	GetRenderTargetPool().EndFrame();
+
+	app->dynamicResolution->EndFrame();
+}
+
+
+void AddDeferredPasses(App* app, RenderGraph& graph)
+{
+	//The G-buffer outlives the frame: the occlusion culling, the capture and the temporal resolve read it later
+	u32 albedo = graph.Import("Albedo", app->framebuffer.textures[0].handle);
+	u32 normals = graph.Import("Normals", app->framebuffer.textures[1].handle);
+	u32 worldPos = graph.Import("World position", app->framebuffer.textures[2].handle);
+	u32 color = graph.Import("Color", app->framebuffer.textures[3].handle);
+	u32 reflectivity = graph.Import("Reflectivity", app->framebuffer.textures[4].handle);
+	u32 depth = graph.Import("Depth", app->framebuffer.textures[5].handle);
+	u32 velocity = graph.Import("Velocity", app->framebuffer.textures[6].handle);
+	u32 window = graph.ImportWindow();
+
+	RenderGraphPass& geometryPass = graph.AddPass("RenderModels", [app]() { RenderModels(app); });
+	geometryPass.WriteColor(albedo);
+	geometryPass.WriteColor(normals);
+	geometryPass.WriteColor(worldPos);
+	geometryPass.WriteColor(reflectivity);
+	geometryPass.WriteColor(velocity);
+	geometryPass.SetDepth(depth, true);
+
+	if (app->debugDrawLights == true)
+	{
+		RenderGraphPass& lightsPass = graph.AddPass("DebugDrawLights", [app]() { DebugDrawLights(app); });
+		lightsPass.WriteColor(albedo);
+		lightsPass.WriteColor(normals);
+		lightsPass.WriteColor(worldPos);
+		lightsPass.WriteColor(RENDER_GRAPH_NONE);
+		lightsPass.WriteColor(velocity);
+		lightsPass.SetDepth(depth, true);
+	}
+
+	RenderGraphPass& skyboxPass = graph.AddPass("RenderSkybox", [app]() { app->skybox->RenderSkybox(app); });
+	skyboxPass.WriteColor(albedo);
+	skyboxPass.SetDepth(depth, false);
+
+	u32 lowResTerms = RENDER_GRAPH_NONE;
+	if (app->lowResLighting->IsActive() == true)
+	{
+		lowResTerms = graph.ImportExternal("Low resolution lighting");
+
+		RenderGraphPass& lowResPass = graph.AddPass("LowResLighting", [app]() { app->lowResLighting->Render(app); });
+		lowResPass.Read(normals);
+		lowResPass.Read(worldPos);
+		lowResPass.Write(lowResTerms);
+	}
+
+	RenderGraphPass& lightPass = graph.AddPass("LightPass", [app]() { LightPass(app); });
+	lightPass.Read(albedo);
+	lightPass.Read(normals);
+	lightPass.Read(worldPos);
+	lightPass.Read(reflectivity);
+	if (lowResTerms != RENDER_GRAPH_NONE)
+		lightPass.Read(lowResTerms);
+	lightPass.WriteColor(color);
+
+	//The bloom debug view needs it even with bloom off
+	u32 bloomUp = RENDER_GRAPH_NONE;
+	if (app->applyBloom == true || app->drawMode == DRAW_MODE::BLOOM)
+	{
+		RenderTargetDesc bloomDesc = { app->bloomSize.x, app->bloomSize.y, GL_R11F_G11F_B10F, BLOOM_MIP_COUNT };
+		u32 bloomDown = graph.CreateTexture("Bloom down chain", bloomDesc);
+		bloomUp = graph.CreateTexture("Bloom up chain", bloomDesc);
+
+		RenderGraphPass& downsamplePass = graph.AddPass("BloomDownsample", [app, &graph, bloomDown]()
+			{
+				app->rtBloomDown = graph.GetTexture(bloomDown);
+				BloomDownsamplePass(app);
+			});
+		downsamplePass.Read(color);
+		downsamplePass.Write(bloomDown);
+
+		RenderGraphPass& upsamplePass = graph.AddPass("BloomUpsample", [app, &graph, bloomDown, bloomUp]()
+			{
+				app->rtBloomDown = graph.GetTexture(bloomDown);
+				app->rtBloomUp = graph.GetTexture(bloomUp);
+				BloomUpsamplePass(app);
+			});
+		upsamplePass.Read(bloomDown);
+		upsamplePass.Write(bloomUp);
+	}
+
+	u32 temporalOutput = RENDER_GRAPH_NONE;
+	if (app->temporalAA->IsActive(app) == true)
+	{
+		temporalOutput = graph.ImportExternal("Temporal output");
+
+		RenderGraphPass& resolvePass = graph.AddPass("TemporalResolve", [app]() { app->temporalAA->Resolve(app); });
+		resolvePass.Read(color);
+		resolvePass.Read(velocity);
+		resolvePass.Read(depth);
+		resolvePass.Write(temporalOutput);
+	}
 
-	int lightCount = app->lights.size();
-	for (int i = 0; i < lightCount; ++i)
+	u32 exposure = RENDER_GRAPH_NONE;
+	if (app->autoExposure->enabled == true)
 	{
-		AlignHead(app->globalUniformBuffer, sizeof(glm::vec4));
+		exposure = graph.ImportExternal("Exposure");
 
-		PushUInt(app->globalUniformBuffer, (u32)app->lights[i].type);
-		PushFloat(app->globalUniformBuffer, app->lights[i].maxDistance);
-		PushVec3(app->globalUniformBuffer, app->lights[i].color);
-		PushVec3(app->globalUniformBuffer, app->lights[i].direction);
-		PushVec3(app->globalUniformBuffer, app->lights[i].position);
+		RenderGraphPass& exposurePass = graph.AddPass("AutoExposure", [app]() { app->autoExposure->Compute(app); });
+		exposurePass.Read(color);
+		exposurePass.Write(exposure);
 	}
 
-	app->globalParamsSize = app->globalUniformBuffer.head - app->globalParamsOffset;
+	RenderGraphPass& compositePass = graph.AddPass("Composite", [app, &graph, bloomUp]()
+		{
+			app->rtBloomUp = graph.GetTexture(bloomUp);
+			app->composite->Render(app);
+		});
+	compositePass.WriteColor(window);
 
-	UnmapBuffer(app->globalUniformBuffer);
+	//Only what the view shows, the passes nothing else reads are culled
+	switch (app->drawMode)
+	{
+	case DRAW_MODE::DEFAULT:
+		compositePass.Read(temporalOutput != RENDER_GRAPH_NONE ? temporalOutput : color);
+		if (app->applyBloom == true)
+			compositePass.Read(bloomUp);
+		if (exposure != RENDER_GRAPH_NONE)
+			compositePass.Read(exposure);
+		break;
+
+	case DRAW_MODE::ALBEDO:			compositePass.Read(albedo);			break;
+	case DRAW_MODE::NORMALS:		compositePass.Read(normals);		break;
+	case DRAW_MODE::WORLD_POS:		compositePass.Read(worldPos);		break;
+	case DRAW_MODE::BLOOM:			compositePass.Read(bloomUp);		break;
+	case DRAW_MODE::REFLECTIVITY:	compositePass.Read(reflectivity);	break;
+	case DRAW_MODE::DEPTH:			compositePass.Read(depth);			break;
+
+	default:
+		compositePass.Read(color);
+		break;
+	}
 }
 
 
-//Render----------------------------------------------------------------------------
-void Render(App* app)
+void AddForwardPasses(App* app, RenderGraph& graph)
 {
-	switch (app->mode)
-	{
-	case Mode_Deferred:
-	{
-		RenderModels(app);
+	u32 window = graph.ImportWindow();
 
-		if (app->debugDrawLights == true)
-			DebugDrawLights(app);
+	RenderGraphPass& forwardPass = graph.AddPass("ForwardRender", [app]() { ForwardRender(app); });
+	forwardPass.WriteColor(window);
 
-		app->skybox->RenderSkybox(app);
-		LightPass(app);
+	RenderGraphPass& skyboxPass = graph.AddPass("RenderSkybox", [app]() { app->skybox->RenderSkybox(app); });
+	skyboxPass.WriteColor(window);
+}
 
 
-		if (app->applyBloom == true)
-			BloomPass(app);
+void AddCapturePass(App* app, RenderGraph& graph)
+{
+	u32 sources = app->frameCapture->GetPendingSources();
+	if (sources == 0)
+		return;
 
-		RenderScene(app);
-	}
-	break;
+	RenderGraphPass& capturePass = graph.AddPass("Capture", [app]() { app->frameCapture->Capture(app); });
 
-	case Mode_Forward:
-	{
-		ForwardRender(app);
-		app->skybox->RenderSkybox(app, true);
-	}
-	break;
+	//The readbacks leave the graph
+	capturePass.SetSideEffect();
 
-	default:
-		break;
+	for (int i = 0; i < (int)CAPTURE_SOURCE::MAX; ++i)
+	{
+		if ((sources & (1u << i)) == 0)
+			continue;
+
+		//Forward rendering has no G-buffer, the capture falls back to the final image
+		if ((CAPTURE_SOURCE)i == CAPTURE_SOURCE::FINAL || app->mode != Mode_Deferred)
+			capturePass.Read(graph.ImportWindow());
+		else
+			capturePass.Read(graph.Import(FrameCapture::GetSourceName((CAPTURE_SOURCE)i), app->framebuffer.textures[i - (int)CAPTURE_SOURCE::ALBEDO].handle));
 	}
 }
 
@@ -1173,12 +2052,82 @@ u32 FindVAO(Mesh& mesh, u32 submeshIndex, const Program& program)
 }
 
 
-void RenderModels(App* app)
+void SoftwareOcclusionPass(App* app)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, app->framebuffer.handle);
+	CPU_PROFILE_FUNCTION();
+
+	int entityCount = app->entities.size();
+	app->softwareCulledCount = 0;
+
+	if (app->applySoftwareOcclusion == false)
+	{
+		for (int i = 0; i < entityCount; ++i)
+			app->entities[i].culled = false;
+
+		return;
+	}
+
+	SoftwareOcclusion* occlusion = app->softwareOcclusion;
+	occlusion->Clear();
+
+	glm::mat4 viewProjection = app->camera.GetProjectionMatrix() * app->camera.GetViewMatrix();
+
+	const TransformStore& transforms = app->transforms;
+
+	//Occluders are the entities flagged by hand, or big and cheap enough submeshes
+	for (int i = 0; i < entityCount; ++i)
+	{
+		Entity& entity = app->entities[i];
+
+		glm::mat4 worldViewProjection;
+		MultiplyMatrix(viewProjection, transforms.GetWorld(i), worldViewProjection);
+
+		Model& model = app->models[entity.modelIdx];
+		Mesh& mesh = app->meshes[model.meshIdx];
+
+		int submeshCount = mesh.submeshes.size();
+		for (int j = 0; j < submeshCount; ++j)
+		{
+			Submesh& submesh = mesh.submeshes[j];
+
+			bool isOccluder = entity.isOccluder;
+
+			if (isOccluder == false && app->autoSelectOccluders == true && submesh.indices.size() / 3 <= (u32)app->occluderMaxTriangles)
+			{
+				glm::vec3 worldMin, worldMax;
+				TransformAABB(transforms.GetWorld(i), submesh.aabbMin, submesh.aabbMax, worldMin, worldMax);
+
+				isOccluder = glm::length(worldMax - worldMin) >= app->occluderMinSize;
+			}
+
+			if (isOccluder == true)
+			{
+				occlusion->AddOccluder(submesh.vertices.data(), submesh.vertexBufferLayout.stride / sizeof(float), submesh.indices.data(), submesh.indices.size(), worldViewProjection);
+			}
+		}
+	}
+
+	occlusion->Rasterize();
+
+	for (int i = 0; i < entityCount; ++i)
+	{
+		Entity& entity = app->entities[i];
+		Mesh& mesh = app->meshes[app->models[entity.modelIdx].meshIdx];
+
+		glm::vec3 worldMin, worldMax;
+		TransformAABB(transforms.GetWorld(i), mesh.aabbMin, mesh.aabbMax, worldMin, worldMax);
+
+		entity.culled = occlusion->IsVisible(worldMin, worldMax, viewProjection) == false;
+
+		if (entity.culled == true)
+			app->softwareCulledCount++;
+	}
+}
 
-	u32 drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT5 };
-	glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
+
+void RenderModels(App* app)
+{
+	GPU_PROFILE_SCOPE(app, "RenderModels");
 
 	glClearColor(0.f, 0.f, 0.f, 1.0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -1187,61 +2136,68 @@ void RenderModels(App* app)
 	//glEnable(GL_CULL_FACE);
 
 	// - set the viewport
-	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
+	glViewport(0, 0, app->renderSize.x, app->renderSize.y);
 
 	// - bind program
 	Program programTexGeo = app->programs[app->texturedGeometryProgramIdx];
 	glUseProgram(programTexGeo.handle);
 
-	int entityCount = app->entities.size();
-	for (int i = 0; i < entityCount; ++i)
+	if (app->occlusionCulling->enabled == true)
 	{
-		Model& model = app->models[app->entities[i].modelIdx];
-		Mesh& mesh = app->meshes[model.meshIdx];
-
-		int submeshCount = mesh.submeshes.size();
-
-		glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(1), app->localUniformBuffer.handle, app->entities[i].localParamsOffset, app->entities[i].localParamsSize);
+		app->occlusionCulling->RenderModels(app, programTexGeo);
+	}
 
-		for (int j = 0; j < submeshCount; ++j)
+	else
+	{
+		int entityCount = app->entities.size();
+		for (int i = 0; i < entityCount; ++i)
 		{
-			u32 vao = FindVAO(mesh, j, programTexGeo);
-			glBindVertexArray(vao);
+			if (app->entities[i].culled == true)
+				continue;
 
-			u32 materialIdx = model.materialIdx[j];
-			Material& material = app->materials[materialIdx];
+			Model& model = app->models[app->entities[i].modelIdx];
+			Mesh& mesh = app->meshes[model.meshIdx];
 
-			glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(2), app->materialUniformBuffer.handle, material.localParamsOffset, material.localParamsSize);
+			int submeshCount = mesh.submeshes.size();
 
-			if (material.albedoTextureIdx != UINT32_MAX)
+			glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(1), app->localUniformBuffer.handle, app->entities[i].localParamsOffset, app->entities[i].localParamsSize);
+
+			for (int j = 0; j < submeshCount; ++j)
 			{
-				glBindTexture(GL_TEXTURE_2D, app->textures[material.albedoTextureIdx].handle);
-				glUniform1i(app->geometryUniformTexture, 0);
-				glActiveTexture(GL_TEXTURE0);
-			}
+				u32 vao = FindVAO(mesh, j, programTexGeo);
+				glBindVertexArray(vao);
+
+				u32 materialIdx = model.materialIdx[j];
+				Material& material = app->materials[materialIdx];
+
+				glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(2), app->materialUniformBuffer.handle, material.localParamsOffset, material.localParamsSize);
+
+				if (material.albedoTextureIdx != UINT32_MAX)
+				{
+					glBindTexture(GL_TEXTURE_2D, app->textures[material.albedoTextureIdx].handle);
+					glUniform1i(app->geometryUniformTexture, 0);
+					glActiveTexture(GL_TEXTURE0);
+				}
 			
-			Submesh& submesh = mesh.submeshes[j];
-			glDrawElements(GL_TRIANGLES, submesh.indices.size(), GL_UNSIGNED_INT, (void*)(u64)submesh.indexOffset);
+				Submesh& submesh = mesh.submeshes[j];
+				glDrawElements(GL_TRIANGLES, submesh.indices.size(), GL_UNSIGNED_INT, (void*)(u64)submesh.indexOffset);
+			}
 		}
 	}
 
 	glBindVertexArray(0);
 	glUseProgram(0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
 void DebugDrawLights(App* app)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, app->framebuffer.handle);
-
-	u32 drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-	glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
+	GPU_PROFILE_SCOPE(app, "DebugDrawLights");
 
 	glEnable(GL_DEPTH_TEST);
 
 	// - set the viewport
-	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
+	glViewport(0, 0, app->renderSize.x, app->renderSize.y);
 
 	// - bind program
 	Program programTexGeo = app->programs[app->texturedGeometryProgramIdx];
@@ -1302,35 +2258,32 @@ void DebugDrawLights(App* app)
 
 	glBindVertexArray(0);
 	glUseProgram(0);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
 void LightPass(App* app)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, app->framebuffer.handle);
-
-	u32 drawBuffers[] = { GL_COLOR_ATTACHMENT3 };
-	glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
+	GPU_PROFILE_SCOPE(app, "LightPass");
 
 	glDisable(GL_DEPTH_TEST);
 
 	// - set the viewport
-	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
+	glViewport(0, 0, app->renderSize.x, app->renderSize.y);
 
 	// - bind program
-	Program programTexGeo = app->programs[app->lightProgramIdx];
+	u32 programIdx = app->shaderPermutations->GetVariant(app, app->lightPassPermutationIdx, app->lowResLighting->GetLightPassKey());
+	Program programTexGeo = app->programs[programIdx];
 	glUseProgram(programTexGeo.handle);
 	glBindVertexArray(app->vao);
 
 	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->globalUniformBuffer.handle, app->globalParamsOffset, app->globalParamsSize);
 
-	GLuint alb = glGetUniformLocation(app->programs[app->lightProgramIdx].handle, "albedo");	//TODO ask what to do about these
-	GLuint norm = glGetUniformLocation(app->programs[app->lightProgramIdx].handle, "normals");
-	GLuint pos = glGetUniformLocation(app->programs[app->lightProgramIdx].handle, "worldPos");
-	GLuint reflx = glGetUniformLocation(app->programs[app->lightProgramIdx].handle, "reflectivity");
-	GLuint skyBox = glGetUniformLocation(app->programs[app->lightProgramIdx].handle, "skyBox");
-	GLuint irr = glGetUniformLocation(app->programs[app->lightProgramIdx].handle, "irradianceMap");
+	GLuint alb = glGetUniformLocation(programTexGeo.handle, "albedo");	//TODO ask what to do about these
+	GLuint norm = glGetUniformLocation(programTexGeo.handle, "normals");
+	GLuint pos = glGetUniformLocation(programTexGeo.handle, "worldPos");
+	GLuint reflx = glGetUniformLocation(programTexGeo.handle, "reflectivity");
+	GLuint skyBox = glGetUniformLocation(programTexGeo.handle, "skyBox");
+	GLuint irr = glGetUniformLocation(programTexGeo.handle, "irradianceMap");
 
 	// - bind the texture into unit 0
 	glUniform1i(alb, 0);
@@ -1347,7 +2300,7 @@ void LightPass(App* app)
 	
 	glUniform1i(reflx, 3);
 	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[5].handle);
+	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[4].handle);
 
 	glUniform1i(skyBox, 4);
 	glActiveTexture(GL_TEXTURE4);
@@ -1357,7 +2310,10 @@ void LightPass(App* app)
 	glActiveTexture(GL_TEXTURE5);
 	glBindTexture(GL_TEXTURE_CUBE_MAP, app->skybox->irradianceMap.handle);
 
+	GLuint scale = glGetUniformLocation(programTexGeo.handle, "uRenderScale");
+	glUniform2fv(scale, 1, glm::value_ptr(app->renderScale));
 
+	app->lowResLighting->BindTerms(programTexGeo, 6);
 
 	// - draw
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -1380,167 +2336,104 @@ void LightPass(App* app)
 
 	glBindVertexArray(0);
 	glUseProgram(0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 
 void BloomPass(App* app)
 {
-	BrightPixelPass(app);
-	glBindTexture(GL_TEXTURE_2D, app->rtBright);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	BlurrBloomPass(app);
-
-	ApplyBloomPass(app);
+	BloomDownsamplePass(app);
+	BloomUpsamplePass(app);
 }
 
 
-void RenderScene(App* app)
+void BloomDownsamplePass(App* app)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GPU_PROFILE_SCOPE(app, "BloomDownsample");
 
-	glClearColor(0.1, 0.1, 0.1, 1.0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	// - set the viewport
-	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
-
-	// - bind program
-	Program programTexGeo = app->programs[app->screenRectProgramIdx];
-	glUseProgram(programTexGeo.handle);
-	glBindVertexArray(app->vao);
+	Program& program = app->programs[app->bloomDownsampleProgramIdx];
+	glUseProgram(program.handle);
 
-	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(0), app->globalUniformBuffer.handle, app->globalParamsOffset, app->globalParamsSize);
+	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(3), app->bloomUniformBuffer.handle, app->bloomParamsOffset, app->bloomParamsSize);
 
-	// - bind the texture into unit 0
-	glUniform1i(app->albedoTexture, 0);
+	GLuint uniformLocation = glGetUniformLocation(program.handle, "colorMap");
+	glUniform1i(uniformLocation, 0);
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[0].handle);
-
-	glUniform1i(app->normalsTexture, 1);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[1].handle);
-
-	glUniform1i(app->worldPositionTexture, 2);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[2].handle);
-
-	glUniform1i(app->defaultTexture, 3);
-	glActiveTexture(GL_TEXTURE3);
 	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[3].handle);
 
-	glUniform1i(app->bloomTexure, 4);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[4].handle);
-
-	glUniform1i(app->reflectivityTexture, 5);
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[5].handle);
-
-	glUniform1i(app->depthTexture, 6);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[6].handle);
-
-	glUniform1i(app->drawModeUniform, (int)app->drawMode);
-
-	// - draw
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-	// - clean
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	uniformLocation = glGetUniformLocation(program.handle, "uSourceSize");
+	glUniform2i(uniformLocation, app->renderSize.x, app->renderSize.y);
 
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	//Every mip of the chain is written by the same dispatch
+	for (int i = 0; i < BLOOM_MIP_COUNT; ++i)
+		glBindImageTexture(i, app->rtBloomDown, i, GL_FALSE, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
 
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	//Each group reduces a tile of mip 0, which covers half of the rendered region
+	glm::ivec2 mipZeroSize = (app->renderSize + glm::ivec2(1)) / 2;
+	glDispatchCompute((mipZeroSize.x + BLOOM_TILE_SIZE - 1) / BLOOM_TILE_SIZE, (mipZeroSize.y + BLOOM_TILE_SIZE - 1) / BLOOM_TILE_SIZE, 1);
 
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
-	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, 0);
-
-	glBindVertexArray(0);
 	glUseProgram(0);
 }
 
 
-void BrightPixelPass(App* app)
+void BloomUpsamplePass(App* app)
 {
-	app->fboBloom1.CheckStatus();
-	glBindFramebuffer(GL_FRAMEBUFFER, app->fboBloom1.handle);
+	GPU_PROFILE_SCOPE(app, "BloomUpsample");
 
-	u32 drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
-	glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
-
-	// - set the viewport
-	glViewport(0, 0, app->displaySize.x * 0.5, app->displaySize.y * 0.5);
-	glDisable(GL_DEPTH_TEST);
-
-	// - bind program
-	Program program = app->programs[app->brightPixelProgramIdx];
+	Program& program = app->programs[app->bloomUpsampleProgramIdx];
 	glUseProgram(program.handle);
-	glBindVertexArray(app->vao);
 
-	GLuint alb = glGetUniformLocation(program.handle, "albedoTexture");
+	glBindBufferRange(GL_UNIFORM_BUFFER, BINDING(3), app->bloomUniformBuffer.handle, app->bloomParamsOffset, app->bloomParamsSize);
 
-	// - bind the texture into unit 0
-	glUniform1i(alb, 0);
+	GLuint uniformLocation = glGetUniformLocation(program.handle, "downMap");
+	glUniform1i(uniformLocation, 0);
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[0].handle);
+	glBindTexture(GL_TEXTURE_2D, app->rtBloomDown);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	uniformLocation = glGetUniformLocation(program.handle, "upMap");
+	glUniform1i(uniformLocation, 1);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, app->rtBloomUp);
 
-	GLuint uniformLoc = glGetUniformLocation(program.handle, "threshold");
-	glUniform1f(uniformLoc, 0.99f);
+	uniformLocation = glGetUniformLocation(program.handle, "uRenderScale");
+	glUniform2fv(uniformLocation, 1, glm::value_ptr(app->renderScale));
 
-	// - draw
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	GLuint levelLocation = glGetUniformLocation(program.handle, "uLevel");
+	GLuint fromDownLocation = glGetUniformLocation(program.handle, "uFromDown");
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	//From the coarsest level up to mip 0
+	for (int level = BLOOM_MIP_COUNT - 2; level >= 0; --level)
+	{
+		glUniform1i(levelLocation, level);
+		glUniform1i(fromDownLocation, level == BLOOM_MIP_COUNT - 2 ? 1 : 0);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, 0);
+		glBindImageTexture(0, app->rtBloomUp, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
 
-	glBindVertexArray(0);
-	glUseProgram(0);
+		//Only the rendered region of the level
+		glm::ivec2 levelSize = glm::max(app->bloomSize >> level, glm::ivec2(1));
+		glm::ivec2 regionSize = glm::ivec2(glm::ceil(glm::vec2(levelSize) * app->renderScale));
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-}
+		glDispatchCompute((regionSize.x + 7) / 8, (regionSize.y + 7) / 8, 1);
+
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
 
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-void BlurrBloomPass(App* app)
-{
-	//horizontal blurr
-	Blurr(app, app->fboBloom1, app->displaySize.x / 2,  app->displaySize.y / 2,  1, app->rtBright, 0, 1.f, 0.f);
-	Blurr(app, app->fboBloom2, app->displaySize.x / 4,  app->displaySize.y / 4,  1, app->rtBright, 1, 1.f, 0.f);
-	Blurr(app, app->fboBloom3, app->displaySize.x / 8,  app->displaySize.y / 8,  1, app->rtBright, 2, 1.f, 0.f);
-	Blurr(app, app->fboBloom4, app->displaySize.x / 16, app->displaySize.y / 16, 1, app->rtBright, 3, 1.f, 0.f);
-	Blurr(app, app->fboBloom5, app->displaySize.x / 32, app->displaySize.y / 32, 1, app->rtBright, 4, 1.f, 0.f);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
 
-	//Vertical blurr
-	Blurr(app, app->fboBloom1, app->displaySize.x / 2,  app->displaySize.y / 2,  0, app->rtBloom, 0, 0.f, 1.f);
-	Blurr(app, app->fboBloom2, app->displaySize.x / 4,  app->displaySize.y / 4,  0, app->rtBloom, 1, 0.f, 1.f);
-	Blurr(app, app->fboBloom3, app->displaySize.x / 8,  app->displaySize.y / 8,  0, app->rtBloom, 2, 0.f, 1.f);
-	Blurr(app, app->fboBloom4, app->displaySize.x / 16, app->displaySize.y / 16, 0, app->rtBloom, 3, 0.f, 1.f);
-	Blurr(app, app->fboBloom5, app->displaySize.x / 32, app->displaySize.y / 32, 0, app->rtBloom, 4, 0.f, 1.f);
+	glUseProgram(0);
 }
 
 
 void Blurr(App* app, FrameBuffer& fbo, int texSizeX, int texSizeY, int attachment, u32 texture, int LOD, float directionX, float directionY)
 {
+	GPU_PROFILE_SCOPE(app, "Blurr");
+
 	glDisable(GL_DEPTH_TEST);
 	
 	glBindFramebuffer(GL_FRAMEBUFFER, fbo.handle);
@@ -1565,75 +2458,11 @@ void Blurr(App* app, FrameBuffer& fbo, int texSizeX, int texSizeY, int attachmen
 	uniformLoc = glGetUniformLocation(program.handle, "inputLod");
 	glUniform1i(uniformLoc, LOD);
 
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
-	glBindVertexArray(0);
-	glUseProgram(0);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-}
-
-
-void ApplyBloomPass(App* app)
-{
-	glBindFramebuffer(GL_FRAMEBUFFER, app->framebuffer.handle);
-
-	u32 drawBuffers[] = {GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4 };
-	glDrawBuffers(ARRAY_COUNT(drawBuffers), drawBuffers);
-
-	glDisable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-
-	// - set the viewport
-	glViewport(0, 0, app->displaySize.x, app->displaySize.y);
-
-	// - bind program
-	Program program = app->programs[app->bloomProgramIdx];
-	glUseProgram(program.handle);
-	glBindVertexArray(app->vao);
-
-	GLuint uniformLocation = glGetUniformLocation(program.handle, "bloomMap");
-
-	// - bind the texture into unit 0
-	glUniform1i(uniformLocation, 0);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, app->rtBright);
-
-	uniformLocation = glGetUniformLocation(program.handle, "colorMap");
-
-	// - bind the texture into unit 0
-	glUniform1i(uniformLocation, 1);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, app->framebuffer.textures[3].handle);
-
-	uniformLocation = glGetUniformLocation(program.handle, "maxLod");
-	glUniform1i(uniformLocation, 4);
-
-	uniformLocation = glGetUniformLocation(program.handle, "lodIntensity[0]");
-	glUniform1f(uniformLocation, app->bloomIntensity1);	
-	
-	uniformLocation = glGetUniformLocation(program.handle, "lodIntensity[1]");
-	glUniform1f(uniformLocation, app->bloomIntensity2);	
-	
-	uniformLocation = glGetUniformLocation(program.handle, "lodIntensity[2]");
-	glUniform1f(uniformLocation, app->bloomIntensity3);	
-	
-	uniformLocation = glGetUniformLocation(program.handle, "lodIntensity[3]");
-	glUniform1f(uniformLocation, app->bloomIntensity4);	
-	
-	uniformLocation = glGetUniformLocation(program.handle, "lodIntensity[4]");
-	glUniform1f(uniformLocation, app->bloomIntensity5);
+	uniformLoc = glGetUniformLocation(program.handle, "uRenderScale");
+	glUniform2f(uniformLoc, 1.f, 1.f);
 
-	// - draw
 	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
-	// - clean
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, 0);
-
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, 0);
 
@@ -1646,6 +2475,8 @@ void ApplyBloomPass(App* app)
 
 void ForwardRender(App* app)
 {
+	GPU_PROFILE_SCOPE(app, "ForwardRender");
+
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
 	glClearColor(0.f, 0.f, 0.f, 1.0);
@@ -1670,6 +2501,9 @@ void ForwardRender(App* app)
 	int entityCount = app->entities.size();
 	for (int i = 0; i < entityCount; ++i)
 	{
+		if (app->entities[i].culled == true)
+			continue;
+
 		Model& model = app->models[app->entities[i].modelIdx];
 		Mesh& mesh = app->meshes[model.meshIdx];
 
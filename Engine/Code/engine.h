@@ -11,13 +11,33 @@
 #include "Camera.h"
 #include "BufferManagement.h"
 #include "FrameBuffer.h"
+#include "UniformBlocks.h"
+#include "TransformStore.h"
 
 #include <glad/glad.h>
 
 #define MAX_GO_NAME_LENGTH 100
+#define BLOOM_TILE_SIZE 32         //Mip 0 texels reduced by each downsample group
+#define LOCAL_PARAMS_ENTITIES_PER_JOB 256
 
 struct Light;
 struct Environment;
+struct OcclusionCulling;
+class SoftwareOcclusion;
+struct LowResLighting;
+class DynamicResolution;
+struct AutoExposure;
+struct TemporalAA;
+struct Composite;
+class ProgramCache;
+class ShaderCompiler;
+class FileWatcher;
+class ShaderPermutations;
+class GpuProfiler;
+class CameraPath;
+class StressScene;
+class FrameCapture;
+class RenderGraph;
 
 const float rectVertices[] = {-1.0, -1.0, 0.0, 0.0, 0.0,
                            1.0, -1.0, 0.0, 1.0, 0.0,
@@ -65,6 +85,11 @@ struct App
 
     Camera camera;
 
+    //Recorded from the camera menu, replayed by the benchmark
+    CameraPath* cameraPath = nullptr;
+    bool recordingCameraPath = false;
+    float cameraPathRecordTime = 0.f;
+
     u32 entityIdCount = 0;
 
     // Loop
@@ -91,19 +116,26 @@ struct App
     std::vector<Model> models;
 
     std::vector<Entity> entities;
+    TransformStore transforms;          //Of the entities, same index
     std::vector<Light> lights;
 
     std::vector<Program>  programs;
+    ProgramCache* programCache = nullptr;
+    ShaderCompiler* shaderCompiler = nullptr;
+    FileWatcher* fileWatcher = nullptr;
+    ShaderPermutations* shaderPermutations = nullptr;
 
     //Ambient light
     float ambientLightStrength = 0.01;
     glm::vec3 ambientLightColor = {0.95, 0.8, 0.8};
 
+    //Low resolution lighting terms
+    LowResLighting* lowResLighting = nullptr;
+
     // program indices
     u32 texturedGeometryProgramIdx;
-    u32 screenRectProgramIdx;
 
-    u32 lightProgramIdx;
+    u32 lightPassPermutationIdx;
 
     u32 forwardRenderProgramIdx;
     
@@ -123,15 +155,6 @@ struct App
     GLuint embeddedElements;
 
     // Location of texture uniforms
-    GLuint albedoTexture;
-    GLuint normalsTexture;
-    GLuint worldPositionTexture;
-    GLuint defaultTexture;
-    GLuint bloomTexure;
-    GLuint depthTexture;
-    GLuint reflectivityTexture;
-    GLuint drawModeUniform;
-
     GLuint geometryUniformTexture;
 
     // VAO object to link our screen filling quad with our textured quad shader
@@ -143,40 +166,86 @@ struct App
     FrameBuffer framebuffer;
 
     //Bloom
-    u32 brightPixelProgramIdx;
-    u32 bloomBlurrProgramIdx;
-    u32 bloomProgramIdx;
+    u32 bloomDownsampleProgramIdx;
+    u32 bloomUpsampleProgramIdx;
+    u32 bloomBlurrProgramIdx;      //Still used to blur the environment irradiance
 
-    GLuint rtBright = 0;
-    GLuint rtBloom = 0;
+    //Transient targets of the render graph, set by the bloom and composite passes for the frame
+    GLuint rtBloomDown = 0;
+    GLuint rtBloomUp = 0;
+    glm::ivec2 bloomSize;
 
-    FrameBuffer fboBloom1;
-    FrameBuffer fboBloom2;
-    FrameBuffer fboBloom3;
-    FrameBuffer fboBloom4;
-    FrameBuffer fboBloom5;
+    Buffer bloomUniformBuffer;
+    int bloomParamsOffset = -1;
+    int bloomParamsSize = -1;
 
     bool applyBloom = true;
-    float bloomIntensity1 = 0.9f;
-    float bloomIntensity2 = 0.9f;
-    float bloomIntensity3 = 0.9f;
-    float bloomIntensity4 = 0.9f;
-    float bloomIntensity5 = 0.9f;
+    float bloomThreshold = 0.99f;
+    float bloomKnee = 0.1f;
+    float bloomIntensity = 1.f;
+    float bloomLevelIntensity[BLOOM_MIP_COUNT] = { 0.9f, 0.9f, 0.9f, 0.9f, 0.9f, 0.9f };
 
     //Skybox
     Environment* skybox = nullptr;
+
+    //Occlusion culling
+    OcclusionCulling* occlusionCulling = nullptr;
+
+    //Software occlusion
+    SoftwareOcclusion* softwareOcclusion = nullptr;
+    bool applySoftwareOcclusion = false;
+    bool autoSelectOccluders = true;
+    float occluderMinSize = 5.f;
+    int occluderMaxTriangles = 4096;
+    u32 softwareCulledCount = 0;
+
+    //Dynamic resolution
+    DynamicResolution* dynamicResolution = nullptr;
+    glm::ivec2 renderSize;                      //Internal resolution of the deferred targets this frame
+    glm::vec2 renderScale = glm::vec2(1.f);     //renderSize / displaySize
+
+    //Auto exposure and tonemapping
+    AutoExposure* autoExposure = nullptr;
+
+    //Temporal anti aliasing
+    TemporalAA* temporalAA = nullptr;
+
+    //Final composition to the window
+    Composite* composite = nullptr;
+
+    //Gpu time of every pass
+    GpuProfiler* gpuProfiler = nullptr;
+
+    //Generated scenes to see how the engine scales
+    StressScene* stressScene = nullptr;
+
+    //Screenshots and video read back without stalling
+    FrameCapture* frameCapture = nullptr;
+
+    //Passes of the frame, culled and given their transient targets
+    RenderGraph* renderGraph = nullptr;
 };
 
 
-u32 CreateProgram(App* app, const char* filepath, const char* programName);
-u32 LoadProgram(App* app, const char* filepath, const char* programName);
+//Preprocesses the file of the program and submits it, the hot reload uses it too
+GLuint CompileProgram(App* app, u32 programIdx);
+u32 CreateProgram(App* app, const char* filepath, const char* programName, const char* defines = "");
+u32 CreateComputeProgram(App* app, const char* filepath, const char* programName);
+u32 LoadProgram(App* app, const char* filepath, const char* programName, const char* defines = "");
 
 Image LoadImage(const char* filename);
+Image LoadImageHdr(const char* filename);     //Float pixels, for the environment maps
 void FreeImage(Image image);
 
-u32 CreateTexture2DFromImage(Image image);
+u32 CreateTexture2DFromImage(Image image, const char* owner);
 
 u32 LoadTexture2D(App* app, const char* filepath);
+u32 ReloadTexture2D(App* app, u32 texIdx);
+
+//Entities and their transforms are added and removed together
+Entity& AddEntity(App* app, const std::string& name, u32 modelIdx, const glm::vec3& position = glm::vec3(0.f), const glm::quat& rotation = glm::quat(1.f, 0.f, 0.f, 0.f), const glm::vec3& scale = glm::vec3(1.f));
+void RemoveEntity(App* app, u32 entityIdx);
+void ClearEntities(App* app);
 
 //Init-----------------------------------------------------------------
 void Init(App* app);
@@ -200,39 +269,62 @@ void Gui(App* app);
 
 void DrawModeGui(App* app);
 void DrawInfoGui(App* app);
+void DrawGpuMemoryGui(App* app);
+void DrawGpuProfilerGui(App* app);
 void DrawModelListGui(App* app);
 void DrawEntityListGui(App* app);
+void DrawStressSceneGui(App* app);
 void DrawEntityGui(App* app);
 void DrawCameraGui(App* app);
 void DrawLightGui(App* app);
 void DrawBloomGui(App* app);
+void DrawOcclusionCullingGui(App* app);
+void DrawSoftwareOcclusionGui(App* app);
+void DrawDynamicResolutionGui(App* app);
+void DrawExposureGui(App* app);
+void DrawTemporalAAGui(App* app);
+void DrawCaptureGui(App* app);
+void DrawRenderGraphGui(App* app);
 
 //Update---------------------------------------------------------------
 void Update(App* app);
 
-void CheckToUpdateShaders(App* app);
+void CheckToReloadAssets(App* app);
 void UpdateCamera(App* app);
 void FillUniformLocalParams(App* app);
 void FillUniformDebugLightParams(App* app);
 void FillUniformMaterialParams(App* app);
 void FillUniformGlobalParams(App* app);
+void FillUniformBloomParams(App* app);
+
+//Write the blocks to a buffer that is already mapped, the functions above map the uniform buffers around
+//them. Apart so the cpu cost can be measured without gl
+void PushLocalParams(App* app, Buffer& buffer, const glm::mat4& viewProjection, const glm::mat4& prevViewProjection);
+void PushDebugLightParams(App* app, Buffer& buffer, const glm::mat4& viewProjection, const glm::mat4& prevViewProjection);
+void PushMaterialParams(App* app, Buffer& buffer);
+void PushGlobalParams(App* app, Buffer& buffer);
 
 //Render----------------------------------------------------------------
 void Render(App* app);
 
 u32 FindVAO(Mesh& mesh, u32 submeshIndex, const Program& program);
 
+//Declare the passes of the frame and what they read and write
+void AddDeferredPasses(App* app, RenderGraph& graph);
+void AddForwardPasses(App* app, RenderGraph& graph);
+void AddCapturePass(App* app, RenderGraph& graph);
+
+void SoftwareOcclusionPass(App* app);
+
 void RenderModels(App* app);
 void DebugDrawLights(App* app);
 void LightPass(App* app);
 void BloomPass(App* app);
-void RenderScene(App* app);
 
 //Bloom
-void BrightPixelPass(App* app);
-void BlurrBloomPass(App* app);
+void BloomDownsamplePass(App* app);
+void BloomUpsamplePass(App* app);
 void Blurr(App* app, FrameBuffer& fbo, int texSizeX, int texSizeY, int attachment, u32 texture, int LOD, float directionX, float directionY);
-void ApplyBloomPass(App* app);
 
 //Forward render
 void ForwardRender(App* app);
@@ -13,9 +13,20 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <errno.h>
 #endif
 
 #include "engine.h"
+#include "Arena.h"
+#include "OcclusionCulling.h"
+#include "LowResLighting.h"
+#include "TemporalAA.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "Benchmark.h"
+#include "MicroBenchmark.h"
+#include "FrameCapture.h"
+#include "JobSystem.h"
 
 #include <GLFW/glfw3.h>
 #include <stdio.h>
@@ -27,10 +38,6 @@
 #define WINDOW_WIDTH  800
 #define WINDOW_HEIGHT 600
 
-#define GLOBAL_FRAME_ARENA_SIZE MB(16)
-u8* GlobalFrameArenaMemory = NULL;
-u32 GlobalFrameArenaHead = 0;
-
 void OnGlfwError(int errorCode, const char* errorMessage)
 {
 	fprintf(stderr, "glfw failed with error %d: %s\n", errorCode, errorMessage);
@@ -108,6 +115,15 @@ void OnGlfwResizeFramebuffer(GLFWwindow* window, int width, int height)
 	app->displaySize = glm::vec2(width, height);
 	app->framebuffer.Regenerate(width, height);
 	InitBloomResources(app);
+
+	if (app->occlusionCulling != nullptr)
+		app->occlusionCulling->Resize(width, height);
+
+	if (app->lowResLighting != nullptr)
+		app->lowResLighting->Resize(width, height);
+
+	if (app->temporalAA != nullptr)
+		app->temporalAA->Resize(width, height);
 }
 
 void OnGlfwCloseWindow(GLFWwindow* window)
@@ -116,8 +132,33 @@ void OnGlfwCloseWindow(GLFWwindow* window)
 	app->isRunning = false;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+	SetProfilerThreadName("Main");
+
+	//-trace writes the startup and the first frames to CPU_TRACE_FILE
+	//-benchmark [settings file] renders without a window and exits, see Benchmark.h
+	//-microbench [baseline file] times the cpu hot paths without gl and exits, see MicroBenchmark.h
+	bool traceStartup = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-trace") == 0)
+			traceStartup = true;
+
+		else if (strcmp(argv[i], "-benchmark") == 0)
+		{
+			glfwSetErrorCallback(OnGlfwError);
+			return RunBenchmark(i + 1 < argc && argv[i + 1][0] != '-' ? argv[i + 1] : BENCHMARK_SETTINGS_FILE);
+		}
+
+		else if (strcmp(argv[i], "-microbench") == 0)
+		{
+			return RunMicroBenchmarks(MICRO_BENCHMARK_FILE, i + 1 < argc && argv[i + 1][0] != '-' ? argv[i + 1] : nullptr);
+		}
+	}
+
+	u32 frameCount = 0;
+
 	App app = {};
 	app.deltaTime = 1.0f / 60.0f;
 	app.displaySize = glm::ivec2(WINDOW_WIDTH, WINDOW_HEIGHT);
@@ -199,12 +240,15 @@ int main()
 
 	f64 lastFrameTime = glfwGetTime();
 
-	GlobalFrameArenaMemory = (u8*)malloc(GLOBAL_FRAME_ARENA_SIZE);
+	InitThreadArena(GLOBAL_FRAME_ARENA_SIZE);
+	InitJobSystem();
 
 	Init(&app);
 
 	while (app.isRunning)
 	{
+		CPU_PROFILE_SCOPE("Frame");
+
 		// Tell GLFW to call platform callbacks
 		glfwPollEvents();
 
@@ -241,10 +285,14 @@ int main()
 		app.input.mouseDelta = glm::vec2(0.0f, 0.0f);
 
 		// Render
+		app.gpuProfiler->BeginFrame();
 		Render(&app);
 
 		// ImGui Render
+		app.gpuProfiler->BeginScope("ImGui");
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		app.gpuProfiler->EndScope();
+		app.gpuProfiler->EndFrame();
 		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
 			GLFWwindow* backup_current_context = glfwGetCurrentContext();
 			ImGui::UpdatePlatformWindows();
@@ -253,7 +301,10 @@ int main()
 		}
 
 		// Present image on screen
-		glfwSwapBuffers(window);
+		{
+			CPU_PROFILE_SCOPE("SwapBuffers");
+			glfwSwapBuffers(window);
+		}
 
 		// Frame time
 		f64 currentFrameTime = glfwGetTime();
@@ -261,10 +312,18 @@ int main()
 		lastFrameTime = currentFrameTime;
 
 		// Reset frame allocator
-		GlobalFrameArenaHead = 0;
+		GetThreadArena().Reset();
+
+		frameCount++;
+		if (traceStartup == true && frameCount == CPU_TRACE_STARTUP_FRAMES)
+			WriteChromeTrace(CPU_TRACE_FILE, app.gpuProfiler);
 	}
 
-	free(GlobalFrameArenaMemory);
+	//Writes the captures still in flight while the context is alive
+	delete app.frameCapture;
+	app.frameCapture = nullptr;
+
+	ShutdownJobSystem();
 
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -285,43 +344,21 @@ u32 Strlen(const char* string)
 
 void* PushSize(u32 byteCount)
 {
-	ASSERT(GlobalFrameArenaHead + byteCount <= GLOBAL_FRAME_ARENA_SIZE,
-		"Trying to allocate more temp memory than available");
-
-	u8* curPtr = GlobalFrameArenaMemory + GlobalFrameArenaHead;
-	GlobalFrameArenaHead += byteCount;
-	return curPtr;
+	return GetThreadArena().Push(byteCount);
 }
 
 void* PushBytes(const void* bytes, u32 byteCount)
 {
-	ASSERT(GlobalFrameArenaHead + byteCount <= GLOBAL_FRAME_ARENA_SIZE,
-		"Trying to allocate more temp memory than available");
-
-	u8* srcPtr = (u8*)bytes;
-	u8* curPtr = GlobalFrameArenaMemory + GlobalFrameArenaHead;
-	u8* dstPtr = GlobalFrameArenaMemory + GlobalFrameArenaHead;
-	GlobalFrameArenaHead += byteCount;
-	while (byteCount--) *dstPtr++ = *srcPtr++;
-	return curPtr;
-}
-
-u8* PushChar(u8 c)
-{
-	ASSERT(GlobalFrameArenaHead + 1 <= GLOBAL_FRAME_ARENA_SIZE,
-		"Trying to allocate more temp memory than available");
-	u8* ptr = GlobalFrameArenaMemory + GlobalFrameArenaHead;
-	GlobalFrameArenaHead++;
-	*ptr = c;
-	return ptr;
+	return GetThreadArena().PushCopy(bytes, byteCount);
 }
 
 String MakeString(const char* cstr)
 {
 	String str = {};
 	str.len = Strlen(cstr);
-	str.str = (char*)PushBytes(cstr, str.len);
-	PushChar(0);
+	str.str = (char*)PushSize(str.len + 1);
+	memcpy(str.str, cstr, str.len);
+	str.str[str.len] = '\0';
 	return str;
 }
 
@@ -329,10 +366,11 @@ String MakePath(String dir, String filename)
 {
 	String str = {};
 	str.len = dir.len + filename.len + 1;
-	str.str = (char*)PushBytes(dir.str, dir.len);
-	PushChar('/');
-	PushBytes(filename.str, filename.len);
-	PushChar(0);
+	str.str = (char*)PushSize(str.len + 1);
+	memcpy(str.str, dir.str, dir.len);
+	str.str[dir.len] = '/';
+	memcpy(str.str + dir.len + 1, filename.str, filename.len);
+	str.str[str.len] = '\0';
 	return str;
 }
 
@@ -346,8 +384,9 @@ String GetDirectoryPart(String path)
 			break;
 	}
 	str.len = (u32)len;
-	str.str = (char*)PushBytes(path.str, str.len);
-	PushChar(0);
+	str.str = (char*)PushSize(str.len + 1);
+	memcpy(str.str, path.str, str.len);
+	str.str[str.len] = '\0';
 	return str;
 }
 
@@ -394,13 +433,36 @@ u64 GetFileLastWriteTimestamp(const char* filepath)
 	// NOTE: This has not been tested in unix-like systems
 	struct stat attrib;
 	if (stat(filepath, &attrib) == 0) {
+#ifdef __linux__
+		//Nanoseconds, so saves within the same second are not missed
+		return (u64)attrib.st_mtim.tv_sec * 1000000000ull + attrib.st_mtim.tv_nsec;
+#else
 		return attrib.st_mtime;
+#endif
 	}
 #endif
 
 	return 0;
 }
 
+bool MakeDirectory(const char* path)
+{
+#ifdef _WIN32
+	if (CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS)
+		return true;
+#else
+	if (mkdir(path, 0755) == 0 || errno == EEXIST)
+		return true;
+#endif
+
+	return false;
+}
+
+void* GetGLProcAddress(const char* name)
+{
+	return (void*)glfwGetProcAddress(name);
+}
+
 void LogString(const char* str)
 {
 #ifdef _WIN32
@@ -81,6 +81,17 @@ String ReadTextFile(const char *filepath);
  */
 u64 GetFileLastWriteTimestamp(const char *filepath);
 
+/**
+ * Creates a directory if it doesn't exist yet. Returns false if it can't be created.
+ */
+bool MakeDirectory(const char *path);
+
+/**
+ * Returns the address of an OpenGL function that is not loaded by glad, like extension entry points.
+ * Returns NULL if the driver doesn't expose it.
+ */
+void* GetGLProcAddress(const char *name);
+
 /**
  * It logs a string to whichever outputs are configured in the platform layer.
  * By default, the string is printed in the output console of VisualStudio.
@@ -101,6 +112,9 @@ LogString(logBuffer);             \
 
 #define ARRAY_COUNT(array) (sizeof(array)/sizeof(array[0]))
 
+#define CONCAT_INNER(a, b) a##b
+#define CONCAT(a, b) CONCAT_INNER(a, b)
+
 #define ASSERT(condition, message) assert((condition) && message)
 
 #define BINDING(b) b        //TODO ask about this
@@ -5,11 +5,13 @@
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec2 aTexCoord;
 
+uniform vec2 uRenderScale;	//Fraction of the targets used by the internal resolution
+
 out vec2 vTexCoord;
 
 void main()
 {
-	vTexCoord = aTexCoord;
+	vTexCoord = aTexCoord * uRenderScale;
 
 	gl_Position = vec4(aPosition, 1.0);
 }
@@ -21,6 +23,7 @@ in vec2 vTexCoord;
 uniform sampler2D colorMap;
 uniform vec2 direction;
 uniform int inputLod;
+uniform vec2 uRenderScale;
 
 layout (location = 0) out vec4 color;
 
@@ -31,12 +34,12 @@ void main()
 	vec2 texSize = textureSize(colorMap, inputLod);
 	vec2 texelSize = 1.0 / texSize;
 	vec2 margin1 = texelSize * 0.5;
-	vec2 margin2 = vec2(1.0) - margin1;
+	vec2 margin2 = uRenderScale - margin1;
 
 	vec2 dirFragCoord = gl_FragCoord.xy * direction;
 	int coord = int(dirFragCoord.x + dirFragCoord.y);
 
-	vec2 directionTexSize = texSize * direction;
+	vec2 directionTexSize = texSize * uRenderScale * direction;
 	int size = int(directionTexSize.x + directionTexSize.y);
 
 	int kernelBegin = -min(kernelRadius, coord);
@@ -0,0 +1,120 @@
+#ifdef BLOOM_DOWNSAMPLE
+
+#if defined(COMPUTE) //////////////////////////////////////////////////
+
+//Bright pass + whole mip chain in a single dispatch: every group owns a 32x32 tile of mip 0
+//and reduces it in shared memory down to the last mip (1x1 texel of the tile)
+
+#define BLOOM_MIP_COUNT 6
+#define TILE_SIZE 32
+
+layout (local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout (binding = 3, std140) uniform BloomParams
+{
+	float uThreshold;
+	float uKnee;
+	float uIntensity;
+	vec4 uLevelIntensity[BLOOM_MIP_COUNT];
+};
+
+uniform sampler2D colorMap;
+uniform ivec2 uSourceSize;	//Region of the color map rendered this frame
+
+layout (binding = 0, r11f_g11f_b10f) writeonly uniform image2D mips[BLOOM_MIP_COUNT];
+
+shared vec3 tile[16][16];
+
+
+float Luminance(vec3 color)
+{
+	return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+
+//Soft knee threshold
+vec3 BrightPass(vec3 color)
+{
+	float luminance = Luminance(color);
+
+	float soft = clamp(luminance - uThreshold + uKnee, 0.0, 2.0 * uKnee);
+	soft = soft * soft / (4.0 * uKnee + 0.00001);
+
+	float contribution = max(soft, luminance - uThreshold) / max(luminance, 0.00001);
+
+	return color * contribution;
+}
+
+
+vec3 FetchBright(ivec2 coord)
+{
+	coord = min(coord, uSourceSize - ivec2(1));
+	return BrightPass(texelFetch(colorMap, coord, 0).rgb);
+}
+
+
+//Weighted by the inverse luminance so single very bright pixels don't flicker
+vec3 KarisAverage(vec3 a, vec3 b, vec3 c, vec3 d)
+{
+	float wa = 1.0 / (1.0 + Luminance(a));
+	float wb = 1.0 / (1.0 + Luminance(b));
+	float wc = 1.0 / (1.0 + Luminance(c));
+	float wd = 1.0 / (1.0 + Luminance(d));
+
+	return (a * wa + b * wb + c * wc + d * wd) / (wa + wb + wc + wd);
+}
+
+
+void main()
+{
+	ivec2 localId = ivec2(gl_LocalInvocationID.xy);
+	ivec2 tileBase = ivec2(gl_WorkGroupID.xy) * TILE_SIZE;
+
+	//Mip 0: 2x2 texels per thread, each one from 2x2 source pixels
+	vec3 sum = vec3(0.0);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		ivec2 coord = tileBase + localId * 2 + ivec2(i & 1, i >> 1);
+		ivec2 source = coord * 2;
+
+		vec3 value = KarisAverage(FetchBright(source), FetchBright(source + ivec2(1, 0)),
+								  FetchBright(source + ivec2(0, 1)), FetchBright(source + ivec2(1, 1)));
+
+		imageStore(mips[0], coord, vec4(value, 1.0));
+		sum += value;
+	}
+
+	//Mip 1: one texel per thread
+	vec3 value = sum * 0.25;
+	imageStore(mips[1], (tileBase >> 1) + localId, vec4(value, 1.0));
+	tile[localId.y][localId.x] = value;
+
+	barrier();
+
+	//Rest of the chain, every level uses a quarter of the threads of the previous one
+	for (int level = 2; level < BLOOM_MIP_COUNT; ++level)
+	{
+		int levelSize = TILE_SIZE >> level;
+		bool active = localId.x < levelSize && localId.y < levelSize;
+
+		if (active)
+		{
+			ivec2 src = localId * 2;
+			value = (tile[src.y][src.x] + tile[src.y][src.x + 1] + tile[src.y + 1][src.x] + tile[src.y + 1][src.x + 1]) * 0.25;
+		}
+
+		barrier();
+
+		if (active)
+		{
+			tile[localId.y][localId.x] = value;
+			imageStore(mips[level], (tileBase >> level) + localId, vec4(value, 1.0));
+		}
+
+		barrier();
+	}
+}
+
+#endif
+#endif
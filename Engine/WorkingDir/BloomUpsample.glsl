@@ -0,0 +1,77 @@
+#ifdef BLOOM_UPSAMPLE
+
+#if defined(COMPUTE) //////////////////////////////////////////////////
+
+//One level of the upsample chain: up[level] = down[level] * intensity + tent(up[level + 1])
+
+#define BLOOM_MIP_COUNT 6
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout (binding = 3, std140) uniform BloomParams
+{
+	float uThreshold;
+	float uKnee;
+	float uIntensity;
+	vec4 uLevelIntensity[BLOOM_MIP_COUNT];
+};
+
+uniform sampler2D downMap;
+uniform sampler2D upMap;
+uniform int uLevel;
+uniform int uFromDown;		//The coarsest level has no upsampled data yet
+uniform vec2 uRenderScale;
+
+layout (binding = 0, r11f_g11f_b10f) writeonly uniform image2D dstLevel;
+
+
+//3x3 tent filter over the lower level
+vec3 Tent(sampler2D map, vec2 uv, int lod)
+{
+	vec2 texelSize = 1.0 / vec2(textureSize(map, lod));
+
+	//Keep the taps inside the region rendered this frame
+	vec2 minUv = texelSize * 0.5;
+	vec2 maxUv = uRenderScale - texelSize * 0.5;
+
+	vec3 result = vec3(0.0);
+
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			float weight = (x == 0 ? 2.0 : 1.0) * (y == 0 ? 2.0 : 1.0);
+			vec2 tapUv = clamp(uv + vec2(x, y) * texelSize, minUv, maxUv);
+
+			result += textureLod(map, tapUv, float(lod)).rgb * weight;
+		}
+	}
+
+	return result / 16.0;
+}
+
+
+void main()
+{
+	ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 size = imageSize(dstLevel);
+
+	if (coord.x >= size.x || coord.y >= size.y)
+		return;
+
+	vec2 uv = (vec2(coord) + 0.5) / vec2(size);
+
+	vec3 lower;
+
+	if (uFromDown == 1)
+		lower = Tent(downMap, uv, uLevel + 1) * uLevelIntensity[uLevel + 1].x;
+	else
+		lower = Tent(upMap, uv, uLevel + 1);
+
+	vec3 current = texelFetch(downMap, coord, uLevel).rgb * uLevelIntensity[uLevel].x;
+
+	imageStore(dstLevel, coord, vec4(current + lower, 1.0));
+}
+
+#endif
+#endif
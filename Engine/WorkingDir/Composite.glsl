@@ -0,0 +1,136 @@
+#ifdef COMPOSITE
+
+//Variants are compiled with:
+// DRAW_MODE			Same values as DRAW_MODE on the engine, 0 is the final image
+// TONEMAP_OPERATOR		Same values as TONEMAP_OPERATOR on the engine
+// BLOOM				Adds the top of the bloom upsample chain
+// AUTO_EXPOSURE		Uses the exposure computed on the gpu
+
+#if defined(VERTEX) ///////////////////////////////////////////////////
+
+out vec2 vTexCoord;
+
+//Single triangle covering the screen, no vertex buffer needed
+void main()
+{
+	vTexCoord = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+	gl_Position = vec4(vTexCoord * 2.0 - 1.0, 0.0, 1.0);
+}
+
+#elif defined(FRAGMENT) ///////////////////////////////////////////////
+
+in vec2 vTexCoord;
+
+uniform vec2 uRenderScale;	//Fraction of the targets used by the internal resolution
+
+layout (location = 0) out vec4 color;
+
+#if DRAW_MODE == 0
+
+uniform sampler2D sceneMap;
+uniform vec2 uSceneScale;	//The temporal output is already at window resolution
+
+uniform float uExposure;	//Manual exposure, or the compensation when auto exposure is on
+uniform float uWhitePoint;
+
+#ifdef BLOOM
+
+#define BLOOM_MIP_COUNT 6
+
+layout (binding = 3, std140) uniform BloomParams
+{
+	float uThreshold;
+	float uKnee;
+	float uIntensity;
+	vec4 uLevelIntensity[BLOOM_MIP_COUNT];
+};
+
+uniform sampler2D bloomMap;
+
+#endif
+
+#ifdef AUTO_EXPOSURE
+
+layout (binding = 1, std430) readonly buffer ExposureData
+{
+	float averageLuminance;
+	float autoExposure;
+};
+
+#endif
+
+
+#if TONEMAP_OPERATOR == 3
+vec3 Uncharted2Curve(vec3 x)
+{
+	const float A = 0.15;
+	const float B = 0.50;
+	const float C = 0.10;
+	const float D = 0.20;
+	const float E = 0.02;
+	const float F = 0.30;
+
+	return ((x * (A * x + C * B) + D * E) / (x * (A * x + B) + D * F)) - E / F;
+}
+#endif
+
+
+vec3 Tonemap(vec3 hdr)
+{
+#if TONEMAP_OPERATOR == 1
+	//Reinhard
+	return hdr / (1.0 + hdr);
+
+#elif TONEMAP_OPERATOR == 2
+	//ACES filmic fit
+	return clamp((hdr * (2.51 * hdr + 0.03)) / (hdr * (2.43 * hdr + 0.59) + 0.14), 0.0, 1.0);
+
+#elif TONEMAP_OPERATOR == 3
+	//Uncharted 2
+	return Uncharted2Curve(hdr * 2.0) / Uncharted2Curve(vec3(uWhitePoint));
+
+#else
+	return hdr;
+#endif
+}
+
+
+void main()
+{
+	vec3 hdr = texture(sceneMap, vTexCoord * uSceneScale).rgb;
+
+#ifdef BLOOM
+	hdr += textureLod(bloomMap, vTexCoord * uRenderScale, 0.0).rgb * uIntensity;
+#endif
+
+	float exposure = uExposure;
+
+#ifdef AUTO_EXPOSURE
+	exposure *= autoExposure;
+#endif
+
+	color = vec4(Tonemap(hdr * exposure), 1.0);
+}
+
+#else
+
+//Debug views of a single target
+uniform sampler2D debugMap;
+
+void main()
+{
+	vec4 value = texture(debugMap, vTexCoord * uRenderScale);
+
+#if DRAW_MODE == 5 || DRAW_MODE == 6
+	//Depth and reflectivity only have one channel
+	color = vec4(value.xxx, 1.0);
+#else
+	color = vec4(value.rgb, 1.0);
+#endif
+}
+
+#endif
+
+#endif
+#endif
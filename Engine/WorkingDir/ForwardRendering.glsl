@@ -33,9 +33,6 @@ in vec3 vPosition;
 in vec3 vNormal;
 
 uniform sampler2D uTexture;
-uniform samplerCube irradianceMap;
-
-float specularStrength = 0.5;
 
 layout (binding = 2, std140) uniform MaterialParams
 {
@@ -46,71 +43,7 @@ layout (binding = 2, std140) uniform MaterialParams
 
 layout (location = 0) out vec4 color;
 
-struct Light
-{
-	unsigned int type;
-	float maxDistance;
-	vec3 color;
-	vec3 direction;
-	vec3 position;
-};
-
-layout (binding = 0, std140) uniform GlobalParams
-{
-	vec3 uCameraPosition;
-	unsigned int uLightCount;
-
-	float uAmbientLightStrength;
-	vec3 uAmbientLightCol;
-
-	Light uLight[16];
-};
-
-
-vec3 CalculateAmbientLight(vec3 pos, vec3 normal)
-{
-	vec3 viewDir = normalize(uCameraPosition - pos.xyz);
-
-	return texture(irradianceMap, reflect(-viewDir, normal.xyz)).rgb * uAmbientLightStrength;
-}
-
-
-vec3 CalculateDiffuse(vec3 pos, vec3 normal)
-{
-	vec3 col = vec3(0.0, 0.0, 0.0);
-
-	for(int i = 0; i < uLightCount; ++i)
-	{
-		vec3 viewDir = normalize(uCameraPosition - pos.xyz);
-		vec3 reflectDir;
-
-		if (uLight[i].type == 0)
-		{
-			reflectDir = reflect(normalize(-uLight[i].direction), normal.xyz);
-
-			float diff = max(dot(normal.xyz, normalize(uLight[i].direction)), 0.0);
-			col += diff * uLight[i].color;
-		}
-
-
-		else
-		{
-			vec3 dir = normalize(uLight[i].position - pos.xyz);
-			reflectDir = reflect(-dir, normal.xyz);
-
-			float diff = max(dot(normal.xyz, dir), 0.0);
-			float atenuation = 1.0 - smoothstep(0.0, uLight[i].maxDistance, length(uLight[i].position - pos.xyz));
-			col += diff * uLight[i].color * atenuation;
-		}
-
-		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-		vec3 specular = specularStrength * spec * uLight[i].color;
-
-		col += specular;
-	}
-
-	return col;
-}
+#include "Lighting.glsl"
 
 
 void main()
@@ -0,0 +1,63 @@
+#ifdef HIZ_BUILD
+
+#if defined(COMPUTE) //////////////////////////////////////////////////
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+uniform sampler2D depthMap;
+uniform int uFromDepth;
+uniform int uSrcLevel;
+
+layout (binding = 0, r32f) readonly uniform image2D srcLevel;
+layout (binding = 1, r32f) writeonly uniform image2D dstLevel;
+
+float LoadSrc(ivec2 coord, ivec2 srcSize)
+{
+	coord = min(coord, srcSize - ivec2(1));
+	return imageLoad(srcLevel, coord).x;
+}
+
+void main()
+{
+	ivec2 dstCoord = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 dstSize = imageSize(dstLevel);
+
+	if (dstCoord.x >= dstSize.x || dstCoord.y >= dstSize.y)
+		return;
+
+	if (uFromDepth == 1)
+	{
+		imageStore(dstLevel, dstCoord, vec4(texelFetch(depthMap, dstCoord, 0).x));
+		return;
+	}
+
+	ivec2 srcSize = imageSize(srcLevel);
+	ivec2 srcCoord = dstCoord * 2;
+
+	float depth = max(max(LoadSrc(srcCoord, srcSize), LoadSrc(srcCoord + ivec2(1, 0), srcSize)),
+					  max(LoadSrc(srcCoord + ivec2(0, 1), srcSize), LoadSrc(srcCoord + ivec2(1, 1), srcSize)));
+
+	//Odd sizes leave an extra row/column that the last texel has to cover
+	bool extraColumn = (srcSize.x & 1) != 0 && dstCoord.x == dstSize.x - 1;
+	bool extraRow = (srcSize.y & 1) != 0 && dstCoord.y == dstSize.y - 1;
+
+	if (extraColumn)
+	{
+		depth = max(depth, max(LoadSrc(srcCoord + ivec2(2, 0), srcSize), LoadSrc(srcCoord + ivec2(2, 1), srcSize)));
+	}
+
+	if (extraRow)
+	{
+		depth = max(depth, max(LoadSrc(srcCoord + ivec2(0, 2), srcSize), LoadSrc(srcCoord + ivec2(1, 2), srcSize)));
+	}
+
+	if (extraColumn && extraRow)
+	{
+		depth = max(depth, LoadSrc(srcCoord + ivec2(2, 2), srcSize));
+	}
+
+	imageStore(dstLevel, dstCoord, vec4(depth));
+}
+
+#endif
+#endif
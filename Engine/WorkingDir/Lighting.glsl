@@ -0,0 +1,71 @@
+//Lights and lighting terms shared by the deferred and the forward paths
+
+float specularStrength = 0.5;
+
+struct Light
+{
+	unsigned int type;
+	float maxDistance;
+	vec3 color;
+	vec3 direction;
+	vec3 position;
+};
+
+layout (binding = 0, std140) uniform GlobalParams
+{
+	vec3 uCameraPosition;
+	unsigned int uLightCount;
+
+	float uAmbientLightStrength;
+	vec3 uAmbientLightCol;
+
+	Light uLight[16];
+};
+
+uniform samplerCube irradianceMap;
+
+
+vec3 CalculateAmbientLight(vec3 pos, vec3 normal)
+{
+	vec3 viewDir = normalize(uCameraPosition - pos);
+
+	return texture(irradianceMap, reflect(-viewDir, normal)).rgb * uAmbientLightStrength;
+}
+
+
+vec3 CalculateDiffuse(vec3 pos, vec3 normal)
+{
+	vec3 col = vec3(0.0, 0.0, 0.0);
+
+	for(int i = 0; i < uLightCount; ++i)
+	{
+		vec3 viewDir = normalize(uCameraPosition - pos);
+		vec3 reflectDir;
+
+		if (uLight[i].type == 0)
+		{
+			reflectDir = reflect(normalize(-uLight[i].direction), normal);
+
+			float diff = max(dot(normal, normalize(uLight[i].direction)), 0.0);
+			col += diff * uLight[i].color;
+		}
+
+
+		else
+		{
+			vec3 dir = normalize(uLight[i].position - pos);
+			reflectDir = reflect(-dir, normal);
+
+			float diff = max(dot(normal, dir), 0.0);
+			float atenuation = 1.0 - smoothstep(0.0, uLight[i].maxDistance, length(uLight[i].position - pos));
+			col += diff * uLight[i].color * atenuation;
+		}
+
+		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+		vec3 specular = specularStrength * spec * uLight[i].color;
+
+		col += specular;
+	}
+
+	return col;
+}
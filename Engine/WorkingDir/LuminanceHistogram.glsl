@@ -0,0 +1,114 @@
+#if defined(LUMINANCE_HISTOGRAM) || defined(EXPOSURE_AVERAGE)
+
+#if defined(COMPUTE) //////////////////////////////////////////////////
+
+#define HISTOGRAM_BINS 256
+
+layout (local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+layout (binding = 0, std430) buffer Histogram
+{
+	uint bins[HISTOGRAM_BINS];
+};
+
+layout (binding = 1, std430) buffer ExposureData
+{
+	float averageLuminance;
+	float exposure;
+};
+
+uniform float uMinLogLuminance;
+
+shared uint localBins[HISTOGRAM_BINS];
+
+
+#ifdef LUMINANCE_HISTOGRAM
+
+//Every group bins its pixels in shared memory and adds the result to the global histogram once
+
+uniform sampler2D colorMap;
+uniform ivec2 uSourceSize;	//Region of the color map rendered this frame
+uniform float uInverseLogLuminanceRange;
+
+
+//Bin 0 keeps the pixels too dark to have a meaningful log
+uint LuminanceToBin(vec3 color)
+{
+	float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+
+	if (luminance < 0.0001)
+		return 0u;
+
+	float logLuminance = clamp((log2(luminance) - uMinLogLuminance) * uInverseLogLuminanceRange, 0.0, 1.0);
+
+	return uint(logLuminance * 254.0 + 1.0);
+}
+
+
+void main()
+{
+	localBins[gl_LocalInvocationIndex] = 0;
+	barrier();
+
+	ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+
+	if (coord.x < uSourceSize.x && coord.y < uSourceSize.y)
+	{
+		uint bin = LuminanceToBin(texelFetch(colorMap, coord, 0).rgb);
+		atomicAdd(localBins[bin], 1u);
+	}
+
+	barrier();
+
+	atomicAdd(bins[gl_LocalInvocationIndex], localBins[gl_LocalInvocationIndex]);
+}
+
+#endif
+
+
+#ifdef EXPOSURE_AVERAGE
+
+//A single group, one thread per bin. Reduces the histogram to the average and clears it for the next frame
+
+uniform uint uPixelCount;
+uniform float uLogLuminanceRange;
+uniform float uAdaptation;	//Fraction of the way to the new average covered this frame
+uniform float uKeyValue;
+
+
+void main()
+{
+	uint index = gl_LocalInvocationIndex;
+	uint count = bins[index];
+
+	localBins[index] = count * index;
+	bins[index] = 0;
+
+	barrier();
+
+	for (uint stride = HISTOGRAM_BINS / 2; stride > 0; stride >>= 1)
+	{
+		if (index < stride)
+			localBins[index] += localBins[index + stride];
+
+		barrier();
+	}
+
+	if (index == 0)
+	{
+		//Bin 0 doesn't add to the weighted sum, only remove its pixels from the count
+		float validPixels = max(float(uPixelCount) - float(count), 1.0);
+		float averageBin = max(float(localBins[0]) / validPixels - 1.0, 0.0);
+
+		float averageLogLuminance = (averageBin / 254.0) * uLogLuminanceRange + uMinLogLuminance;
+		float frameLuminance = exp2(averageLogLuminance);
+
+		averageLuminance = averageLuminance + (frameLuminance - averageLuminance) * uAdaptation;
+		exposure = uKeyValue / max(averageLuminance, 0.0001);
+	}
+}
+
+#endif
+
+#endif
+#endif
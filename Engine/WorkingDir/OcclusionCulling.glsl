@@ -0,0 +1,163 @@
+#ifdef OCCLUSION_CULL
+
+#if defined(COMPUTE) //////////////////////////////////////////////////
+
+layout (local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+struct CullObject
+{
+	vec4 aabbMin;
+	vec4 aabbMax;
+	uint firstDraw;
+	uint drawCount;
+	uint padding0;
+	uint padding1;
+};
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	uint baseVertex;
+	uint baseInstance;
+};
+
+layout (binding = 0, std430) readonly buffer Objects
+{
+	CullObject objects[];
+};
+
+layout (binding = 1, std430) buffer PhaseOneCommands
+{
+	DrawCommand phaseOneCommands[];
+};
+
+layout (binding = 2, std430) buffer PhaseTwoCommands
+{
+	DrawCommand phaseTwoCommands[];
+};
+
+layout (binding = 3, std430) buffer Visibility
+{
+	uint visibility[];
+};
+
+layout (binding = 4, std430) buffer Counters
+{
+	uint visibleCount;
+	uint occludedCount;
+	uint frustumCulledCount;
+};
+
+uniform mat4 uViewProjection;
+uniform int uPhase;
+uniform uint uObjectCount;
+uniform vec2 uHiZSize;
+uniform vec2 uRenderScale;	//Fraction of the depth attachment used by the internal resolution
+uniform int uHiZMipCount;
+
+uniform sampler2D hiZ;
+
+//Screen space bounds of the aabb: xy = min uv, zw = max uv. Returns false if the box crosses the near plane.
+bool ProjectAABB(vec3 aabbMin, vec3 aabbMax, out vec4 rect, out float closestDepth, out bool outsideFrustum)
+{
+	vec3 ndcMin = vec3(1.0);
+	vec3 ndcMax = vec3(-1.0);
+
+	for (int i = 0; i < 8; ++i)
+	{
+		vec3 corner = vec3((i & 1) != 0 ? aabbMax.x : aabbMin.x,
+						   (i & 2) != 0 ? aabbMax.y : aabbMin.y,
+						   (i & 4) != 0 ? aabbMax.z : aabbMin.z);
+
+		vec4 clip = uViewProjection * vec4(corner, 1.0);
+
+		if (clip.w <= 0.0)
+		{
+			outsideFrustum = false;
+			return false;
+		}
+
+		vec3 ndc = clip.xyz / clip.w;
+		ndcMin = min(ndcMin, ndc);
+		ndcMax = max(ndcMax, ndc);
+	}
+
+	outsideFrustum = any(greaterThan(ndcMin, vec3(1.0))) || any(lessThan(ndcMax, vec3(-1.0)));
+
+	rect = clamp(vec4(ndcMin.xy, ndcMax.xy) * 0.5 + 0.5, vec4(0.0), vec4(1.0)) * uRenderScale.xyxy;
+	closestDepth = ndcMin.z * 0.5 + 0.5;
+
+	return true;
+}
+
+
+bool IsOccluded(vec4 rect, float closestDepth)
+{
+	vec2 sizeInTexels = (rect.zw - rect.xy) * uHiZSize;
+	float level = ceil(log2(max(max(sizeInTexels.x, sizeInTexels.y), 1.0)));
+	level = clamp(level, 0.0, float(uHiZMipCount - 1));
+
+	//At this level the rect covers at most 2x2 texels
+	ivec2 levelSize = textureSize(hiZ, int(level));
+	ivec2 minTexel = clamp(ivec2(rect.xy * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+	ivec2 maxTexel = clamp(ivec2(rect.zw * vec2(levelSize)), ivec2(0), levelSize - ivec2(1));
+
+	float farthest = max(max(texelFetch(hiZ, minTexel, int(level)).x, texelFetch(hiZ, ivec2(maxTexel.x, minTexel.y), int(level)).x),
+						 max(texelFetch(hiZ, ivec2(minTexel.x, maxTexel.y), int(level)).x, texelFetch(hiZ, maxTexel, int(level)).x));
+
+	return closestDepth > farthest;
+}
+
+
+void WriteInstanceCount(uint objectIdx, uint instanceCount)
+{
+	CullObject object = objects[objectIdx];
+
+	for (uint i = 0; i < object.drawCount; ++i)
+	{
+		if (uPhase == 1)
+			phaseOneCommands[object.firstDraw + i].instanceCount = instanceCount;
+		else
+			phaseTwoCommands[object.firstDraw + i].instanceCount = instanceCount;
+	}
+}
+
+
+void main()
+{
+	uint objectIdx = gl_GlobalInvocationID.x;
+
+	if (objectIdx >= uObjectCount)
+		return;
+
+	vec4 rect;
+	float closestDepth;
+	bool outsideFrustum;
+	bool projected = ProjectAABB(objects[objectIdx].aabbMin.xyz, objects[objectIdx].aabbMax.xyz, rect, closestDepth, outsideFrustum);
+
+	bool wasVisible = visibility[objectIdx] != 0u;
+
+	if (uPhase == 1)
+	{
+		WriteInstanceCount(objectIdx, (wasVisible && !outsideFrustum) ? 1u : 0u);
+		return;
+	}
+
+	bool drawnInPhaseOne = wasVisible && !outsideFrustum;
+	bool visible = !outsideFrustum && (!projected || !IsOccluded(rect, closestDepth));
+
+	WriteInstanceCount(objectIdx, (visible && !drawnInPhaseOne) ? 1u : 0u);
+	visibility[objectIdx] = visible ? 1u : 0u;
+
+	if (visible)
+		atomicAdd(visibleCount, 1u);
+	else if (outsideFrustum)
+		atomicAdd(frustumCulledCount, 1u);
+	else
+		atomicAdd(occludedCount, 1u);
+}
+
+#endif
+#endif
@@ -0,0 +1,193 @@
+#ifdef TEMPORAL_RESOLVE
+
+#if defined(COMPUTE) //////////////////////////////////////////////////
+
+//Runs at window resolution. Gathers the jittered samples of this frame around every output pixel,
+//clips the reprojected history to their neighborhood and blends both.
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+uniform sampler2D colorMap;
+uniform sampler2D velocityMap;
+uniform sampler2D depthMap;
+uniform sampler2D historyMap;
+
+uniform ivec2 uRenderSize;		//Region of the input maps rendered this frame
+uniform ivec2 uOutputSize;
+uniform vec2 uJitter;			//Input pixels
+uniform float uBlendFactor;
+uniform float uVarianceClip;
+uniform int uHistoryValid;
+
+uniform mat4 uInverseViewProjection;
+uniform mat4 uPrevViewProjection;
+
+layout (binding = 0, rgba16f) writeonly uniform image2D outputImage;
+
+
+vec3 RGBToYCoCg(vec3 color)
+{
+	return vec3(dot(color, vec3(0.25, 0.5, 0.25)), dot(color, vec3(0.5, 0.0, -0.5)), dot(color, vec3(-0.25, 0.5, -0.25)));
+}
+
+
+vec3 YCoCgToRGB(vec3 color)
+{
+	return vec3(color.x + color.y - color.z, color.x + color.z, color.x - color.y - color.z);
+}
+
+
+//Catmull-Rom filter with 5 bilinear taps, keeps the history sharp after many reprojections
+vec3 SampleHistory(vec2 uv)
+{
+	vec2 texSize = vec2(textureSize(historyMap, 0));
+	vec2 samplePos = uv * texSize;
+	vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+
+	vec2 f = samplePos - texPos1;
+
+	vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+	vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+	vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+	vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+	vec2 w12 = w1 + w2;
+	vec2 offset12 = w2 / w12;
+
+	vec2 texPos0 = (texPos1 - 1.0) / texSize;
+	vec2 texPos3 = (texPos1 + 2.0) / texSize;
+	vec2 texPos12 = (texPos1 + offset12) / texSize;
+
+	vec3 result = vec3(0.0);
+	result += textureLod(historyMap, vec2(texPos12.x, texPos0.y), 0.0).rgb * w12.x * w0.y;
+	result += textureLod(historyMap, vec2(texPos0.x, texPos12.y), 0.0).rgb * w0.x * w12.y;
+	result += textureLod(historyMap, vec2(texPos12.x, texPos12.y), 0.0).rgb * w12.x * w12.y;
+	result += textureLod(historyMap, vec2(texPos3.x, texPos12.y), 0.0).rgb * w3.x * w12.y;
+	result += textureLod(historyMap, vec2(texPos12.x, texPos3.y), 0.0).rgb * w12.x * w3.y;
+
+	float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+
+	return max(result / weight, vec3(0.0));
+}
+
+
+//Moves the history towards the center of the box until it is inside
+vec3 ClipToBox(vec3 history, vec3 boxMin, vec3 boxMax)
+{
+	vec3 center = 0.5 * (boxMax + boxMin);
+	vec3 extents = 0.5 * (boxMax - boxMin) + 0.0001;
+
+	vec3 offset = history - center;
+	vec3 units = abs(offset / extents);
+	float maxUnit = max(units.x, max(units.y, units.z));
+
+	if (maxUnit > 1.0)
+		return center + offset / maxUnit;
+
+	return history;
+}
+
+
+void main()
+{
+	ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+
+	if (coord.x >= uOutputSize.x || coord.y >= uOutputSize.y)
+		return;
+
+	vec2 uv = (vec2(coord) + 0.5) / vec2(uOutputSize);
+
+	//Position of the output pixel in the input, the samples of this frame are shifted by the jitter
+	vec2 inputPos = uv * vec2(uRenderSize);
+	ivec2 center = ivec2(floor(inputPos + uJitter));
+
+	vec3 colorSum = vec3(0.0);
+	float weightSum = 0.0;
+	float maxWeight = 0.0;
+
+	vec3 moment1 = vec3(0.0);
+	vec3 moment2 = vec3(0.0);
+	vec3 boxMin = vec3(1e20);
+	vec3 boxMax = vec3(-1e20);
+
+	float closestDepth = 1.0;
+	ivec2 closestCoord = center;
+
+	for (int y = -1; y <= 1; ++y)
+	{
+		for (int x = -1; x <= 1; ++x)
+		{
+			ivec2 sampleCoord = clamp(center + ivec2(x, y), ivec2(0), uRenderSize - ivec2(1));
+
+			vec3 color = RGBToYCoCg(texelFetch(colorMap, sampleCoord, 0).rgb);
+
+			//Blackman-Harris approximation over the distance to the real position of the sample
+			vec2 delta = vec2(sampleCoord) + 0.5 - uJitter - inputPos;
+			float weight = exp(-2.29 * dot(delta, delta));
+
+			//Weighted by the inverse luminance so bright samples don't dominate the edges
+			float toneWeight = weight / (1.0 + color.x);
+
+			colorSum += color * toneWeight;
+			weightSum += toneWeight;
+			maxWeight = max(maxWeight, weight);
+
+			moment1 += color;
+			moment2 += color * color;
+			boxMin = min(boxMin, color);
+			boxMax = max(boxMax, color);
+
+			//The motion of the closest surface keeps the edges of moving objects clean
+			float depth = texelFetch(depthMap, sampleCoord, 0).r;
+			if (depth < closestDepth)
+			{
+				closestDepth = depth;
+				closestCoord = sampleCoord;
+			}
+		}
+	}
+
+	vec3 current = colorSum / max(weightSum, 0.0001);
+
+	//Velocity, the background only moves with the camera
+	vec2 velocity;
+
+	if (closestDepth >= 1.0)
+	{
+		vec4 worldPos = uInverseViewProjection * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+		vec4 prevClip = uPrevViewProjection * vec4(worldPos.xyz / worldPos.w, 1.0);
+
+		velocity = uv - (prevClip.xy / prevClip.w * 0.5 + 0.5);
+	}
+	else
+		velocity = texelFetch(velocityMap, closestCoord, 0).xy;
+
+	vec2 prevUv = uv - velocity;
+
+	vec3 result = current;
+
+	if (uHistoryValid == 1 && all(greaterThanEqual(prevUv, vec2(0.0))) && all(lessThanEqual(prevUv, vec2(1.0))))
+	{
+		//Variance box around the mean, never bigger than the min max of the neighborhood
+		vec3 mean = moment1 / 9.0;
+		vec3 sigma = sqrt(max(moment2 / 9.0 - mean * mean, vec3(0.0)));
+
+		vec3 clipMin = max(boxMin, mean - sigma * uVarianceClip);
+		vec3 clipMax = min(boxMax, mean + sigma * uVarianceClip);
+
+		vec3 history = ClipToBox(RGBToYCoCg(SampleHistory(prevUv)), clipMin, clipMax);
+
+		//Output pixels far from any sample of this frame trust the history more
+		float blend = clamp(uBlendFactor * maxWeight, 0.0, 1.0);
+
+		float historyWeight = (1.0 - blend) / (1.0 + history.x);
+		float currentWeight = blend / (1.0 + current.x);
+
+		result = (history * historyWeight + current * currentWeight) / max(historyWeight + currentWeight, 0.0001);
+	}
+
+	imageStore(outputImage, coord, vec4(max(YCoCgToRGB(result), vec3(0.0)), 1.0));
+}
+
+#endif
+#endif
@@ -1,15 +1,17 @@
-#ifdef LIGHT_PASS
+#if defined(LIGHT_PASS) || defined(LOW_RES_LIGHT_PASS)
 
 #if defined(VERTEX) ///////////////////////////////////////////////////
 
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec2 aTexCoord;
 
+uniform vec2 uRenderScale;	//Fraction of the targets used by the internal resolution
+
 out vec2 vTexCoord;
 
 void main()
 {
-	vTexCoord = aTexCoord;
+	vTexCoord = aTexCoord * uRenderScale;
 
 	gl_Position = vec4(aPosition, 1.0);
 }
@@ -23,84 +25,123 @@ uniform sampler2D normals;
 uniform sampler2D worldPos;
 uniform sampler2D reflectivity;
 uniform samplerCube skyBox;
-uniform samplerCube irradianceMap;
 
-float specularStrength = 0.5;
+#include "Lighting.glsl"
 
-layout (location = 0) out vec4 color;
 
-struct Light
-{
-	unsigned int type;
-	float maxDistance;
-	vec3 color;
-	vec3 direction;
-	vec3 position;
-};
-
-layout (binding = 0, std140) uniform GlobalParams
+vec3 CalculateReflection(vec4 pos, vec4 normal)
 {
-	vec3 uCameraPosition;
-	unsigned int uLightCount;
+	vec3 viewDir = normalize(uCameraPosition - pos.xyz);
 
-	float uAmbientLightStrength;
-	vec3 uAmbientLightCol;
+	return texture(skyBox, reflect(-viewDir, normal.xyz)).rgb;
+}
 
-	Light uLight[16];
-};
 
+#if defined(LOW_RES_LIGHT_PASS)
 
-vec3 CalculateAmbientLight(vec4 pos, vec4 normal)
-{
-	vec3 viewDir = normalize(uCameraPosition - pos.xyz);
+uniform bool uComputeDiffuse;
+uniform bool uComputeAmbient;
+uniform bool uComputeReflection;
 
-	return texture(irradianceMap, reflect(-viewDir, normal.xyz)).rgb * uAmbientLightStrength;
-}
+layout (location = 0) out vec4 diffuseTerm;
+layout (location = 1) out vec4 ambientTerm;
+layout (location = 2) out vec4 reflectionTerm;
+layout (location = 3) out vec4 guide;	//Normal and distance to the camera, used to upsample the terms
 
 
-vec3 CalculateDiffuse(vec4 pos, vec4 normal)
+void main()
 {
-	vec3 col = vec3(0.0, 0.0, 0.0);
+	vec4 pos = texture(worldPos, vTexCoord);
+	vec4 normal = texture(normals, vTexCoord);
 
-	for(int i = 0; i < uLightCount; ++i)
+	diffuseTerm = vec4(0.0);
+	ambientTerm = vec4(0.0);
+	reflectionTerm = vec4(0.0);
+
+	if (pos.xyz == vec3(0.0) && normal.xyz == vec3(0.0))
 	{
-		vec3 viewDir = normalize(uCameraPosition - pos.xyz);
-		vec3 reflectDir;
+		guide = vec4(0.0);
+		return;
+	}
 
-		if (uLight[i].type == 0)
-		{
-			reflectDir = reflect(normalize(-uLight[i].direction), normal.xyz);
+	guide = vec4(normal.xyz, length(uCameraPosition - pos.xyz));
 
-			float diff = max(dot(normal.xyz, normalize(uLight[i].direction)), 0.0);
-			col += diff * uLight[i].color;
-		}
+	if (uComputeDiffuse)
+		diffuseTerm = vec4(CalculateDiffuse(pos.xyz, normal.xyz), 1.0);
 
+	if (uComputeAmbient)
+		ambientTerm = vec4(CalculateAmbientLight(pos.xyz, normal.xyz), 1.0);
 
-		else
-		{
-			vec3 dir = normalize(uLight[i].position - pos.xyz);
-			reflectDir = reflect(-dir, normal.xyz);
+	if (uComputeReflection)
+		reflectionTerm = vec4(CalculateReflection(pos, normal), 1.0);
+}
 
-			float diff = max(dot(normal.xyz, dir), 0.0);
-			float atenuation = 1.0 - smoothstep(0.0, uLight[i].maxDistance, length(uLight[i].position - pos.xyz));
-			col += diff * uLight[i].color * atenuation;
-		}
+#else
 
-		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
-		vec3 specular = specularStrength * spec * uLight[i].color;
+//Variants are compiled with LOW_RES_DIFFUSE, LOW_RES_AMBIENT and LOW_RES_REFLECTION
+//for the terms that come from a low resolution target
+#ifdef LOW_RES_DIFFUSE
+uniform sampler2D lowResDiffuse;
+uniform sampler2D diffuseGuide;
+#endif
 
-		col += specular;
-	}
+#ifdef LOW_RES_AMBIENT
+uniform sampler2D lowResAmbient;
+uniform sampler2D ambientGuide;
+#endif
 
-	return col;
-}
+#ifdef LOW_RES_REFLECTION
+uniform sampler2D lowResReflection;
+uniform sampler2D reflectionGuide;
+#endif
+
+layout (location = 0) out vec4 color;
 
 
-vec3 CalculateReflection(vec4 pos, vec4 normal)
+//Joint bilateral upsample: bilinear weights of the 4 closest low resolution texels,
+//rejecting the ones that lay on a different surface
+vec3 BilateralUpsample(sampler2D term, sampler2D termGuide, vec3 normal, float depth)
 {
-	vec3 viewDir = normalize(uCameraPosition - pos.xyz);
+	ivec2 lowResSize = textureSize(termGuide, 0);
+	vec2 lowResCoord = vTexCoord * vec2(lowResSize) - 0.5;
+	ivec2 base = ivec2(floor(lowResCoord));
+	vec2 f = fract(lowResCoord);
 
-	return texture(skyBox, reflect(-viewDir, normal.xyz)).rgb;
+	vec3 result = vec3(0.0);
+	float totalWeight = 0.0;
+
+	vec3 closest = vec3(0.0);
+	float closestDistance = 1e30;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 texel = clamp(base + offset, ivec2(0), lowResSize - 1);
+
+		vec4 texelGuide = texelFetch(termGuide, texel, 0);
+		vec3 value = texelFetch(term, texel, 0).rgb;
+
+		float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+		float depthWeight = exp(-abs(texelGuide.w - depth) / (depth * 0.05));
+		float normalWeight = pow(max(dot(texelGuide.xyz, normal), 0.0), 16.0);
+
+		float weight = bilinear * depthWeight * normalWeight;
+		result += value * weight;
+		totalWeight += weight;
+
+		float distance = abs(texelGuide.w - depth);
+		if (dot(texelGuide.xyz, texelGuide.xyz) > 0.0 && distance < closestDistance)
+		{
+			closest = value;
+			closestDistance = distance;
+		}
+	}
+
+	//No texel matches the surface (thin geometry), use the nearest one in depth
+	if (totalWeight < 0.0001)
+		return closest;
+
+	return result / totalWeight;
 }
 
 
@@ -118,14 +159,31 @@ void main()
 
 	else
 	{
-		vec3 ambient = CalculateAmbientLight(pos, normal);
-		vec3 diffuse = CalculateDiffuse(pos, normal);
+		float depth = length(uCameraPosition - pos.xyz);
+
+#ifdef LOW_RES_AMBIENT
+		vec3 ambient = BilateralUpsample(lowResAmbient, ambientGuide, normal.xyz, depth);
+#else
+		vec3 ambient = CalculateAmbientLight(pos.xyz, normal.xyz);
+#endif
+
+#ifdef LOW_RES_DIFFUSE
+		vec3 diffuse = BilateralUpsample(lowResDiffuse, diffuseGuide, normal.xyz, depth);
+#else
+		vec3 diffuse = CalculateDiffuse(pos.xyz, normal.xyz);
+#endif
+
+#ifdef LOW_RES_REFLECTION
+		vec3 reflection = BilateralUpsample(lowResReflection, reflectionGuide, normal.xyz, depth);
+#else
 		vec3 reflection = CalculateReflection(pos, normal);
+#endif
 
 		color = vec4((ambient + diffuse) * mix(texture(albedo, vTexCoord).xyz, reflection, reflectionValue), 1.0);		
 	}
 	
 }
 
+#endif
 #endif
 #endif
\ No newline at end of file
@@ -11,11 +11,17 @@ layout (binding = 1, std140) uniform LocalParams
 {
 	mat4 uWorldMatrix;
 	mat4 uWorldProjectionMatrix;
+
+	//Without jitter, for the velocity
+	mat4 uCurrentWorldProjectionMatrix;
+	mat4 uPrevWorldProjectionMatrix;
 };
 
 out vec2 vTexCoord;
 out vec3 vPosition;
 out vec3 vNormal;
+out vec4 vCurrentClip;
+out vec4 vPrevClip;
 
 void main()
 {
@@ -23,6 +29,9 @@ void main()
 	vPosition = vec3(uWorldMatrix * vec4(aPosition, 1.0)).xyz;
 	vNormal = normalize(uWorldMatrix * vec4(aNormal, 0.0)).xyz;
 
+	vCurrentClip = uCurrentWorldProjectionMatrix * vec4(aPosition, 1.0);
+	vPrevClip = uPrevWorldProjectionMatrix * vec4(aPosition, 1.0);
+
 	gl_Position = uWorldProjectionMatrix * vec4(aPosition, 1.0);
 }
 
@@ -31,6 +40,8 @@ void main()
 in vec2 vTexCoord;
 in vec3 vPosition;
 in vec3 vNormal;
+in vec4 vCurrentClip;
+in vec4 vPrevClip;
 
 uniform sampler2D uTexture;
 
@@ -45,6 +56,7 @@ layout (location = 0) out vec4 color;
 layout (location = 1) out vec4 normals;
 layout (location = 2) out vec4 worldPos;
 layout (location = 3) out float reflectiveTex;
+layout (location = 4) out vec2 velocity;
 
 
 void main()
@@ -53,6 +65,9 @@ void main()
 	normals = vec4(normalize(vNormal), 1.0);
 	worldPos = vec4(vPosition, 1.0);
 	reflectiveTex = reflectivity;
+
+	//Screen motion since last frame in uv units
+	velocity = (vCurrentClip.xy / vCurrentClip.w - vPrevClip.xy / vPrevClip.w) * 0.5;
 }
 
 #endif